@@ -11,6 +11,42 @@
 
 #include "NJU3711.h"
 
+// Layout budget: pins, data, flags and the four bus and test pattern timers
+// fit in 20 bytes plus the timers, on top of the packed queue and the
+// optional features compiled in. Checked on host builds too; there each
+// group of byte fields may be padded up to the next unsigned long.
+#if defined(__AVR__)
+#define NJU3711_PADDING_BYTES 0
+#else
+#define NJU3711_PADDING_BYTES (4 * (alignof(unsigned long) - 1))
+#endif
+#if NJU3711_ENABLE_LOAD_METER
+#define NJU3711_LOAD_METER_BYTES sizeof(NJU3711_LoadMeter)
+#else
+#define NJU3711_LOAD_METER_BYTES 0
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+#define NJU3711_SCRUBBER_BYTES ((NJU3711_ENABLE_STATISTICS ? 4 : 2) * sizeof(unsigned long))
+#else
+#define NJU3711_SCRUBBER_BYTES 0
+#endif
+#if NJU3711_ENABLE_STATISTICS
+#define NJU3711_STATISTICS_BYTES sizeof(unsigned long)
+#else
+#define NJU3711_STATISTICS_BYTES 0
+#endif
+#if NJU3711_ENABLE_DEADLINES
+#define NJU3711_DEADLINE_BYTES ((NJU3711_QUEUE_SIZE + 4) * sizeof(unsigned long) \
+                                + (NJU3711_QUEUE_SIZE + 7) / 8 + 2 + sizeof(unsigned long))
+#else
+#define NJU3711_DEADLINE_BYTES 0
+#endif
+static_assert(sizeof(NJU3711) <= 20 + 4 * sizeof(unsigned long)
+              + NJU3711_QUEUE_SIZE + (NJU3711_QUEUE_SIZE + 3) / 4
+              + NJU3711_LOAD_METER_BYTES + NJU3711_SCRUBBER_BYTES + NJU3711_DEADLINE_BYTES
+              + NJU3711_STATISTICS_BYTES + NJU3711_PADDING_BYTES,
+              "NJU3711 object layout grew");
+
 // Constructors
 NJU3711::NJU3711(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin, uint8_t clearPin) {
     _dataPin = dataPin;
@@ -18,15 +54,49 @@ NJU3711::NJU3711(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin, uint8_t c
     _strobePin = strobePin;
     _clearPin = clearPin;
     _currentData = 0;
+    _pendingData = 0;
+    _pendingShift = 0;
+    _shiftRegister = 0;
     _state = NJU3711_IDLE;
     _stepDelay = 1; // 1 microsecond default (well within 5MH spec)
     _clockState = false;
+    _pulseStep = false;
     _queueHead = 0;
-    _queueTail = 0;
     _queueSize = 0;
+#if NJU3711_ENABLE_STATISTICS
+    _queueOverflows = 0;
+#endif
+#if NJU3711_ENABLE_TEST_PATTERNS
+    _testPatternActive = false;
     _testPatternStep = 0;
     _testPatternType = 0;
     _testPatternDelay = 500000; // 500ms default
+    _testPatternLastStep = 0;
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    _scrubbing = false;
+    _shiftDirty = false;
+    _scrubInterval = 0;
+    _lastLatchTime = 0;
+#if NJU3711_ENABLE_STATISTICS
+    _scrubCount = 0;
+    _scrubAborts = 0;
+#endif
+#endif
+#if NJU3711_ENABLE_DEADLINES
+    for (uint8_t i = 0; i < sizeof(_queueTimed); i++) {
+        _queueTimed[i] = 0;
+    }
+    _activeTimed = false;
+    _measuring = false;
+    _stepMeasured = false;
+    _activeDeadline = 0;
+    _opStart = 0;
+    _stepTime = 16 * 5;     // Guess until the first write is measured
+    _deadlinesMet = 0;
+    _deadlineMisses = 0;
+    _deadlineRejects = 0;
+#endif
 }
 
 // Constructor for hardware-strapped CLR pin (always HIGH)
@@ -36,15 +106,49 @@ NJU3711::NJU3711(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin) {
     _strobePin = strobePin;
     _clearPin = 255; // Special value indicating CLR is hardware strapped
     _currentData = 0;
+    _pendingData = 0;
+    _pendingShift = 0;
+    _shiftRegister = 0;
     _state = NJU3711_IDLE;
     _stepDelay = 1; // 1 microsecond default (well within 5MH spec)
     _clockState = false;
+    _pulseStep = false;
     _queueHead = 0;
-    _queueTail = 0;
     _queueSize = 0;
+#if NJU3711_ENABLE_STATISTICS
+    _queueOverflows = 0;
+#endif
+#if NJU3711_ENABLE_TEST_PATTERNS
+    _testPatternActive = false;
     _testPatternStep = 0;
     _testPatternType = 0;
     _testPatternDelay = 500000; // 500ms default
+    _testPatternLastStep = 0;
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    _scrubbing = false;
+    _shiftDirty = false;
+    _scrubInterval = 0;
+    _lastLatchTime = 0;
+#if NJU3711_ENABLE_STATISTICS
+    _scrubCount = 0;
+    _scrubAborts = 0;
+#endif
+#endif
+#if NJU3711_ENABLE_DEADLINES
+    for (uint8_t i = 0; i < sizeof(_queueTimed); i++) {
+        _queueTimed[i] = 0;
+    }
+    _activeTimed = false;
+    _measuring = false;
+    _stepMeasured = false;
+    _activeDeadline = 0;
+    _opStart = 0;
+    _stepTime = 16 * 5;     // Guess until the first write is measured
+    _deadlinesMet = 0;
+    _deadlineMisses = 0;
+    _deadlineRejects = 0;
+#endif
 }
 
 // Initialie the NJU3711
@@ -67,6 +171,13 @@ void NJU3711::begin() {
     
     _lastUpdateTime = micros();
     _state = NJU3711_IDLE;
+#if NJU3711_ENABLE_SCRUBBER
+    _lastLatchTime = micros();
+#endif
+    
+#if NJU3711_ENABLE_LOAD_METER
+    _loadMeter.reset();
+#endif
     
     // Queue a clear operation to start clean
     clear();
@@ -74,22 +185,82 @@ void NJU3711::begin() {
 
 // Must be called regularly in main loop
 void NJU3711::update() {
+#if NJU3711_ENABLE_LOAD_METER
+    unsigned long loadStart = _loadMeter.beginCall();
+#endif
+    
     processStateMachine();
+    
+#if NJU3711_ENABLE_TEST_PATTERNS
+    if (_testPatternActive) {
+        processTestPattern();
+    }
+#endif
+    
+#if NJU3711_ENABLE_SCRUBBER
+    if (_scrubInterval != 0) {
+        processScrub();
+    }
+#endif
+    
+#if NJU3711_ENABLE_LOAD_METER
+    _loadMeter.endCall(NJU3711_LOAD_BUS, loadStart);
+#endif
 }
 
 // Check if device is busy
 bool NJU3711::isBusy() {
+#if NJU3711_ENABLE_TEST_PATTERNS
+    if (_testPatternActive) return true;
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    // A scrub gives way to any new operation, so it does not count
+    if (_scrubbing) return _queueSize > 0;
+#endif
     return (_state != NJU3711_IDLE) || (_queueSize > 0);
 }
 
+NJU3711_State NJU3711::getState() {
+    return _state;
+}
+
+// Time until the state machine or test pattern can take its next step
+unsigned long NJU3711::getTimeToNextEvent() {
+    unsigned long now = micros();
+    
+    if (_state != NJU3711_IDLE || _queueSize > 0) {
+        return remainingTime(_lastUpdateTime, _stepDelay, now);
+    }
+#if NJU3711_ENABLE_TEST_PATTERNS
+    if (_testPatternActive) {
+        return remainingTime(_testPatternLastStep, _testPatternDelay, now);
+    }
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    if (_scrubInterval != 0 && _shiftRegister == _currentData) {
+        return remainingTime(_lastLatchTime, _scrubInterval, now);
+    }
+#endif
+    return NJU3711_NO_EVENT;
+}
+
 // Set timing delay between operations
 void NJU3711::setStepDelay(unsigned long delayMicros) {
     _stepDelay = delayMicros;
 }
 
+unsigned long NJU3711::getStepDelay() {
+    return _stepDelay;
+}
+
 // Check if enough time has passed for next operation
 bool NJU3711::isTimingMet() {
-    return (micros() - _lastUpdateTime) >= _stepDelay;
+    unsigned long now = micros();
+    if ((now - _lastUpdateTime) < _stepDelay) return false;
+    // Idle past the delay: keep the stamp exactly one delay old, so it
+    // cannot wrap however long the bus stays idle before the next operation
+    if (_state == NJU3711_IDLE) _lastUpdateTime = now - _stepDelay;
+    return true;
 }
 
 // Update clock state
@@ -129,6 +300,10 @@ void NJU3711::processStateMachine() {
                 
                 if (_bitIndex < 0) {
                     // Finished shifting all bits
+                    _shiftRegister = _shiftData;
+#if NJU3711_ENABLE_SCRUBBER
+                    _shiftDirty = false;
+#endif
                     if (_currentOperation == NJU3711_OP_WRITE) {
                         _state = NJU3711_LATCHING;
                     } else {
@@ -141,15 +316,27 @@ void NJU3711::processStateMachine() {
         
         case NJU3711_LATCHING: {
             // Pulse STB low to latch data
-            static bool latchStep = false;
-            if (!latchStep) {
+            if (!_pulseStep) {
                 digitalWrite(_strobePin, LOW);
-                latchStep = true;
+                _pulseStep = true;
                 _lastUpdateTime = micros();
             } else {
                 digitalWrite(_strobePin, HIGH);
-                latchStep = false;
+                _pulseStep = false;
+                _currentData = _shiftRegister; // Outputs only change on the latch edge
                 _state = NJU3711_IDLE;
+#if NJU3711_ENABLE_DEADLINES
+                finishTimedWrite();
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+                _lastLatchTime = micros();
+                if (_scrubbing) {
+                    _scrubbing = false;
+#if NJU3711_ENABLE_STATISTICS
+                    _scrubCount++;
+#endif
+                }
+#endif
             }
             break;
         }
@@ -159,77 +346,116 @@ void NJU3711::processStateMachine() {
             // Software clear: Write 0x00 to all outputs
             if (_clearPin != 255) {
                 // Hardware clear available
-                static bool clearStep = false;
-                if (!clearStep) {
+                if (!_pulseStep) {
                     digitalWrite(_clearPin, LOW);
-                    clearStep = true;
+                    _pulseStep = true;
+                    _currentData = 0; // CLR is asynchronous - outputs clear on the falling edge
                     _lastUpdateTime = micros();
                 } else {
                     digitalWrite(_clearPin, HIGH);
-                    clearStep = false;
-                    _currentData = 0;
+                    _pulseStep = false;
                     _state = NJU3711_IDLE;
+#if NJU3711_ENABLE_SCRUBBER
+                    _lastLatchTime = micros();
+#endif
                 }
             } else {
                 // CLR pin strapped HIGH - use software clear (write 0x00)
-                // Redirect to write operation
-                if (enqueueOperation(NJU3711_OP_WRITE, 0x00)) {
-                    _currentData = 0;
-                }
-                _state = NJU3711_IDLE;
+                // Continue straight into a write so queue order is preserved
+                // and the outputs are only reported clear once latched
+                startOperation(NJU3711_OP_WRITE, 0x00);
             }
             break;
         }
         
-        case NJU3711_TEST_PATTERN: {
-            // Handle test patterns
-            if ((micros() - _lastUpdateTime) >= _testPatternDelay) {
-                switch (_testPatternType) {
-                    case 1: // All on/off alternating
-                        write(_testPatternStep ? 0xFF : 0x00);
-                        _testPatternStep = !_testPatternStep;
-                        break;
-                    case 2: // Alternating bits
-                        write(_testPatternStep ? 0xAA : 0x55);
-                        _testPatternStep = !_testPatternStep;
-                        break;
-                    case 3: // Walking bit
-                        write(1 << (_testPatternStep % 8));
-                        _testPatternStep++;
-                        break;
-                    case 4: // Binary counter
-                        write(_testPatternStep);
-                        _testPatternStep++;
-                        break;
-                }
-                _lastUpdateTime = micros();
-            }
+        case NJU3711_TEST_PATTERN:
+            // Test patterns are driven by processTestPattern()
+            _state = NJU3711_IDLE;
             break;
-        }
     }
 }
 
+#if NJU3711_ENABLE_TEST_PATTERNS
+// Queue the next test pattern step once the previous one has been latched
+void NJU3711::processTestPattern() {
+    if (_state != NJU3711_IDLE || _queueSize > 0) return;
+    if ((micros() - _testPatternLastStep) < _testPatternDelay) return;
+    
+    uint8_t patternData;
+    switch (_testPatternType) {
+        case 1: // All on/off alternating
+            patternData = _testPatternStep ? 0xFF : 0x00;
+            _testPatternStep = !_testPatternStep;
+            break;
+        case 2: // Alternating bits
+            patternData = _testPatternStep ? 0xAA : 0x55;
+            _testPatternStep = !_testPatternStep;
+            break;
+        case 3: // Walking bit
+            patternData = 1 << (_testPatternStep % 8);
+            _testPatternStep++;
+            break;
+        case 4: // Binary counter
+            patternData = _testPatternStep;
+            _testPatternStep++;
+            break;
+        default:
+            return;
+    }
+    
+    // Bypass write() so the pattern does not cancel itself
+    if (enqueueOperation(NJU3711_OP_WRITE, patternData)) {
+        _pendingData = patternData;
+        _pendingShift = patternData;
+    }
+    _testPatternLastStep = micros();
+}
+#endif
+
 // Queue management
 bool NJU3711::enqueueOperation(NJU3711_Operation op, uint8_t data) {
-    if (_queueSize >= 8) return false; // Queue full
+    if (_queueSize >= NJU3711_QUEUE_SIZE) {             // Queue full
+#if NJU3711_ENABLE_STATISTICS
+        _queueOverflows++;
+#endif
+        return false;
+    }
+    if (op > NJU3711_OP_CLEAR) return false;            // Not encodable in 2 bits
     
-    _operationQueue[_queueTail].operation = op;
-    _operationQueue[_queueTail].data = data;
-    _operationQueue[_queueTail].valid = true;
+    uint8_t slot = (_queueHead + _queueSize) % NJU3711_QUEUE_SIZE;
+    uint8_t shift = (slot & 0x03) * 2;
+    _queueData[slot] = data;
+    _queueOps[slot >> 2] = (_queueOps[slot >> 2] & ~(0x03 << shift)) | (op << shift);
+#if NJU3711_ENABLE_DEADLINES
+    _queueTimed[slot >> 3] &= ~(1 << (slot & 0x07));
+#endif
     
-    _queueTail = (_queueTail + 1) % 8;
     _queueSize++;
+    
+#if NJU3711_ENABLE_SCRUBBER
+    // Never make a new operation wait behind a scrub that can still be dropped
+    if (_scrubbing && _state == NJU3711_SHIFTING) {
+        abortScrub();
+    }
+#endif
     return true;
 }
 
 bool NJU3711::dequeueOperation(NJU3711_Operation& op, uint8_t& data) {
     if (_queueSize == 0) return false;
     
-    op = _operationQueue[_queueHead].operation;
-    data = _operationQueue[_queueHead].data;
-    _operationQueue[_queueHead].valid = false;
+    uint8_t shift = (_queueHead & 0x03) * 2;
+    op = (NJU3711_Operation)((_queueOps[_queueHead >> 2] >> shift) & 0x03);
+    data = _queueData[_queueHead];
+#if NJU3711_ENABLE_DEADLINES
+    // Untimed slots never had a deadline stored
+    _activeTimed = isQueuedTimed(0);
+    _activeDeadline = _activeTimed ? _queueDeadline[_queueHead] : 0;
+    _measuring = (op == NJU3711_OP_WRITE);
+    _opStart = micros();
+#endif
     
-    _queueHead = (_queueHead + 1) % 8;
+    _queueHead = (_queueHead + 1) % NJU3711_QUEUE_SIZE;
     _queueSize--;
     return true;
 }
@@ -241,13 +467,20 @@ void NJU3711::startOperation(NJU3711_Operation op, uint8_t data) {
         case NJU3711_OP_WRITE:
         case NJU3711_OP_SHIFT_ONLY:
             _shiftData = data;
-            _currentData = data;
             _bitIndex = 7;
             _state = NJU3711_SHIFTING;
             digitalWrite(_strobePin, HIGH); // Ensure STB is high for shifting
             break;
             
         case NJU3711_OP_LATCH_ONLY:
+#if NJU3711_ENABLE_SCRUBBER
+            if (_shiftDirty) {
+                // An aborted scrub left partial data in the shift register,
+                // shift the expected contents in again before latching
+                startOperation(NJU3711_OP_WRITE, _shiftRegister);
+                break;
+            }
+#endif
             _state = NJU3711_LATCHING;
             break;
             
@@ -259,47 +492,241 @@ void NJU3711::startOperation(NJU3711_Operation op, uint8_t data) {
 
 // Public interface methods
 bool NJU3711::write(uint8_t data) {
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    return enqueueOperation(NJU3711_OP_WRITE, data);
+    stopTestPattern();
+    if (!enqueueOperation(NJU3711_OP_WRITE, data)) return false;
+    _pendingData = data;
+    _pendingShift = data;
+    return true;
 }
 
 bool NJU3711::writeImmediate(uint8_t data) {
     return write(data);
 }
 
+#if NJU3711_ENABLE_DEADLINES
+bool NJU3711::write(uint8_t data, unsigned long deadlineMicros) {
+    stopTestPattern();
+    return enqueueTimed(data, micros() + deadlineMicros);
+}
+
+// Earliest deadline first among timed writes. Untimed operations keep
+// their FIFO position and act as barriers, so shift/latch pairs and
+// clears are never split or overtaken.
+bool NJU3711::enqueueTimed(uint8_t data, unsigned long deadline) {
+    if (_queueSize >= NJU3711_QUEUE_SIZE) {
+#if NJU3711_ENABLE_STATISTICS
+        _queueOverflows++;
+#endif
+        return false;
+    }
+    
+#if NJU3711_ENABLE_SCRUBBER
+    if (_scrubbing && _state == NJU3711_SHIFTING) {
+        abortScrub();
+    }
+#endif
+    
+    // Behind every untimed operation and every timed write due no later
+    uint8_t position = _queueSize;
+    while (position > 0) {
+        uint8_t slot = (_queueHead + position - 1) % NJU3711_QUEUE_SIZE;
+        if (!isQueuedTimed(position - 1) || (long)(_queueDeadline[slot] - deadline) <= 0) break;
+        position--;
+    }
+    
+    // Admission: the new write must make its deadline, and so must every
+    // timed write it pushes back
+    unsigned long now = micros();
+    unsigned long steps = remainingSteps();
+    for (uint8_t i = 0; i < position; i++) {
+        steps += stepsFor(queuedOperation(i));
+    }
+    steps += stepsFor(NJU3711_OP_WRITE);
+    if ((long)(now + stepsToMicros(steps) - deadline) > 0) {
+        _deadlineRejects++;
+        return false;
+    }
+    for (uint8_t i = position; i < _queueSize; i++) {
+        steps += stepsFor(queuedOperation(i));
+        uint8_t slot = (_queueHead + i) % NJU3711_QUEUE_SIZE;
+        if (isQueuedTimed(i) && (long)(now + stepsToMicros(steps) - _queueDeadline[slot]) > 0) {
+            _deadlineRejects++;
+            return false;
+        }
+    }
+    
+    // Open a gap at 'position' by moving the later entries back one slot
+    for (uint8_t i = _queueSize; i > position; i--) {
+        uint8_t to = (_queueHead + i) % NJU3711_QUEUE_SIZE;
+        uint8_t from = (_queueHead + i - 1) % NJU3711_QUEUE_SIZE;
+        uint8_t toShift = (to & 0x03) * 2;
+        _queueData[to] = _queueData[from];
+        _queueOps[to >> 2] = (_queueOps[to >> 2] & ~(0x03 << toShift)) | (queuedOperation(i - 1) << toShift);
+        _queueDeadline[to] = _queueDeadline[from];
+        if (isQueuedTimed(i - 1)) {
+            _queueTimed[to >> 3] |= (1 << (to & 0x07));
+        } else {
+            _queueTimed[to >> 3] &= ~(1 << (to & 0x07));
+        }
+    }
+    
+    uint8_t slot = (_queueHead + position) % NJU3711_QUEUE_SIZE;
+    uint8_t shift = (slot & 0x03) * 2;
+    _queueData[slot] = data;
+    _queueOps[slot >> 2] = (_queueOps[slot >> 2] & ~(0x03 << shift)) | (NJU3711_OP_WRITE << shift);
+    _queueDeadline[slot] = deadline;
+    _queueTimed[slot >> 3] |= (1 << (slot & 0x07));
+    _queueSize++;
+    
+    // A write that overtook others is overwritten by them, so the final
+    // output only changes if it went to the end
+    if (position == _queueSize - 1) {
+        _pendingData = data;
+        _pendingShift = data;
+    }
+    return true;
+}
+
+NJU3711_Operation NJU3711::queuedOperation(uint8_t index) {
+    uint8_t slot = (_queueHead + index) % NJU3711_QUEUE_SIZE;
+    return (NJU3711_Operation)((_queueOps[slot >> 2] >> ((slot & 0x03) * 2)) & 0x03);
+}
+
+bool NJU3711::isQueuedTimed(uint8_t index) {
+    uint8_t slot = (_queueHead + index) % NJU3711_QUEUE_SIZE;
+    return (_queueTimed[slot >> 3] >> (slot & 0x07)) & 0x01;
+}
+
+// State machine steps from dequeue to completion: one to start, two per
+// bit, two per STB or CLR pulse
+uint8_t NJU3711::stepsFor(NJU3711_Operation op) {
+    switch (op) {
+        case NJU3711_OP_WRITE:      return 19;
+        case NJU3711_OP_SHIFT_ONLY: return 17;
+        case NJU3711_OP_LATCH_ONLY: return 3;
+        case NJU3711_OP_CLEAR:      return (_clearPin != 255) ? 3 : 20;
+        default:                    return 0;
+    }
+}
+
+// Steps left of the running operation
+uint16_t NJU3711::remainingSteps() {
+    switch (_state) {
+        case NJU3711_SHIFTING: {
+            uint16_t steps = (_bitIndex + 1) * 2 - (_clockState ? 1 : 0);
+            if (_currentOperation == NJU3711_OP_WRITE) steps += 2;
+            return steps;
+        }
+        case NJU3711_LATCHING:
+            return _pulseStep ? 1 : 2;
+        case NJU3711_CLEARING:
+            if (_clearPin == 255) return stepsFor(NJU3711_OP_WRITE);
+            return _pulseStep ? 1 : 2;
+        default:
+            return 0;
+    }
+}
+
+unsigned long NJU3711::stepsToMicros(unsigned long steps) {
+    return (steps * _stepTime + 15) >> 4;
+}
+
+// A write has latched: score its deadline and refine the step time from
+// how long its 18 steps after the start really took
+void NJU3711::finishTimedWrite() {
+    if (_activeTimed) {
+        if ((long)(micros() - _activeDeadline) > 0) {
+            _deadlineMisses++;
+        } else {
+            _deadlinesMet++;
+        }
+        _activeTimed = false;
+    }
+    
+    if (_measuring) {
+        // Long step delays make the write take far more than 16 bits of
+        // microseconds; anything over the 16-bit step time clamps anyway
+        unsigned long elapsed = micros() - _opStart;
+        if (elapsed > 0x1FFFFUL) elapsed = 0x1FFFFUL;
+        uint32_t sample = (uint32_t)(elapsed << 4) / 18;
+        if (sample > 0xFFFF) sample = 0xFFFF;
+        if (_stepMeasured) {
+            _stepTime = (uint16_t)(_stepTime + ((long)sample - (long)_stepTime) / 4);
+        } else {
+            _stepTime = (uint16_t)sample;
+            _stepMeasured = true;
+        }
+        _measuring = false;
+    }
+}
+
+unsigned long NJU3711::getDeadlinesMet() {
+    return _deadlinesMet;
+}
+
+unsigned long NJU3711::getDeadlineMisses() {
+    return _deadlineMisses;
+}
+
+unsigned long NJU3711::getDeadlineRejects() {
+    return _deadlineRejects;
+}
+
+unsigned long NJU3711::getEstimatedLatency() {
+    unsigned long steps = remainingSteps();
+    for (uint8_t i = 0; i < _queueSize; i++) {
+        steps += stepsFor(queuedOperation(i));
+    }
+    return stepsToMicros(steps + stepsFor(NJU3711_OP_WRITE));
+}
+
+unsigned long NJU3711::getStepTime() {
+    return _stepTime;
+}
+#endif
+
 bool NJU3711::shift(uint8_t data) {
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    return enqueueOperation(NJU3711_OP_SHIFT_ONLY, data);
+    stopTestPattern();
+    if (!enqueueOperation(NJU3711_OP_SHIFT_ONLY, data)) return false;
+    _pendingShift = data;
+    return true;
 }
 
 bool NJU3711::latch() {
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    return enqueueOperation(NJU3711_OP_LATCH_ONLY);
+    stopTestPattern();
+    if (!enqueueOperation(NJU3711_OP_LATCH_ONLY)) return false;
+    _pendingData = _pendingShift;
+    return true;
 }
 
 bool NJU3711::clear() {
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    return enqueueOperation(NJU3711_OP_CLEAR);
+    stopTestPattern();
+    if (!enqueueOperation(NJU3711_OP_CLEAR)) return false;
+    _pendingData = 0;
+    if (_clearPin == 255) {
+        _pendingShift = 0; // Software clear shifts 0x00 through the register
+    }
+    return true;
 }
 
 bool NJU3711::setBit(uint8_t bitPosition) {
     if (bitPosition > 7) return false;
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    uint8_t newData = _currentData | (1 << bitPosition);
+    stopTestPattern();
+    uint8_t newData = _pendingData | (1 << bitPosition); // Build on queued writes, not just latched data
     return write(newData);
 }
 
 bool NJU3711::clearBit(uint8_t bitPosition) {
     if (bitPosition > 7) return false;
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    uint8_t newData = _currentData & ~(1 << bitPosition);
+    stopTestPattern();
+    uint8_t newData = _pendingData & ~(1 << bitPosition);
     return write(newData);
 }
 
 bool NJU3711::toggleBit(uint8_t bitPosition) {
     if (bitPosition > 7) return false;
-    if (_state == NJU3711_TEST_PATTERN) stopTestPattern();
-    uint8_t newData = _currentData ^ (1 << bitPosition);
+    stopTestPattern();
+    uint8_t newData = _pendingData ^ (1 << bitPosition);
     return write(newData);
 }
 
@@ -315,32 +742,102 @@ uint8_t NJU3711::getCurrentData() {
     return _currentData;
 }
 
+#if NJU3711_ENABLE_TEST_PATTERNS
 bool NJU3711::startTestPattern(uint8_t patternType, unsigned long patternDelay) {
     if (isBusy()) return false;
+    // An unknown type would never step, leaving its deadline overdue forever
+    if (patternType < 1 || patternType > 4) return false;
     
     _testPatternType = patternType;
     _testPatternDelay = patternDelay;
     _testPatternStep = 0;
-    _state = NJU3711_TEST_PATTERN;
-    _lastUpdateTime = micros();
+    _testPatternActive = true;
+    _testPatternLastStep = micros() - patternDelay; // First step is queued immediately
     return true;
 }
 
 void NJU3711::stopTestPattern() {
-    if (_state == NJU3711_TEST_PATTERN) {
-        _state = NJU3711_IDLE;
-    }
+    _testPatternActive = false;
+}
+#endif
+
+#if NJU3711_ENABLE_SCRUBBER
+// Re-latch the outputs once the bus has been idle for the scrub interval.
+// Skipped while the shift register holds data that has not been latched.
+void NJU3711::processScrub() {
+    if (_state != NJU3711_IDLE || _queueSize > 0) return;
+#if NJU3711_ENABLE_TEST_PATTERNS
+    if (_testPatternActive) return;
+#endif
+    if (_shiftRegister != _currentData) return;
+    if ((micros() - _lastLatchTime) < _scrubInterval) return;
+    
+    _scrubbing = true;
+    startOperation(NJU3711_OP_WRITE, _currentData);
 }
 
+// Drop a scrub that is still shifting. Nothing has been latched, so the
+// outputs keep their value.
+void NJU3711::abortScrub() {
+    updateClock(false);
+    _scrubbing = false;
+    _shiftDirty = true;
+    _state = NJU3711_IDLE;
+#if NJU3711_ENABLE_STATISTICS
+    _scrubAborts++;
+#endif
+}
+
+void NJU3711::setScrubInterval(unsigned long intervalMicros) {
+    _scrubInterval = intervalMicros;
+}
+
+unsigned long NJU3711::getScrubInterval() {
+    return _scrubInterval;
+}
+
+bool NJU3711::isScrubbing() {
+    return _scrubbing;
+}
+
+#if NJU3711_ENABLE_STATISTICS
+unsigned long NJU3711::getScrubCount() {
+    return _scrubCount;
+}
+
+unsigned long NJU3711::getScrubAbortCount() {
+    return _scrubAborts;
+}
+#endif
+#endif
+
 uint8_t NJU3711::getQueueSize() {
     return _queueSize;
 }
 
+#if NJU3711_ENABLE_STATISTICS
+unsigned long NJU3711::getQueueOverflows() {
+    return _queueOverflows;
+}
+#endif
+
 void NJU3711::clearQueue() {
     _queueHead = 0;
-    _queueTail = 0;
     _queueSize = 0;
-    for (int i = 0; i < 8; i++) {
-        _operationQueue[i].valid = false;
+    
+    // Cancelled operations will never reach the device
+    if (_state == NJU3711_SHIFTING) {
+        _pendingShift = _shiftData;
+        _pendingData = (_currentOperation == NJU3711_OP_WRITE) ? _shiftData : _currentData;
+    } else if (_state == NJU3711_LATCHING) {
+        _pendingShift = _shiftRegister;
+        _pendingData = _shiftRegister;
+    } else if (_state == NJU3711_CLEARING) {
+        // A software clear still shifts 0x00 through the register
+        _pendingShift = (_clearPin == 255) ? 0 : _shiftRegister;
+        _pendingData = 0;
+    } else {
+        _pendingShift = _shiftRegister;
+        _pendingData = _currentData;
     }
 }
\ No newline at end of file
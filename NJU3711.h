@@ -13,18 +13,26 @@
 #define NJU3711_H
 
 #include <Arduino.h>
+#include "NJU3711_Config.h"
+
+#if NJU3711_ENABLE_LOAD_METER
+#include "NJU3711_LoadMeter.h"
+#endif
+
+// Returned by getTimeToNextEvent() when update() has nothing scheduled
+#define NJU3711_NO_EVENT 0xFFFFFFFFUL
 
 // Operation states for the state machine
-enum NJU3711_State {
+enum NJU3711_State : uint8_t {
     NJU3711_IDLE,
     NJU3711_SHIFTING,
     NJU3711_LATCHING,
     NJU3711_CLEARING,
-    NJU3711_TEST_PATTERN
+    NJU3711_TEST_PATTERN    // Unused: test patterns now run alongside the bus (see _testPatternActive)
 };
 
-// Operation types
-enum NJU3711_Operation {
+// Operation types (the first four fit the 2-bit queue encoding)
+enum NJU3711_Operation : uint8_t {
     NJU3711_OP_WRITE,
     NJU3711_OP_SHIFT_ONLY,
     NJU3711_OP_LATCH_ONLY,
@@ -38,31 +46,74 @@ private:
     uint8_t _clockPin;      // CLK pin
     uint8_t _strobePin;     // STB pin
     uint8_t _clearPin;      // CLR pin (255 if hardware strapped HIGH)
-    uint8_t _currentData;   // Current data stored in the device
+    uint8_t _currentData;   // Data currently held in the output latches
+    uint8_t _pendingData;   // Data the outputs will hold once the queue drains
+    uint8_t _pendingShift;  // Data the shift register will hold once the queue drains
+    uint8_t _shiftRegister; // Data currently held in the shift register
     
     // State machine variables
     NJU3711_State _state;
     NJU3711_Operation _currentOperation;
     uint8_t _shiftData;     // Data being shifted
     int8_t _bitIndex;       // Current bit being shifted (7 to 0)
-    unsigned long _lastUpdateTime;
-    unsigned long _stepDelay;   // Minimum delay between steps (microseconds)
-    bool _clockState;       // Current clock state
+    unsigned long _lastUpdateTime;  // micros() of the last step (re-armed while idle)
+    unsigned long _stepDelay;       // Minimum delay between steps (microseconds)
+    bool _clockState : 1;       // Current clock state
+    bool _pulseStep : 1;        // Second half of a STB/CLR pulse pending
+#if NJU3711_ENABLE_TEST_PATTERNS
+    bool _testPatternActive : 1;
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    bool _scrubbing : 1;        // Current operation is a scrub (gives way to new operations)
+    bool _shiftDirty : 1;       // Aborted scrub left partial data in the shift register
+#endif
+#if NJU3711_ENABLE_DEADLINES
+    bool _activeTimed : 1;      // Running operation has a deadline
+    bool _measuring : 1;        // Running operation is a write being timed
+    bool _stepMeasured : 1;     // _stepTime holds a measurement, not the initial guess
+#endif
     
+#if NJU3711_ENABLE_TEST_PATTERNS
     // Test pattern variables
     uint8_t _testPatternStep;
     uint8_t _testPatternType;
     unsigned long _testPatternDelay;
+    unsigned long _testPatternLastStep;
+#endif
+    
+#if NJU3711_ENABLE_SCRUBBER
+    // Scrubber variables
+    unsigned long _scrubInterval;   // 0 = off (microseconds)
+    unsigned long _lastLatchTime;   // Last time the outputs were latched or cleared
+#if NJU3711_ENABLE_STATISTICS
+    unsigned long _scrubCount;
+    unsigned long _scrubAborts;
+#endif
+#endif
     
-    // Queue for operations
-    struct OperationQueue {
-        NJU3711_Operation operation;
-        uint8_t data;
-        bool valid;
-    } _operationQueue[8];  // Small queue for operations
+    // Queue for operations - data bytes plus 2-bit operation codes packed
+    // four to a byte. The tail is derived from head + size.
+    uint8_t _queueData[NJU3711_QUEUE_SIZE];
+    uint8_t _queueOps[(NJU3711_QUEUE_SIZE + 3) / 4];
     uint8_t _queueHead;
-    uint8_t _queueTail;
     uint8_t _queueSize;
+#if NJU3711_ENABLE_STATISTICS
+    unsigned long _queueOverflows;  // Operations refused because the queue was full
+#endif
+    
+#if NJU3711_ENABLE_DEADLINES
+    // Deadlines of queued operations (absolute micros()), valid where the
+    // slot's bit in _queueTimed is set. Timed writes are kept in deadline
+    // order between untimed operations.
+    unsigned long _queueDeadline[NJU3711_QUEUE_SIZE];
+    uint8_t _queueTimed[(NJU3711_QUEUE_SIZE + 7) / 8];
+    unsigned long _activeDeadline;
+    unsigned long _opStart;     // micros() when the measured write started
+    uint16_t _stepTime;         // Measured time per state machine step (1/16 microseconds)
+    unsigned long _deadlinesMet;
+    unsigned long _deadlineMisses;
+    unsigned long _deadlineRejects;
+#endif
     
     // Internal methods
     void processStateMachine();
@@ -71,6 +122,39 @@ private:
     void startOperation(NJU3711_Operation op, uint8_t data = 0);
     bool isTimingMet();
     void updateClock(bool state);
+#if NJU3711_ENABLE_TEST_PATTERNS
+    void processTestPattern();
+#endif
+#if NJU3711_ENABLE_SCRUBBER
+    void processScrub();
+    void abortScrub();
+#endif
+#if NJU3711_ENABLE_DEADLINES
+    bool enqueueTimed(uint8_t data, unsigned long deadline);
+    NJU3711_Operation queuedOperation(uint8_t index);
+    bool isQueuedTimed(uint8_t index);
+    uint8_t stepsFor(NJU3711_Operation op);
+    uint16_t remainingSteps();
+    unsigned long stepsToMicros(unsigned long steps);
+    void finishTimedWrite();
+#endif
+
+protected:
+    // Microseconds left of 'interval' that started at 'since' (0 if expired)
+    static unsigned long remainingTime(unsigned long since, unsigned long interval, unsigned long now) {
+        unsigned long elapsed = now - since;
+        return (elapsed >= interval) ? 0 : (interval - elapsed);
+    }
+    
+    // Same for 16-bit timestamps (low 16 bits of micros(), intervals < 65536us)
+    static uint16_t remainingTime16(uint16_t since, uint16_t interval, uint16_t now) {
+        uint16_t elapsed = now - since;
+        return (elapsed >= interval) ? 0 : (interval - elapsed);
+    }
+    
+#if NJU3711_ENABLE_LOAD_METER
+    NJU3711_LoadMeter _loadMeter;   // Shared by the whole update() hierarchy
+#endif
 
 public:
     // Constructors
@@ -86,9 +170,21 @@ public:
     // Check if device is busy
     bool isBusy();
     
+    // Current step of the bus state machine
+    NJU3711_State getState();
+    
+    // Microseconds until update() next has work (NJU3711_NO_EVENT if none)
+    unsigned long getTimeToNextEvent();
+    
     // Non-blocking write operations (return false if busy, true if queued)
     bool write(uint8_t data);
     bool writeImmediate(uint8_t data);
+#if NJU3711_ENABLE_DEADLINES
+    // Write that must latch within deadlineMicros from now. Returns false
+    // if the estimate says it cannot, or if it would make a queued timed
+    // write late. Runs ahead of queued timed writes with later deadlines.
+    bool write(uint8_t data, unsigned long deadlineMicros);
+#endif
     
     // Non-blocking bit operations
     bool setBit(uint8_t bitPosition);
@@ -101,19 +197,53 @@ public:
     bool latch();               // Latch current register
     bool clear();               // Software clear (writes 0x00) - hardware clear not available if CLR strapped
     
-    // Get current data value (immediate)
+    // Get data value currently latched on the outputs (immediate)
     uint8_t getCurrentData();
     
     // Non-blocking test patterns
+#if NJU3711_ENABLE_TEST_PATTERNS
     bool startTestPattern(uint8_t patternType, unsigned long patternDelay = 500000); // delay in microseconds
     void stopTestPattern();
+#else
+    void stopTestPattern() {}
+#endif
     
-    // Set timing (microseconds between operations)
+    // Set timing (microseconds between operations, max 65535)
     void setStepDelay(unsigned long delayMicros);
+    unsigned long getStepDelay();
     
     // Queue management
     uint8_t getQueueSize();
     void clearQueue();
+#if NJU3711_ENABLE_STATISTICS
+    unsigned long getQueueOverflows();      // Operations refused because the queue was full
+#endif
+    
+#if NJU3711_ENABLE_SCRUBBER
+    // Re-latch the current outputs after this long without a latch
+    // (microseconds, 0 = off). Scrubs only use idle bus time.
+    void setScrubInterval(unsigned long intervalMicros);
+    unsigned long getScrubInterval();
+    bool isScrubbing();
+#if NJU3711_ENABLE_STATISTICS
+    unsigned long getScrubCount();          // Scrubs latched
+    unsigned long getScrubAbortCount();     // Scrubs abandoned for a new operation
+#endif
+#endif
+    
+#if NJU3711_ENABLE_DEADLINES
+    // Deadline statistics and the completion estimate
+    unsigned long getDeadlinesMet();        // Timed writes latched in time
+    unsigned long getDeadlineMisses();      // Timed writes latched late
+    unsigned long getDeadlineRejects();     // Timed writes refused by admission control
+    unsigned long getEstimatedLatency();    // Microseconds until a write queued now would latch
+    unsigned long getStepTime();            // Measured time per bus step (1/16 microseconds)
+#endif
+    
+#if NJU3711_ENABLE_LOAD_METER
+    // CPU load of update() (see NJU3711_LoadMeter.h)
+    NJU3711_LoadMeter& getLoadMeter() { return _loadMeter; }
+#endif
 };
 
 #endif // NJU3711_H
\ No newline at end of file
@@ -40,50 +40,22 @@
 #define NJU3711_7SEGMENT_H
 
 #include "NJU3711.h"
-
-// Segment bit positions (matches your specific pin mapping)
-#define SEG_A   7  // P8
-#define SEG_B   5  // P6
-#define SEG_C   2  // P3
-#define SEG_D   1  // P2
-#define SEG_E   3  // P4
-#define SEG_F   6  // P7
-#define SEG_G   4  // P5
-#define SEG_DP  0  // P1
-
-// Display modes
-enum DisplayMode {
-    ACTIVE_LOW,        // LEDs light when output is LOW (your case)
-    ACTIVE_HIGH        // LEDs light when output is HIGH
-};
-
-// Animation types for effects
-enum AnimationType {
-    ANIM_ROTATE_CW,     // Clockwise rotation
-    ANIM_ROTATE_CCW,    // Counter-clockwise rotation
-    ANIM_BLINK,         // Blinking digit
-    ANIM_FADE,          // Fade in/out effect
-    ANIM_CHASE,         // Chase segments
-    ANIM_LOADING        // Loading bar effect
-};
+#include "NJU3711_Font.h"
+#include "NJU3711_Animator.h"
 
 class NJU3711_7Segment : public NJU3711 {
 
 private:
     DisplayMode _displayMode;
     bool _decimalPointState;
-    uint8_t _brightness;        // For future PWM brightness control
     
-    // Animation state variables
-    bool _animationActive;
-    AnimationType _currentAnimation;
-    unsigned long _animationDelay;
-    unsigned long _lastAnimationUpdate;
-    uint8_t _animationStep;
-    uint8_t _animationValue;    // Current displayed value during animation
+#if NJU3711_ENABLE_ANIMATIONS
+    // Animation state (shared engine, frames are written to this device)
+    NJU3711_Animator _animator;
     
     // Internal helper methods
     void processAnimation();
+#endif
 
 protected:
     // Helper methods that derived classes can use
@@ -103,6 +75,9 @@ public:
     // Update method to handle animations (calls parent update + animation processing)
     void update();
     
+    // Microseconds until update() next has work, including animations
+    unsigned long getTimeToNextEvent();
+    
     // Basic display functions
     bool displayDigit(uint8_t digit, bool showDP = false);
     bool displayHex(uint8_t hexValue, bool showDP = false);
@@ -135,6 +110,7 @@ public:
     bool displayNumber(int number, unsigned long digitDelay = 300000);    // Display multi-digit number
     
     // Animation functions
+#if NJU3711_ENABLE_ANIMATIONS
     bool startAnimation(AnimationType type, unsigned long animDelay = 100000);
     void stopAnimation();
     bool isAnimating();
@@ -143,6 +119,10 @@ public:
     bool test();                   // Run test pattern
     bool countdown(uint8_t from, uint8_t to = 0, unsigned long stepDelay = 1000000);
     bool countup(uint8_t from = 0, uint8_t to = 9, unsigned long stepDelay = 1000000);
+#else
+    void stopAnimation() {}
+    bool isAnimating() { return false; }
+#endif
     
     // Error display
     bool displayError();           // Display "E" for error
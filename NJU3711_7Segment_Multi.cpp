@@ -10,6 +10,21 @@
 
 #include "NJU3711_7Segment_Multi.h"
 
+#if NJU3711_ENABLE_DIMMING
+// Whether analogWrite() gives a hardware PWM output on a pin
+#if defined(__AVR__)
+#define NJU3711_PIN_HAS_PWM(pin) (digitalPinToTimer(pin) != NOT_ON_TIMER)
+#elif defined(digitalPinHasPWM)
+#define NJU3711_PIN_HAS_PWM(pin) digitalPinHasPWM(pin)
+#else
+// Unknown core - dim in software rather than PWM a pin that has none
+#define NJU3711_PIN_HAS_PWM(pin) (false)
+#endif
+#endif
+
+// Frames are copied on every publish, keep them at one byte per field
+static_assert(sizeof(NJU3711_Frame) == 5, "NJU3711_Frame must stay 5 bytes");
+
 // Constructor for 3-digit display
 NJU3711_7Segment_Multi::NJU3711_7Segment_Multi(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin,
                                                uint8_t digit1Pin, uint8_t digit2Pin, uint8_t digit3Pin,
@@ -24,21 +39,77 @@ NJU3711_7Segment_Multi::NJU3711_7Segment_Multi(uint8_t dataPin, uint8_t clockPin
     _mplexState = MPLEX_IDLE;
     _currentDigit = 0;
     _nextDigit = 0;
+    _frameCount = 0;
     _lastMultiplexTime = 0;
     _lastStateTime = 0;
     _multiplexDelay = 2000;  // 2ms default
     _blankingTime = 50;     // 50us default blanking
     _multiplexEnabled = true;
+    _multiplexRequest = true;
     _displayValue = 0;
     _leadingZeros = false;
     _blankOnZero = false;
     
     // Clear digit data
+    NJU3711_Frame blank = {{0, 0, 0}, 0x00, 0x07};
+    _frames.fill(blank);
+    _frameHandoff = false;
+    
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    _shownFrame = blank;
+    _scanDelay = _multiplexDelay;
+    _slowDelay = 3333;      // 100Hz flicker floor
+    _staticFrames = 0;
+    _staticThreshold = 30;
+    _refreshPolicy = NJU3711_REFRESH_FIXED;
+    _scanSuspended = false;
+#endif
+    
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    _digitPattern = 0;
+    _segmentBudget = 0;
+    _subframes = 1;
+    _subframesLeft = 0;
+    _subframeLatency = 0;
+#endif
+    
+#if NJU3711_ENABLE_DIMMING
+    _brightness = 255;
+    _hardwareMask = 0;
+    _pwmOn = 0;
+    _dimmingMode = NJU3711_DIM_AUTO;
+    _softDimPending = false;
+#endif
+    
+#if NJU3711_ENABLE_KEYPAD
+    _keyReturnPin = 255;
+    _keyDigit = 0xFF;
+    _keyDebounce = 20;
     for (int i = 0; i < 3; i++) {
-        _digitData[i] = 0;
-        _digitDP[i] = false;
-        _digitEnabled[i] = true;
+        _keyTime[i] = 0;
     }
+    _keyState = 0;
+    _keyLocked = 0;
+    _keyPressed = 0;
+    _keyReleased = 0;
+#endif
+    
+#if NJU3711_ENABLE_QUIET_WINDOW
+    _quietCallback = NULL;
+    _quietWindow = 0;
+    _quietStart = 0;
+    _quietSettle = 0;
+    _quietDuration = 0;
+    _quietWorst = 0;
+    _quietOverruns = 0;
+    _quietPhase = QUIET_NONE;
+#endif
+    
+#if NJU3711_ENABLE_ENERGY_METER
+    _litSince = 0;
+    _litDigit = 0xFF;
+    _litPattern = 0;
+#endif
 }
 
 // Constructor for 3-digit with CLR pin
@@ -55,21 +126,77 @@ NJU3711_7Segment_Multi::NJU3711_7Segment_Multi(uint8_t dataPin, uint8_t clockPin
     _mplexState = MPLEX_IDLE;
     _currentDigit = 0;
     _nextDigit = 0;
+    _frameCount = 0;
     _lastMultiplexTime = 0;
     _lastStateTime = 0;
     _multiplexDelay = 2000;  // 2ms default
     _blankingTime = 50;     // 50us default blanking
     _multiplexEnabled = true;
+    _multiplexRequest = true;
     _displayValue = 0;
     _leadingZeros = false;
     _blankOnZero = false;
     
     // Clear digit data
+    NJU3711_Frame blank = {{0, 0, 0}, 0x00, 0x07};
+    _frames.fill(blank);
+    _frameHandoff = false;
+    
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    _shownFrame = blank;
+    _scanDelay = _multiplexDelay;
+    _slowDelay = 3333;      // 100Hz flicker floor
+    _staticFrames = 0;
+    _staticThreshold = 30;
+    _refreshPolicy = NJU3711_REFRESH_FIXED;
+    _scanSuspended = false;
+#endif
+    
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    _digitPattern = 0;
+    _segmentBudget = 0;
+    _subframes = 1;
+    _subframesLeft = 0;
+    _subframeLatency = 0;
+#endif
+    
+#if NJU3711_ENABLE_DIMMING
+    _brightness = 255;
+    _hardwareMask = 0;
+    _pwmOn = 0;
+    _dimmingMode = NJU3711_DIM_AUTO;
+    _softDimPending = false;
+#endif
+    
+#if NJU3711_ENABLE_KEYPAD
+    _keyReturnPin = 255;
+    _keyDigit = 0xFF;
+    _keyDebounce = 20;
     for (int i = 0; i < 3; i++) {
-        _digitData[i] = 0;
-        _digitDP[i] = false;
-        _digitEnabled[i] = true;
+        _keyTime[i] = 0;
     }
+    _keyState = 0;
+    _keyLocked = 0;
+    _keyPressed = 0;
+    _keyReleased = 0;
+#endif
+    
+#if NJU3711_ENABLE_QUIET_WINDOW
+    _quietCallback = NULL;
+    _quietWindow = 0;
+    _quietStart = 0;
+    _quietSettle = 0;
+    _quietDuration = 0;
+    _quietWorst = 0;
+    _quietOverruns = 0;
+    _quietPhase = QUIET_NONE;
+#endif
+    
+#if NJU3711_ENABLE_ENERGY_METER
+    _litSince = 0;
+    _litDigit = 0xFF;
+    _litPattern = 0;
+#endif
 }
 
 // Initialize
@@ -83,28 +210,186 @@ void NJU3711_7Segment_Multi::begin() {
         digitalWrite(_digitPins[i], HIGH);  // HIGH = OFF for PNP transistor
     }
     
-    _lastMultiplexTime = micros();
+#if NJU3711_ENABLE_DIMMING
+    updateHardwareMask();
+#endif
+    _lastMultiplexTime = (uint16_t)micros();
 }
 
 // Update - must be called regularly
 void NJU3711_7Segment_Multi::update() {
+#if NJU3711_ENABLE_LOAD_METER
+    _loadMeter.beginCall();
+#endif
+    
     // Call parent update
     NJU3711_7Segment::update();
     
+    // Under frame handoff enableMultiplex() only leaves a request
+    if (_multiplexRequest != _multiplexEnabled) {
+        applyMultiplex();
+    }
+    
+#if NJU3711_ENABLE_LOAD_METER
+    unsigned long loadStart = micros();
+#endif
+    
     // Handle multiplexing if enabled
     if (_multiplexEnabled && !isBusy()) {
         multiplexDisplay();
     }
+    
+#if NJU3711_ENABLE_LOAD_METER
+    _loadMeter.endCall(NJU3711_LOAD_MULTIPLEX, loadStart);
+#endif
+#if NJU3711_ENABLE_ENERGY_METER
+    // Keep the window rolling while the scan is suspended. A digit still
+    // lit when the window is due is booked up to the same instant first,
+    // so its time counts in the window it was lit in.
+    if (_litDigit < 3) {
+        unsigned long now = micros();
+        if (_energyMeter.isWindowDue(now)) {
+            splitLitTime(now);
+        }
+    }
+    _energyMeter.update();
+#endif
+}
+
+// Earliest of the parent deadlines and the next scan step
+unsigned long NJU3711_7Segment_Multi::getTimeToNextEvent() {
+    unsigned long next = NJU3711_7Segment::getTimeToNextEvent();
+    
+    // While the bus is busy the scan waits on it, so the bus deadline rules
+    if (!_multiplexEnabled || isBusy()) return next;
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    // A suspended scan only resumes after the application changes the frame
+    if (_scanSuspended) {
+#if NJU3711_ENABLE_KEYPAD
+        // but the keys are still polled, one digit line at a time
+        uint16_t now = (uint16_t)micros();
+        unsigned long poll;
+        if (_keyDigit < 3) {
+            poll = remainingTime16(_lastMultiplexTime, NJU3711_KEY_SETTLE_MICROS, now);
+        } else if (_keyReturnPin != 255) {
+            poll = remainingTime16(_lastMultiplexTime, _multiplexDelay, now);
+        } else {
+            return next;
+        }
+        return (poll < next) ? poll : next;
+#else
+        return next;
+#endif
+    }
+#endif
+    
+    uint16_t now = (uint16_t)micros();
+    unsigned long scan;
+    switch (_mplexState) {
+        case MPLEX_IDLE:
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+            if (_subframesLeft > 0) {
+                scan = remainingTime16(_lastMultiplexTime, subframeDue(), now);
+                break;
+            }
+#endif
+#if NJU3711_ENABLE_DIMMING
+            if (_softDimPending) {
+                scan = remainingTime16(_lastMultiplexTime, softDimOnTime(), now);
+                break;
+            }
+#endif
+            scan = remainingTime16(_lastMultiplexTime, scanDelay(), now);
+            break;
+        case MPLEX_WAIT_BLANKING:
+#if NJU3711_ENABLE_QUIET_WINDOW
+            if (_quietPhase == QUIET_HOLD) {
+                scan = remainingTime16(_quietStart, _quietWindow, now);
+                break;
+            }
+#endif
+            scan = remainingTime16(_lastStateTime, _blankingTime, now);
+            break;
+        case MPLEX_WAIT_DATA:
+            scan = remainingTime16(_lastStateTime, 10, now);
+            break;
+        default:
+            scan = 0;
+            break;
+    }
+    return (scan < next) ? scan : next;
 }
 
 // Multiplex the display with proper state machine
 void NJU3711_7Segment_Multi::multiplexDisplay() {
-    unsigned long currentTime = micros();
+    uint16_t currentTime = (uint16_t)micros();
     
     switch (_mplexState) {
         case MPLEX_IDLE:
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+            if (_refreshPolicy != NJU3711_REFRESH_FIXED) {
+                // While suspended no scan is running, so a published frame
+                // can be picked up at any time
+                if (_scanSuspended && _frameHandoff) {
+                    _frames.fetch();
+                }
+                
+                if (!frameVisible(scanFrame())) {
+                    // Nothing to show - switch the digits off and stop scanning
+                    if (!_scanSuspended) {
+                        deselectAllDigits();
+                        _scanSuspended = true;
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+                        _subframesLeft = 0;
+#endif
+#if NJU3711_ENABLE_DIMMING
+                        _softDimPending = false;
+#endif
+#if NJU3711_ENABLE_KEYPAD
+                        _lastMultiplexTime = currentTime;   // First key poll one delay later
+                    } else {
+                        pollKeyLine(currentTime);
+#endif
+                    }
+                    break;
+                }
+                
+                if (_scanSuspended) {
+                    // Resume at full rate without waiting out a delay
+                    _scanSuspended = false;
+                    _scanDelay = _multiplexDelay;
+                    _staticFrames = 0;
+                    _lastMultiplexTime = currentTime - _scanDelay;
+                }
+            }
+#endif
+#if NJU3711_ENABLE_DIMMING
+            if (_softDimPending &&
+                (uint16_t)(currentTime - _lastMultiplexTime) >= softDimOnTime()) {
+                // Dimmed digit has had its share of the slot
+                deselectAllDigits();
+                _softDimPending = false;
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+                _subframesLeft = 0;
+#endif
+            }
+#endif
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+            if (_subframesLeft > 0) {
+                // Switch to the next subframe; the digit stays on and the
+                // new segments appear at the latch
+                if ((uint16_t)(currentTime - _lastMultiplexTime) >= subframeDue()) {
+                    _subframesLeft--;
+                    uint8_t pattern = subframePattern(_digitPattern, _subframes - 1 - _subframesLeft);
+                    NJU3711::write((getDisplayMode() == ACTIVE_LOW) ? ~pattern : pattern);
+                    _mplexState = MPLEX_DISPLAY_DIGIT;
+                    _lastStateTime = currentTime;
+                }
+                break;
+            }
+#endif
             // Check if it's time for next digit
-            if ((currentTime - _lastMultiplexTime) >= _multiplexDelay) {
+            if ((uint16_t)(currentTime - _lastMultiplexTime) >= scanDelay()) {
                 _mplexState = MPLEX_TURN_OFF_DIGITS;
                 _lastStateTime = currentTime;
             }
@@ -115,13 +400,39 @@ void NJU3711_7Segment_Multi::multiplexDisplay() {
             deselectAllDigits();
             _mplexState = MPLEX_WAIT_BLANKING;
             _lastStateTime = currentTime;
+#if NJU3711_ENABLE_QUIET_WINDOW
+            // The gap before digit 0 of the next frame hosts the quiet window
+            if (_quietCallback != NULL && _currentDigit == 2) {
+                _quietPhase = QUIET_DUE;
+            }
+#endif
             break;
             
         case MPLEX_WAIT_BLANKING:
+#if NJU3711_ENABLE_QUIET_WINDOW
+            if (_quietPhase != QUIET_NONE && !quietWindowDone(currentTime)) {
+                break;
+            }
+#endif
             // Wait for blanking period
-            if ((currentTime - _lastStateTime) >= _blankingTime) {
+            if ((uint16_t)(currentTime - _lastStateTime) >= _blankingTime) {
                 // Always move to next digit in sequence (0->1->2->0...)
                 _nextDigit = (_currentDigit + 1) % 3;
+                
+                if (_nextDigit == 0) {
+                    _frameCount++;
+                }
+                
+                // Pick up a newly published frame only between frames,
+                // so the digits of one scan never mix two frames
+                if (_frameHandoff && _nextDigit == 0) {
+                    _frames.fetch();
+                }
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+                if (_refreshPolicy == NJU3711_REFRESH_ADAPTIVE && _nextDigit == 0) {
+                    adaptScanRate();
+                }
+#endif
                 _mplexState = MPLEX_WRITE_DATA;
             }
             break;
@@ -129,13 +440,14 @@ void NJU3711_7Segment_Multi::multiplexDisplay() {
         case MPLEX_WRITE_DATA:
             // Only proceed if NJU3711 is not busy
             if (!isBusy()) {
+                const NJU3711_Frame& frame = scanFrame();
                 uint8_t pattern;
                 
                 // Check if this digit should display something
-                if (_digitEnabled[_nextDigit]) {
+                if (frame.enabledMask & (1 << _nextDigit)) {
                     // Prepare segment data
-                    pattern = _digitData[_nextDigit];
-                    if (_digitDP[_nextDigit]) {
+                    pattern = frame.segments[_nextDigit];
+                    if (frame.dpMask & (1 << _nextDigit)) {
                         pattern |= (1 << 0);  // DP is bit 0
                     }
                 } else {
@@ -143,6 +455,12 @@ void NJU3711_7Segment_Multi::multiplexDisplay() {
                     pattern = 0x00;
                 }
                 
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+                // Start the slot with the first subframe
+                _digitPattern = pattern;
+                pattern = subframePattern(pattern, 0);
+#endif
+                
                 // Apply display mode (invert for active low)
                 pattern = (getDisplayMode() == ACTIVE_LOW) ? ~pattern : pattern;
                 
@@ -157,7 +475,7 @@ void NJU3711_7Segment_Multi::multiplexDisplay() {
             // Wait for data to be written and latched
             if (!isBusy()) {
                 // Add small delay to ensure data is stable
-                if ((currentTime - _lastStateTime) >= 10) {
+                if ((uint16_t)(currentTime - _lastStateTime) >= 10) {
                     _mplexState = MPLEX_TURN_ON_DIGIT;
                 }
             }
@@ -166,33 +484,294 @@ void NJU3711_7Segment_Multi::multiplexDisplay() {
         case MPLEX_TURN_ON_DIGIT:
             // Always turn on the digit, even if blank
             // This maintains constant timing
+#if NJU3711_ENABLE_DIMMING
+            if (_brightness > 0) {
+                selectDigit(_nextDigit);
+            }
+#else
             selectDigit(_nextDigit);
+#endif
             _currentDigit = _nextDigit;
             _mplexState = MPLEX_DISPLAY_DIGIT;
             _lastMultiplexTime = currentTime;
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+            _subframesLeft = _subframes - 1;
+#endif
+#if NJU3711_ENABLE_DIMMING
+            _softDimPending = (_brightness < 255) && !(_hardwareMask & (1 << _nextDigit));
+#endif
             break;
             
         case MPLEX_DISPLAY_DIGIT:
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+            if (_subframesLeft + 1 < _subframes) {
+                // A subframe has just been latched. Later subframes are
+                // written this much early, so each one is lit for an equal
+                // share of the slot
+                _subframeLatency = currentTime - _lastStateTime;
+#if NJU3711_ENABLE_ENERGY_METER
+                splitLitTime(micros());
+#endif
+            }
+#endif
             // Display this digit for the multiplex delay period
             _mplexState = MPLEX_IDLE;
             break;
     }
 }
 
+#if NJU3711_ENABLE_ENERGY_METER
+// Book the time the lit digit was on with the segments it showed
+void NJU3711_7Segment_Multi::accountLitTime(unsigned long now) {
+    if (_litDigit < 3) {
+        unsigned long duration = now - _litSince;
+#if NJU3711_ENABLE_DIMMING
+        // Only the PWM duty of a hardware dimmed digit is lit
+        if (_brightness < 255 && (_hardwareMask & (1 << _litDigit))) {
+            duration = (unsigned long)(((uint64_t)duration * _brightness) / 255);
+        }
+#endif
+        _energyMeter.addOnTime(_litDigit, _litPattern, duration);
+        _litDigit = 0xFF;
+    }
+}
+
+void NJU3711_7Segment_Multi::startLitTime(uint8_t digit, unsigned long now) {
+    // The digit shows whatever is latched in the driver outputs
+    uint8_t latched = getCurrentData();
+    _litPattern = (getDisplayMode() == ACTIVE_LOW) ? (uint8_t)~latched : latched;
+    _litDigit = digit;
+    _litSince = now;
+}
+
+// Close the lit span and open the next one at the same instant, so no
+// time falls between them
+void NJU3711_7Segment_Multi::splitLitTime(unsigned long now) {
+    uint8_t digit = _litDigit;
+    accountLitTime(now);
+    startLitTime(digit, now);
+}
+#endif
+
 // Select a digit (turn on its transistor)
 void NJU3711_7Segment_Multi::selectDigit(uint8_t digit) {
     if (digit < 3) {
+#if NJU3711_ENABLE_ENERGY_METER
+        accountLitTime(micros());
+#endif
+        // Break before make - never drive two digits at once
+        for (int i = 0; i < 3; i++) {
+            if (i != digit) {
+#if NJU3711_ENABLE_DIMMING
+                digitOff(i);
+#else
+                digitalWrite(_digitPins[i], HIGH);
+#endif
+            }
+        }
+#if NJU3711_ENABLE_DIMMING
+        if (_brightness < 255 && (_hardwareMask & (1 << digit))) {
+            // Timer gates the transistor: LOW (on) for _brightness/255 of each period
+            analogWrite(_digitPins[digit], 255 - _brightness);
+            _pwmOn |= (1 << digit);
+        } else if (_pwmOn & (1 << digit)) {
+            analogWrite(_digitPins[digit], 0);      // Still attached to PWM - fully on
+        } else {
+            digitalWrite(_digitPins[digit], LOW);  // LOW = ON for PNP transistor
+        }
+#else
         digitalWrite(_digitPins[digit], LOW);  // LOW = ON for PNP transistor
+#endif
+        
+#if NJU3711_ENABLE_KEYPAD
+        _keyDigit = digit;
+#endif
+#if NJU3711_ENABLE_ENERGY_METER
+        startLitTime(digit, micros());
+#endif
     }
 }
 
 // Deselect all digits
 void NJU3711_7Segment_Multi::deselectAllDigits() {
+#if NJU3711_ENABLE_KEYPAD
+    // The selected digit line has been low for the whole slot, so the
+    // return line has settled - read it before the blanking window starts
+    sampleKey();
+#endif
+#if NJU3711_ENABLE_ENERGY_METER
+    accountLitTime(micros());
+#endif
     for (int i = 0; i < 3; i++) {
+#if NJU3711_ENABLE_DIMMING
+        digitOff(i);
+#else
         digitalWrite(_digitPins[i], HIGH);  // HIGH = OFF for PNP transistor
+#endif
+    }
+}
+
+#if NJU3711_ENABLE_KEYPAD
+// Keypad. Each key sits between its digit-select line and the shared
+// return pin (cathode toward the digit line). The return pin is pulled
+// up and reads LOW while the selected digit's key is held.
+void NJU3711_7Segment_Multi::beginKeypad(uint8_t returnPin, uint16_t debounceMillis) {
+    pinMode(returnPin, INPUT_PULLUP);
+    _keyReturnPin = returnPin;
+    _keyDigit = 0xFF;
+    _keyDebounce = debounceMillis;
+    _keyState = 0;
+    _keyLocked = 0;
+    _keyPressed = 0;
+    _keyReleased = 0;
+}
+
+void NJU3711_7Segment_Multi::endKeypad() {
+    _keyReturnPin = 255;
+    _keyState = 0;
+}
+
+// Sample the key of the selected digit. A change is accepted at once, so
+// a press shows up within one frame; further changes of that key are
+// ignored for the debounce time, which swallows contact bounce.
+void NJU3711_7Segment_Multi::sampleKey() {
+    uint8_t digit = _keyDigit;
+    _keyDigit = 0xFF;
+    if (digit >= 3 || _keyReturnPin == 255) return;
+    
+    uint8_t bit = 1 << digit;
+    uint16_t now = (uint16_t)millis();
+    if (_keyLocked & bit) {
+        if ((uint16_t)(now - _keyTime[digit]) < _keyDebounce) return;
+        _keyLocked &= ~bit;
+    }
+    
+#if NJU3711_ENABLE_DIMMING
+    if (_pwmOn & (1 << digit)) {
+        // A PWM gated line may be in its off phase - hold it low and let
+        // the return line follow before the read
+        digitalWrite(_digitPins[digit], LOW);
+        delayMicroseconds(NJU3711_KEY_SETTLE_MICROS);
+    }
+#endif
+    
+    bool down = (digitalRead(_keyReturnPin) == LOW);
+    if (down == ((_keyState & bit) != 0)) return;
+    
+    if (down) {
+        _keyState |= bit;
+        _keyPressed |= bit;
+    } else {
+        _keyState &= ~bit;
+        _keyReleased |= bit;
+    }
+    _keyTime[digit] = now;
+    _keyLocked |= bit;
+}
+
+// While the scan is suspended nothing selects the digit lines, so the
+// keys are polled instead: one line per multiplex delay, selected by one
+// call and read and deselected by a later one once it has settled. The
+// segments are blanked first, and each call does only one of the three
+// steps, so it stays within the scan's pin budget.
+void NJU3711_7Segment_Multi::pollKeyLine(uint16_t now) {
+    if (_keyDigit < 3) {
+        if ((uint16_t)(now - _lastMultiplexTime) >= NJU3711_KEY_SETTLE_MICROS) {
+            deselectAllDigits();
+        }
+        return;
+    }
+    if (_keyReturnPin == 255 || (uint16_t)(now - _lastMultiplexTime) < _multiplexDelay) return;
+    
+    // The scan stopped with the last digit's segments latched
+    uint8_t blank = (getDisplayMode() == ACTIVE_LOW) ? 0xFF : 0x00;
+    if (getCurrentData() != blank) {
+        NJU3711::write(blank);
+        return;
+    }
+    
+    _lastMultiplexTime = now;
+    _currentDigit = (_currentDigit + 1) % 3;
+    selectDigit(_currentDigit);
+}
+
+bool NJU3711_7Segment_Multi::isKeyDown(uint8_t key) {
+    return (key < 3) && (_keyState & (1 << key));
+}
+
+bool NJU3711_7Segment_Multi::wasKeyPressed(uint8_t key) {
+    if (key >= 3 || !(_keyPressed & (1 << key))) return false;
+    _keyPressed &= ~(1 << key);
+    return true;
+}
+
+bool NJU3711_7Segment_Multi::wasKeyReleased(uint8_t key) {
+    if (key >= 3 || !(_keyReleased & (1 << key))) return false;
+    _keyReleased &= ~(1 << key);
+    return true;
+}
+
+uint8_t NJU3711_7Segment_Multi::getKeys() {
+    return _keyState;
+}
+#endif
+
+#if NJU3711_ENABLE_QUIET_WINDOW
+// Quiet window. The callback runs inside update(), so nothing else in the
+// library can light a digit or clock the bus until it returns. Afterwards
+// the gap is held until the reserved window has passed, which covers work
+// the callback only started (e.g. an ADC conversion).
+bool NJU3711_7Segment_Multi::quietWindowDone(uint16_t now) {
+    if (_quietPhase == QUIET_DUE) {
+        // Let the digit current die away first, and never start while a
+        // scrub is still shifting
+        uint16_t dark = now - _lastStateTime;
+        if (dark < _blankingTime) return false;
+#if NJU3711_ENABLE_SCRUBBER
+        if (isScrubbing()) return false;
+#endif
+        
+        _quietSettle = dark;
+        _quietStart = now;
+        if (_quietCallback != NULL) {
+            _quietCallback();
+        }
+        uint16_t duration = (uint16_t)micros() - now;
+        _quietDuration = duration;
+        if (duration > _quietWorst) _quietWorst = duration;
+        if (duration > _quietWindow && _quietOverruns < 0xFFFF) _quietOverruns++;
+        _quietPhase = QUIET_HOLD;
     }
+    
+    if ((uint16_t)((uint16_t)micros() - _quietStart) < _quietWindow) return false;
+    _quietPhase = QUIET_NONE;
+    return true;
+}
+
+void NJU3711_7Segment_Multi::setQuietCallback(NJU3711_QuietCallback callback, uint16_t windowMicros) {
+    _quietCallback = callback;
+    _quietWindow = windowMicros;
+    _quietWorst = 0;
+    _quietOverruns = 0;
+}
+
+uint16_t NJU3711_7Segment_Multi::getQuietSettle() {
+    return _quietSettle;
 }
 
+uint16_t NJU3711_7Segment_Multi::getQuietDuration() {
+    return _quietDuration;
+}
+
+uint16_t NJU3711_7Segment_Multi::getQuietWorst() {
+    return _quietWorst;
+}
+
+uint16_t NJU3711_7Segment_Multi::getQuietOverruns() {
+    return _quietOverruns;
+}
+#endif
+
 // Display a number (0-999)
 bool NJU3711_7Segment_Multi::displayNumber(uint16_t number) {
     if (number > 999) number = 999;
@@ -211,7 +790,7 @@ bool NJU3711_7Segment_Multi::displayNumber(uint16_t number, uint8_t decimalPosit
     
     // Set decimal point if position is valid
     if (decimalPosition > 0 && decimalPosition <= 3) {
-        _digitDP[decimalPosition - 1] = true;
+        _frames.back().dpMask |= (1 << (decimalPosition - 1));
     }
     
     return true;
@@ -219,14 +798,15 @@ bool NJU3711_7Segment_Multi::displayNumber(uint16_t number, uint8_t decimalPosit
 
 // Update digit data based on current display value
 void NJU3711_7Segment_Multi::updateDigitData() {
+    NJU3711_Frame& frame = _frames.back();
     uint16_t value = _displayValue;
     
     // Handle blank on zero
     if (_blankOnZero && value == 0) {
         for (int i = 0; i < 3; i++) {
-            _digitData[i] = 0;  // Blank
-            _digitEnabled[i] = false;
+            frame.segments[i] = 0;  // Blank
         }
+        frame.enabledMask = 0x00;
         return;
     }
     
@@ -269,12 +849,11 @@ void NJU3711_7Segment_Multi::updateDigitData() {
     // Update digit data
     for (int i = 0; i < 3; i++) {
         if (showDigit[i]) {
-            _digitData[i] = getDigitPattern(digits[i]);
-            _digitEnabled[i] = true;
+            frame.segments[i] = getDigitPattern(digits[i]);
         } else {
-            _digitData[i] = 0;  // Blank pattern
-            _digitEnabled[i] = false;
+            frame.segments[i] = 0;  // Blank pattern
         }
+        setMaskBit(frame.enabledMask, i, showDigit[i]);
     }
 }
 
@@ -282,9 +861,10 @@ void NJU3711_7Segment_Multi::updateDigitData() {
 bool NJU3711_7Segment_Multi::setDigit(uint8_t position, uint8_t value, bool showDP) {
     if (position >= 3) return false;
     
-    _digitData[position] = getDigitPattern(value);
-    _digitDP[position] = showDP;
-    _digitEnabled[position] = true;
+    NJU3711_Frame& frame = _frames.back();
+    frame.segments[position] = getDigitPattern(value);
+    setMaskBit(frame.dpMask, position, showDP);
+    setMaskBit(frame.enabledMask, position, true);
     return true;
 }
 
@@ -292,9 +872,10 @@ bool NJU3711_7Segment_Multi::setDigit(uint8_t position, uint8_t value, bool show
 bool NJU3711_7Segment_Multi::setDigitChar(uint8_t position, char character, bool showDP) {
     if (position >= 3) return false;
     
-    _digitData[position] = getCharPattern(character);
-    _digitDP[position] = showDP;
-    _digitEnabled[position] = true;
+    NJU3711_Frame& frame = _frames.back();
+    frame.segments[position] = getCharPattern(character);
+    setMaskBit(frame.dpMask, position, showDP);
+    setMaskBit(frame.enabledMask, position, true);
     return true;
 }
 
@@ -302,16 +883,17 @@ bool NJU3711_7Segment_Multi::setDigitChar(uint8_t position, char character, bool
 bool NJU3711_7Segment_Multi::setDigitRaw(uint8_t position, uint8_t segments, bool showDP) {
     if (position >= 3) return false;
     
-    _digitData[position] = segments;
-    _digitDP[position] = showDP;
-    _digitEnabled[position] = true;
+    NJU3711_Frame& frame = _frames.back();
+    frame.segments[position] = segments;
+    setMaskBit(frame.dpMask, position, showDP);
+    setMaskBit(frame.enabledMask, position, true);
     return true;
 }
 
 // Enable/disable digits
 bool NJU3711_7Segment_Multi::enableDigit(uint8_t position, bool enable) {
     if (position >= 3) return false;
-    _digitEnabled[position] = enable;
+    setMaskBit(_frames.back().enabledMask, position, enable);
     return true;
 }
 
@@ -320,15 +902,11 @@ bool NJU3711_7Segment_Multi::disableDigit(uint8_t position) {
 }
 
 void NJU3711_7Segment_Multi::enableAllDigits() {
-    for (int i = 0; i < 3; i++) {
-        _digitEnabled[i] = true;
-    }
+    _frames.back().enabledMask = 0x07;
 }
 
 void NJU3711_7Segment_Multi::disableAllDigits() {
-    for (int i = 0; i < 3; i++) {
-        _digitEnabled[i] = false;
-    }
+    _frames.back().enabledMask = 0x00;
 }
 
 // Display control
@@ -344,30 +922,81 @@ void NJU3711_7Segment_Multi::setBlankOnZero(bool enable) {
 
 void NJU3711_7Segment_Multi::clearDisplay() {
     disableAllDigits();
+    if (_frameHandoff) {
+        // The refresh side owns the digit pins; it shows the blank frame
+        // from its next scan on
+        publishFrame();
+        return;
+    }
     deselectAllDigits();
 }
 
-void NJU3711_7Segment_Multi::displayAll() {
+bool NJU3711_7Segment_Multi::displayAll() {
+    NJU3711_Frame& frame = _frames.back();
     for (int i = 0; i < 3; i++) {
-        _digitData[i] = 0xFF;  // All segments on
-        _digitDP[i] = true;
-        _digitEnabled[i] = true;
+        frame.segments[i] = 0xFF;  // All segments on
     }
+    frame.dpMask = 0x07;
+    frame.enabledMask = 0x07;
+    return true;
 }
 
 // Multiplexing control
-void NJU3711_7Segment_Multi::setMultiplexDelay(unsigned long delayMicros) {
-    _multiplexDelay = delayMicros;
+// Both intervals are stored in 16 bits, so longer ones are refused and the
+// previous setting stays
+bool NJU3711_7Segment_Multi::setMultiplexDelay(unsigned long delayMicros) {
+    if (delayMicros > 0xFFFFUL) return false;
+    _multiplexDelay = (uint16_t)delayMicros;
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    _scanDelay = _multiplexDelay;
+    _staticFrames = 0;
+#endif
+    return true;
+}
+
+bool NJU3711_7Segment_Multi::setBlankingTime(unsigned long blankingMicros) {
+    if (blankingMicros > 0xFFFFUL) return false;
+    _blankingTime = (uint16_t)blankingMicros;
+    return true;
+}
+
+unsigned long NJU3711_7Segment_Multi::getMultiplexDelay() {
+    return _multiplexDelay;
+}
+
+unsigned long NJU3711_7Segment_Multi::getBlankingTime() {
+    return _blankingTime;
 }
 
-void NJU3711_7Segment_Multi::setBlankingTime(unsigned long blankingMicros) {
-    _blankingTime = blankingMicros;
+uint16_t NJU3711_7Segment_Multi::getFrameCount() {
+    return _frameCount;
 }
 
 void NJU3711_7Segment_Multi::enableMultiplex(bool enable) {
+    _multiplexRequest = enable;
+    // With frame handoff the scan state and the digit pins belong to the
+    // refresh side, so its update() applies the request
+    if (!_frameHandoff) {
+        applyMultiplex();
+    }
+}
+
+void NJU3711_7Segment_Multi::applyMultiplex() {
+    bool enable = _multiplexRequest;
+    if (enable && !_multiplexEnabled) {
+        // The 16-bit scan stamp may have wrapped while the scan was off, so
+        // restart it one slot old and show the next digit at once
+        _lastMultiplexTime = (uint16_t)((uint16_t)micros() - scanDelay());
+    }
     _multiplexEnabled = enable;
     if (!enable) {
         deselectAllDigits();
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+        _subframesLeft = 0;
+#endif
+#if NJU3711_ENABLE_DIMMING
+        _softDimPending = false;
+#endif
     }
 }
 
@@ -376,9 +1005,174 @@ void NJU3711_7Segment_Multi::disableMultiplex() {
 }
 
 bool NJU3711_7Segment_Multi::isMultiplexing() {
-    return _multiplexEnabled;
+    return _multiplexRequest;
+}
+
+#if NJU3711_ENABLE_DIMMING
+// Brightness. Hardware dimming costs nothing per slot; software dimming
+// needs one more scan step per digit and update() calls close to the
+// switch-off time
+void NJU3711_7Segment_Multi::setBrightness(uint8_t level) {
+    _brightness = level;
+}
+
+uint8_t NJU3711_7Segment_Multi::getBrightness() {
+    return _brightness;
+}
+
+void NJU3711_7Segment_Multi::setDimmingMode(NJU3711_DimmingMode mode) {
+    _dimmingMode = mode;
+    updateHardwareMask();
+}
+
+NJU3711_DimmingMode NJU3711_7Segment_Multi::getDimmingMode() {
+    return _dimmingMode;
+}
+
+bool NJU3711_7Segment_Multi::isHardwareDimmed(uint8_t digit) {
+    if (digit >= 3) return false;
+    return (_hardwareMask & (1 << digit)) != 0;
+}
+
+void NJU3711_7Segment_Multi::updateHardwareMask() {
+    _hardwareMask = 0;
+    if (_dimmingMode == NJU3711_DIM_SOFTWARE) return;
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        if (NJU3711_PIN_HAS_PWM(_digitPins[i])) {
+            _hardwareMask |= (1 << i);
+        }
+    }
+}
+
+// Not every core stops PWM on digitalWrite(), so a pin left running PWM
+// is switched fully off through analogWrite()
+void NJU3711_7Segment_Multi::digitOff(uint8_t digit) {
+    if (_pwmOn & (1 << digit)) {
+        analogWrite(_digitPins[digit], 255);
+        _pwmOn &= ~(1 << digit);
+    } else {
+        digitalWrite(_digitPins[digit], HIGH);  // HIGH = OFF for PNP transistor
+    }
+}
+
+// Lit part of the slot for a software dimmed digit
+uint16_t NJU3711_7Segment_Multi::softDimOnTime() {
+    return (uint16_t)(((unsigned long)scanDelay() * _brightness) / 255);
+}
+#endif
+
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+// Peak-current limit. Every glyph gets the same number of subframes, so
+// each lit segment is on for the same share of the slot whatever else the
+// digit shows, and brightness stays equal between "1" and "8."
+void NJU3711_7Segment_Multi::setSegmentBudget(uint8_t segments) {
+    if (segments >= 8) segments = 0;
+    _segmentBudget = segments;
+    _subframes = (segments == 0) ? 1 : (uint8_t)((8 + segments - 1) / segments);
+    _subframesLeft = 0;     // The new split starts with the next digit
 }
 
+uint8_t NJU3711_7Segment_Multi::getSegmentBudget() {
+    return _segmentBudget;
+}
+
+uint8_t NJU3711_7Segment_Multi::getSubframes() {
+    return _subframes;
+}
+
+// Lit segments are dealt to the subframes in turn, which keeps every
+// subframe within ceil(lit / subframes) <= budget segments
+uint8_t NJU3711_7Segment_Multi::subframePattern(uint8_t pattern, uint8_t subframe) {
+    if (_subframes <= 1) return pattern;
+    
+    uint8_t result = 0;
+    uint8_t lit = 0;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (pattern & (1 << bit)) {
+            if (lit % _subframes == subframe) {
+                result |= (1 << bit);
+            }
+            lit++;
+        }
+    }
+    return result;
+}
+
+// Time into the slot at which the next subframe has to be written
+uint16_t NJU3711_7Segment_Multi::subframeDue() {
+    uint8_t shown = _subframes - _subframesLeft;
+    uint16_t slot = scanDelay();
+#if NJU3711_ENABLE_DIMMING
+    // Software dimming squeezes the subframes into the lit part of the slot
+    if (_softDimPending) slot = softDimOnTime();
+#endif
+    uint16_t due = (uint16_t)(((unsigned long)slot * shown) / _subframes);
+    return (due > _subframeLatency) ? due - _subframeLatency : 0;
+}
+#endif
+
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+// Adaptive refresh control
+void NJU3711_7Segment_Multi::setRefreshPolicy(NJU3711_RefreshPolicy policy) {
+    _refreshPolicy = policy;
+    _scanDelay = _multiplexDelay;
+    _staticFrames = 0;
+    _scanSuspended = false;
+}
+
+NJU3711_RefreshPolicy NJU3711_7Segment_Multi::getRefreshPolicy() {
+    return _refreshPolicy;
+}
+
+// Three digits share each refresh, so a digit gets a third of the period
+void NJU3711_7Segment_Multi::setFlickerFloor(uint8_t hz) {
+    if (hz < 6) hz = 6;     // Longest time per digit that fits in 16 bits
+    _slowDelay = 1000000UL / (3UL * hz);
+}
+
+void NJU3711_7Segment_Multi::setStaticThreshold(uint8_t frames) {
+    _staticThreshold = frames;
+}
+
+unsigned long NJU3711_7Segment_Multi::getScanDelay() {
+    return _scanDelay;
+}
+
+bool NJU3711_7Segment_Multi::isScanSuspended() {
+    return _scanSuspended;
+}
+
+// Something lights up: an enabled digit with segments or its DP on
+bool NJU3711_7Segment_Multi::frameVisible(const NJU3711_Frame& frame) {
+    for (uint8_t i = 0; i < 3; i++) {
+        if ((frame.enabledMask & (1 << i)) && (frame.segments[i] || (frame.dpMask & (1 << i)))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Called once per frame: full rate while the content changes, then ease
+// toward the flicker floor once it has been static for a while
+void NJU3711_7Segment_Multi::adaptScanRate() {
+    const NJU3711_Frame& frame = scanFrame();
+    if (memcmp(&frame, &_shownFrame, sizeof(NJU3711_Frame)) != 0 || isAnimating()) {
+        _shownFrame = frame;
+        _staticFrames = 0;
+        _scanDelay = _multiplexDelay;
+        return;
+    }
+    
+    if (_staticFrames < 255) _staticFrames++;
+    uint16_t slowest = (_slowDelay > _multiplexDelay) ? _slowDelay : _multiplexDelay;
+    if (_staticFrames >= _staticThreshold && _scanDelay < slowest) {
+        // Small steps so the change in rate is not visible
+        _scanDelay += (slowest - _scanDelay) / 8 + 1;
+    }
+}
+#endif
+
 // Special displays
 bool NJU3711_7Segment_Multi::displayError() {
     setDigitChar(2, 'E', false);  // Leftmost
@@ -415,17 +1209,56 @@ bool NJU3711_7Segment_Multi::displayTemperature(int16_t temp, bool celsius) {
 // Decimal point control
 bool NJU3711_7Segment_Multi::setDecimalPoint(uint8_t position, bool state) {
     if (position >= 3) return false;
-    _digitDP[position] = state;
+    setMaskBit(_frames.back().dpMask, position, state);
     return true;
 }
 
 void NJU3711_7Segment_Multi::clearAllDecimalPoints() {
-    for (int i = 0; i < 3; i++) {
-        _digitDP[i] = false;
-    }
+    _frames.back().dpMask = 0x00;
 }
 
 // Get current value
 uint16_t NJU3711_7Segment_Multi::getCurrentValue() {
     return _displayValue;
-}
\ No newline at end of file
+}
+
+// Frame handoff - the application edits and publishes frames while
+// update() runs on another core or thread and only reads published frames
+void NJU3711_7Segment_Multi::enableFrameHandoff(bool enable) {
+    if (enable && !_frameHandoff) {
+        // Start from what is on the display now
+        _frames.fill(_frames.back());
+    }
+    _frameHandoff = enable;
+}
+
+bool NJU3711_7Segment_Multi::isFrameHandoff() {
+    return _frameHandoff;
+}
+
+void NJU3711_7Segment_Multi::publishFrame() {
+    if (_frameHandoff) {
+        _frames.publish();
+    }
+}
+
+NJU3711_Frame NJU3711_7Segment_Multi::getFrame() {
+    return _frames.back();
+}
+
+void NJU3711_7Segment_Multi::setFrame(const NJU3711_Frame& frame) {
+    _frames.back() = frame;
+}
+
+// Without handoff the scan reads the frame the setters edit directly
+const NJU3711_Frame& NJU3711_7Segment_Multi::scanFrame() {
+    return _frameHandoff ? _frames.front() : _frames.back();
+}
+
+void NJU3711_7Segment_Multi::setMaskBit(uint8_t& mask, uint8_t position, bool state) {
+    if (state) {
+        mask |= (1 << position);
+    } else {
+        mask &= ~(1 << position);
+    }
+}
@@ -14,19 +14,51 @@
 #define NJU3711_7SEGMENT_MULTI_H
 
 #include "NJU3711_7Segment.h"
+#include "NJU3711_TripleBuffer.h"
+
+#if NJU3711_ENABLE_ENERGY_METER
+#include "NJU3711_EnergyMeter.h"
+#endif
+
+// Contents of all three digits - one complete multiplexed frame
+struct NJU3711_Frame {
+    uint8_t segments[3];        // Segment data for each digit
+    uint8_t dpMask;             // Decimal point state (bit n = digit n)
+    uint8_t enabledMask;        // Enabled digits (bit n = digit n)
+};
+
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+// How the digit scan rate follows the content
+enum NJU3711_RefreshPolicy : uint8_t {
+    NJU3711_REFRESH_FIXED,      // Always scan at the multiplex delay (default)
+    NJU3711_REFRESH_SUSPEND,    // Stop scanning while nothing is visible
+    NJU3711_REFRESH_ADAPTIVE    // Suspend, and slow down toward the flicker floor for static content
+};
+#endif
+
+#if NJU3711_ENABLE_DIMMING
+// How setBrightness() dims the digits
+enum NJU3711_DimmingMode : uint8_t {
+    NJU3711_DIM_AUTO,           // Hardware PWM on PWM-capable digit pins, software on the rest (default)
+    NJU3711_DIM_SOFTWARE        // Software on every digit pin
+};
+#endif
+
+#if NJU3711_ENABLE_QUIET_WINDOW
+// Called in the quiet window, e.g. to take an ADC sample
+typedef void (*NJU3711_QuietCallback)();
+#endif
 
 class NJU3711_7Segment_Multi : public NJU3711_7Segment {
 private:
     // Digit control pins (connected to transistor bases)
     uint8_t _digitPins[3];
     
-    // Display data
-    uint8_t _digitData[3];      // Segment data for each digit
-    bool _digitDP[3];           // Decimal point state for each digit
-    bool _digitEnabled[3];      // Enable/disable individual digits
+    // Display data - setters edit _frames.back(), the scan reads scanFrame()
+    NJU3711_TripleBuffer<NJU3711_Frame> _frames;
     
     // Multiplexing state
-    enum MultiplexState {
+    enum MultiplexState : uint8_t {
         MPLEX_IDLE,
         MPLEX_TURN_OFF_DIGITS,
         MPLEX_WAIT_BLANKING,
@@ -39,20 +71,130 @@ private:
     MultiplexState _mplexState;
     uint8_t _currentDigit;      // Currently active digit (0-2)
     uint8_t _nextDigit;         // Next digit to display
-    unsigned long _lastMultiplexTime;
-    unsigned long _lastStateTime;
-    unsigned long _multiplexDelay;  // Time between digit switches (microseconds)
-    unsigned long _blankingTime;    // Blanking time between digits (microseconds)
-    bool _multiplexEnabled;
+    uint16_t _frameCount;       // Scans started, for refresh rate measurement
+    // Scan timestamps hold the low 16 bits of micros(); all scan intervals
+    // are well below 65ms, so wrap-around is handled by unsigned subtraction
+    uint16_t _lastMultiplexTime;
+    uint16_t _lastStateTime;
+    uint16_t _multiplexDelay;   // Time between digit switches (microseconds)
+    uint16_t _blankingTime;     // Blanking time between digits (microseconds)
+    
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    // Adaptive refresh - the scan runs at _scanDelay, which moves between
+    // _multiplexDelay (content changing) and _slowDelay (static content)
+    NJU3711_Frame _shownFrame;  // Last frame scanned, to detect changes
+    uint16_t _scanDelay;        // Current time per digit (microseconds)
+    uint16_t _slowDelay;        // Time per digit at the flicker floor
+    uint8_t _staticFrames;      // Consecutive unchanged frames (saturates)
+    uint8_t _staticThreshold;   // Unchanged frames before slowing down
+    NJU3711_RefreshPolicy _refreshPolicy;
+    bool _scanSuspended : 1;
+#endif
+    
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    // Peak-current limit - each digit slot is split into _subframes equal
+    // parts, and each part lights at most _segmentBudget segments
+    uint8_t _digitPattern;      // Full pattern of the lit digit (active-high)
+    uint8_t _segmentBudget;     // Max segments lit at once, 0 = no limit
+    uint8_t _subframes;         // Subframes per digit slot (1 = no split)
+    uint8_t _subframesLeft;     // Subframes still to show in this slot
+    uint16_t _subframeLatency;  // Measured time from writing a subframe to its latch
+#endif
+    
+#if NJU3711_ENABLE_DIMMING
+    // Dimming - hardware digits get a PWM duty instead of LOW, software
+    // digits are switched off after _brightness/255 of the slot
+    uint8_t _brightness;        // 255 = full
+    uint8_t _hardwareMask;      // Digits dimmed by hardware PWM (bit n = digit n)
+    uint8_t _pwmOn;             // Digit pins currently running PWM
+    NJU3711_DimmingMode _dimmingMode;
+    bool _softDimPending : 1;   // Lit digit still has to be switched off early
+#endif
+    
+#if NJU3711_ENABLE_ENERGY_METER
+    // Energy meter - on-time is booked when the lit digit is switched off
+    NJU3711_EnergyMeter _energyMeter;
+    unsigned long _litSince;    // When _litDigit was switched on
+    uint8_t _litDigit;          // Digit currently on, 0xFF if none
+    uint8_t _litPattern;        // Its segments (active-high)
+#endif
+    
+#if NJU3711_ENABLE_KEYPAD
+    // Keypad - key n connects digit line n to the return pin through a
+    // diode and is sampled while digit n is selected
+    uint8_t _keyReturnPin;      // 255 = no keypad
+    uint8_t _keyDigit;          // Selected digit not yet sampled, 0xFF if none
+    uint16_t _keyDebounce;      // Changes ignored for this long after a change (milliseconds)
+    uint16_t _keyTime[3];       // Low 16 bits of millis() at each key's last change
+    uint8_t _keyState;          // Debounced state (bit n = key n)
+    uint8_t _keyLocked;         // Keys still inside their debounce time
+    uint8_t _keyPressed;        // Presses not yet collected
+    uint8_t _keyReleased;       // Releases not yet collected
+#endif
+    
+#if NJU3711_ENABLE_QUIET_WINDOW
+    // Quiet window - once per frame the blanking gap is held open for the
+    // callback: digits dark for at least _blankingTime before it starts,
+    // no scan writes until _quietWindow after it started
+    enum QuietPhase : uint8_t {
+        QUIET_NONE,
+        QUIET_DUE,              // Call the callback in this blanking gap
+        QUIET_HOLD              // Called, holding the gap for the window
+    };
+    NJU3711_QuietCallback _quietCallback;
+    uint16_t _quietWindow;      // Reserved time from the callback start (microseconds)
+    uint16_t _quietStart;       // Low 16 bits of micros() at the callback start
+    uint16_t _quietSettle;      // Last: digits dark before the callback started
+    uint16_t _quietDuration;    // Last: callback run time
+    uint16_t _quietWorst;       // Longest callback run time
+    uint16_t _quietOverruns;    // Callbacks that ran past the window (saturates)
+    QuietPhase _quietPhase;
+#endif
     
     // Display value
     uint16_t _displayValue;     // 0-999
-    bool _leadingZeros;         // Show leading zeros
-    bool _blankOnZero;         // Blank display when value is 0
+    // Own bytes, not bitfields: with frame handoff the scan writes
+    // _multiplexEnabled while the application writes the flags below
+    bool _multiplexEnabled;
+    volatile bool _multiplexRequest;    // Set by enableMultiplex(), applied by update() under handoff
+    bool _frameHandoff : 1;     // Frames only reach the scan via publishFrame()
+    bool _leadingZeros : 1;     // Show leading zeros
+    bool _blankOnZero : 1;      // Blank display when value is 0
     
     // Internal methods
     void multiplexDisplay();
+    void applyMultiplex();
     void updateDigitData();
+    void setMaskBit(uint8_t& mask, uint8_t position, bool state);
+    const NJU3711_Frame& scanFrame();
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    bool frameVisible(const NJU3711_Frame& frame);
+    void adaptScanRate();
+    uint16_t scanDelay() { return _scanDelay; }
+#else
+    uint16_t scanDelay() { return _multiplexDelay; }
+#endif
+#if NJU3711_ENABLE_DIMMING
+    void updateHardwareMask();
+    void digitOff(uint8_t digit);
+    uint16_t softDimOnTime();
+#endif
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    uint8_t subframePattern(uint8_t pattern, uint8_t subframe);
+    uint16_t subframeDue();
+#endif
+#if NJU3711_ENABLE_KEYPAD
+    void sampleKey();
+    void pollKeyLine(uint16_t now);
+#endif
+#if NJU3711_ENABLE_QUIET_WINDOW
+    bool quietWindowDone(uint16_t now);
+#endif
+#if NJU3711_ENABLE_ENERGY_METER
+    void accountLitTime(unsigned long now);
+    void startLitTime(uint8_t digit, unsigned long now);
+    void splitLitTime(unsigned long now);
+#endif
 
 public:
     // Constructor for 3-digit display
@@ -71,6 +213,9 @@ public:
     // Update method (must call regularly in loop())
     void update();
     
+    // Microseconds until update() next has work, including the digit scan
+    unsigned long getTimeToNextEvent();
+    
     // Display numeric value (0-999)
     bool displayNumber(uint16_t number);
     bool displayNumber(uint16_t number, uint8_t decimalPosition); // 0=no DP, 1=digit1, 2=digit2, 3=digit3
@@ -90,15 +235,69 @@ public:
     void setLeadingZeros(bool enable);
     void setBlankOnZero(bool enable);
     void clearDisplay();
-    void displayAll();  // Test pattern - all segments on all digits
+    bool displayAll();  // Test pattern - all segments on all digits
     
     // Multiplexing control
-    void setMultiplexDelay(unsigned long delayMicros); // Default 2000us (2ms)
-    void setBlankingTime(unsigned long blankingMicros); // Default 50us
+    // Both refuse values over 65535us (the scan keeps 16-bit timestamps)
+    bool setMultiplexDelay(unsigned long delayMicros); // Default 2000us (2ms)
+    bool setBlankingTime(unsigned long blankingMicros); // Default 50us
+    unsigned long getMultiplexDelay();
+    unsigned long getBlankingTime();
+    uint16_t getFrameCount();   // Complete scans of all digits (wraps around)
     void enableMultiplex(bool enable = true);
     void disableMultiplex();
     bool isMultiplexing();
     
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    // Adaptive refresh
+    void setRefreshPolicy(NJU3711_RefreshPolicy policy);
+    NJU3711_RefreshPolicy getRefreshPolicy();
+    void setFlickerFloor(uint8_t hz);               // Slowest full-display refresh, default 100Hz
+    void setStaticThreshold(uint8_t frames);        // Unchanged frames before slowing, default 30
+    unsigned long getScanDelay();                   // Current time per digit (microseconds)
+    bool isScanSuspended();
+#endif
+    
+#if NJU3711_ENABLE_DIMMING
+    // Brightness
+    void setBrightness(uint8_t level);              // 0-255, default 255 (full)
+    uint8_t getBrightness();
+    void setDimmingMode(NJU3711_DimmingMode mode);
+    NJU3711_DimmingMode getDimmingMode();
+    bool isHardwareDimmed(uint8_t digit);           // Digit is gated by hardware PWM
+#endif
+    
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    // Peak-current limit
+    void setSegmentBudget(uint8_t segments);        // Max segments lit at once, 0 = no limit (default)
+    uint8_t getSegmentBudget();
+    uint8_t getSubframes();                         // Subframes per digit slot
+#endif
+    
+#if NJU3711_ENABLE_KEYPAD
+    // Keys on the digit-select lines, read during the scan
+    void beginKeypad(uint8_t returnPin, uint16_t debounceMillis = 20);
+    void endKeypad();
+    bool isKeyDown(uint8_t key);
+    bool wasKeyPressed(uint8_t key);                // Press since the last call
+    bool wasKeyReleased(uint8_t key);               // Release since the last call
+    uint8_t getKeys();                              // Debounced state (bit n = key n)
+#endif
+    
+#if NJU3711_ENABLE_QUIET_WINDOW
+    // Quiet window for noise-sensitive work such as ADC sampling
+    void setQuietCallback(NJU3711_QuietCallback callback, uint16_t windowMicros = 0); // NULL = off
+    uint16_t getQuietSettle();                      // Digits dark before the last callback (microseconds)
+    uint16_t getQuietDuration();                    // Run time of the last callback
+    uint16_t getQuietWorst();                       // Longest callback run time
+    uint16_t getQuietOverruns();                    // Callbacks that ran past their window
+#endif
+    
+#if NJU3711_ENABLE_ENERGY_METER
+    // Current and energy estimation from actual segment on-time
+    NJU3711_EnergyMeter& getEnergyMeter() { return _energyMeter; }
+#endif
+    
     // Special displays
     bool displayError();        // Show "Err"
     bool displayDashes();       // Show "---"
@@ -111,6 +310,15 @@ public:
     // Get current value
     uint16_t getCurrentValue();
     
+    // Frame handoff for running update() on another core or thread
+    void enableFrameHandoff(bool enable = true);
+    bool isFrameHandoff();
+    void publishFrame();        // Make edits since the last publish visible
+    
+    // Whole frame as edited by the setters, e.g. to save and restore it
+    NJU3711_Frame getFrame();
+    void setFrame(const NJU3711_Frame& frame);  // With handoff, shown after publishFrame()
+    
     // Direct digit control (useful for testing)
     void selectDigit(uint8_t digit);
     void deselectAllDigits();
@@ -0,0 +1,117 @@
+/*
+ * NJU3711_Animator.cpp - 7-Segment Animation Engine Implementation
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_Animator.h"
+#include "NJU3711_Font.h"
+#include "NJU3711.h"
+
+#if NJU3711_ENABLE_ANIMATIONS
+// Animation frames, precomputed so each animation step is a table lookup
+const uint8_t ANIM_ROTATE_CW_FRAMES[] PROGMEM = {
+    0b10000000, // A
+    0b00100000, // B
+    0b00000100, // C
+    0b00000010, // D
+    0b00001000, // E
+    0b01000000  // F
+};
+
+const uint8_t ANIM_ROTATE_CCW_FRAMES[] PROGMEM = {
+    0b10000000, // A
+    0b01000000, // F
+    0b00001000, // E
+    0b00000010, // D
+    0b00000100, // C
+    0b00100000  // B
+};
+
+const uint8_t ANIM_CHASE_FRAMES[] PROGMEM = {
+    0b10100100, // ABC
+    0b00100110, // BCD
+    0b00001110, // CDE
+    0b01001010, // DEF
+    0b11001000, // EFA
+    0b11100000  // FAB
+};
+
+const uint8_t ANIM_LOADING_FRAMES[] PROGMEM = {
+    0b10000000, // A
+    0b10100000, // AB
+    0b10100100, // ABC
+    0b10100110, // ABCD
+    0b10101110, // ABCDE
+    0b11101110, // ABCDEF
+    0b11101110  // ABCDEF (hold)
+};
+
+NJU3711_Animator::NJU3711_Animator() {
+    _active = false;
+    _type = ANIM_ROTATE_CW;
+    _step = 0;
+    _value = 0;
+    _frameDelay = 100000;
+    _lastFrame = 0;
+}
+
+void NJU3711_Animator::start(AnimationType type, unsigned long frameDelay, unsigned long now) {
+    _type = type;
+    _frameDelay = frameDelay;
+    _step = 0;
+    _active = true;
+    _lastFrame = now;
+}
+
+bool NJU3711_Animator::nextFrame(unsigned long now, uint8_t& pattern) {
+    if (!_active) return false;
+    if ((now - _lastFrame) < _frameDelay) return false;
+    _lastFrame = now;
+    
+    // Each step is a single table lookup, so the cost does not depend on
+    // the animation type
+    switch (_type) {
+        case ANIM_ROTATE_CW:
+            // Rotate single segment clockwise
+            pattern = pgm_read_byte(&ANIM_ROTATE_CW_FRAMES[_step]);
+            _step = (_step + 1) % 6;
+            return true;
+        
+        case ANIM_ROTATE_CCW:
+            // Rotate single segment counter-clockwise
+            pattern = pgm_read_byte(&ANIM_ROTATE_CCW_FRAMES[_step]);
+            _step = (_step + 1) % 6;
+            return true;
+        
+        case ANIM_BLINK:
+            // Blink the current value
+            pattern = (_step == 0) ? NJU3711_Font::digit(_value) : NJU3711_Font::PATTERN_BLANK;
+            _step = !_step;
+            return true;
+        
+        case ANIM_CHASE:
+            // Chase segments around
+            pattern = pgm_read_byte(&ANIM_CHASE_FRAMES[_step]);
+            _step = (_step + 1) % 6;
+            return true;
+        
+        case ANIM_LOADING:
+            // Loading bar effect
+            pattern = pgm_read_byte(&ANIM_LOADING_FRAMES[_step % 7]);
+            _step++;
+            if (_step >= 12) _step = 0; // Reset after full cycle
+            return true;
+        
+        default:
+            return false;
+    }
+}
+
+unsigned long NJU3711_Animator::getTimeToNextFrame(unsigned long now) const {
+    if (!_active) return NJU3711_NO_EVENT;
+    unsigned long elapsed = now - _lastFrame;
+    return (elapsed >= _frameDelay) ? 0 : (_frameDelay - elapsed);
+}
+#endif
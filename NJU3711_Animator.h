@@ -0,0 +1,57 @@
+/*
+ * NJU3711_Animator.h - 7-Segment Animation Engine
+ * 
+ * Steps through the built-in animations and hands out one active-high
+ * segment pattern per frame. It never writes to hardware itself, so the
+ * same animations run on any output the caller writes the pattern to.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_ANIMATOR_H
+#define NJU3711_ANIMATOR_H
+
+#include <Arduino.h>
+#include "NJU3711_Config.h"
+
+// Animation types for effects
+enum AnimationType : uint8_t {
+    ANIM_ROTATE_CW,     // Clockwise rotation
+    ANIM_ROTATE_CCW,    // Counter-clockwise rotation
+    ANIM_BLINK,         // Blinking digit
+    ANIM_FADE,          // Fade in/out effect
+    ANIM_CHASE,         // Chase segments
+    ANIM_LOADING        // Loading bar effect
+};
+
+#if NJU3711_ENABLE_ANIMATIONS
+class NJU3711_Animator {
+private:
+    bool _active;
+    AnimationType _type;
+    uint8_t _step;
+    uint8_t _value;                 // Digit shown by ANIM_BLINK
+    unsigned long _frameDelay;      // Microseconds between frames
+    unsigned long _lastFrame;
+
+public:
+    NJU3711_Animator();
+    
+    void start(AnimationType type, unsigned long frameDelay, unsigned long now);
+    void stop() { _active = false; }
+    bool isActive() const { return _active; }
+    
+    // Digit used by ANIM_BLINK (default 0)
+    void setValue(uint8_t value) { _value = value; }
+    
+    // If a frame is due at 'now', store its pattern and return true.
+    // Frames with no output (ANIM_FADE) still advance the timer.
+    bool nextFrame(unsigned long now, uint8_t& pattern);
+    
+    // Microseconds until the next frame, or NJU3711_NO_EVENT when stopped
+    unsigned long getTimeToNextFrame(unsigned long now) const;
+};
+#endif
+
+#endif // NJU3711_ANIMATOR_H
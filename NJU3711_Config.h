@@ -0,0 +1,121 @@
+/*
+ * NJU3711_Config.h - Compile-time configuration
+ * 
+ * Arduino compiles library sources separately from the sketch, so options
+ * defined in a sketch do not reach the library. Edit the defaults below, or
+ * pass them as build flags (e.g. -DNJU3711_ENABLE_LOAD_METER=0).
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_CONFIG_H
+#define NJU3711_CONFIG_H
+
+// Feature selection - set a feature to 0 to compile it out entirely.
+// extras/footprint_report.sh shows the flash/RAM cost of each feature.
+
+// Test patterns: startTestPattern()
+#ifndef NJU3711_ENABLE_TEST_PATTERNS
+#define NJU3711_ENABLE_TEST_PATTERNS 1
+#endif
+
+// Animations (NJU3711_7Segment): startAnimation(), test(), countdown(), countup()
+#ifndef NJU3711_ENABLE_ANIMATIONS
+#define NJU3711_ENABLE_ANIMATIONS 1
+#endif
+
+// Operation queue. With 0 the driver runs in direct mode: one operation
+// can be pending, and further writes fail until it has been started.
+#ifndef NJU3711_ENABLE_QUEUE
+#define NJU3711_ENABLE_QUEUE 1
+#endif
+
+// Queue depth when the queue is enabled (a power of two is cheapest)
+#ifndef NJU3711_QUEUE_SIZE
+#if NJU3711_ENABLE_QUEUE
+#define NJU3711_QUEUE_SIZE 8
+#else
+#define NJU3711_QUEUE_SIZE 1
+#endif
+#endif
+
+// Statistics - master switch for the load meter and other counters
+#ifndef NJU3711_ENABLE_STATISTICS
+#define NJU3711_ENABLE_STATISTICS 1
+#endif
+
+// Deadline writes: write(data, deadlineMicros) admits a write only if it
+// can latch in time and runs timed writes earliest deadline first.
+// Costs 4 bytes RAM per queue slot
+#ifndef NJU3711_ENABLE_DEADLINES
+#define NJU3711_ENABLE_DEADLINES 0
+#endif
+
+// Load meter: time spent inside update() versus wall time
+// Costs a few micros() calls per update() and ~130 bytes RAM per instance
+#ifndef NJU3711_ENABLE_LOAD_METER
+#define NJU3711_ENABLE_LOAD_METER NJU3711_ENABLE_STATISTICS
+#endif
+
+// Sub-windows of the load meter's sliding window. Results move on by one
+// sub-window at a time; each one costs 24 bytes RAM on AVR.
+#ifndef NJU3711_LOAD_METER_SLOTS
+#define NJU3711_LOAD_METER_SLOTS 4
+#endif
+
+// Scrubber: setScrubInterval() re-shifts and re-latches the outputs at a
+// low rate while the bus is idle, repairing latches upset by noise
+#ifndef NJU3711_ENABLE_SCRUBBER
+#define NJU3711_ENABLE_SCRUBBER 1
+#endif
+
+// Adaptive refresh (NJU3711_7Segment_Multi): setRefreshPolicy() can stop
+// the scan when nothing is visible and slow it down for static content
+#ifndef NJU3711_ENABLE_ADAPTIVE_REFRESH
+#define NJU3711_ENABLE_ADAPTIVE_REFRESH 1
+#endif
+
+// Peak-current limit (NJU3711_7Segment_Multi): setSegmentBudget() caps the
+// number of segments lit at once by splitting glyphs into subframes
+#ifndef NJU3711_ENABLE_SEGMENT_BUDGET
+#define NJU3711_ENABLE_SEGMENT_BUDGET 1
+#endif
+
+// Dimming (NJU3711_7Segment_Multi): setBrightness() gates the digit drivers
+// with hardware PWM where the pin supports it, in software elsewhere
+#ifndef NJU3711_ENABLE_DIMMING
+#define NJU3711_ENABLE_DIMMING 1
+#endif
+
+// Keypad (NJU3711_7Segment_Multi): beginKeypad() reads one key per digit
+// through a shared return pin at the end of each digit slot
+#ifndef NJU3711_ENABLE_KEYPAD
+#define NJU3711_ENABLE_KEYPAD 1
+#endif
+
+// Keypad: how long a PWM gated digit line is held LOW before its key is
+// read, so the return line has left the PWM off phase (microseconds)
+#ifndef NJU3711_KEY_SETTLE_MICROS
+#define NJU3711_KEY_SETTLE_MICROS 10
+#endif
+
+// Quiet window (NJU3711_7Segment_Multi): setQuietCallback() runs a callback
+// once per frame while every digit is dark and the bus is idle
+#ifndef NJU3711_ENABLE_QUIET_WINDOW
+#define NJU3711_ENABLE_QUIET_WINDOW 1
+#endif
+
+// 7-segment font for hex digits A-F and letters. Digits 0-9, '-', '_'
+// and ' ' are always available.
+#ifndef NJU3711_ENABLE_FONT
+#define NJU3711_ENABLE_FONT 1
+#endif
+
+// Energy meter (NJU3711_7Segment_Multi): estimates display current from
+// the time each segment is actually lit. Off by default, ~220 bytes RAM
+#ifndef NJU3711_ENABLE_ENERGY_METER
+#define NJU3711_ENABLE_ENERGY_METER 0
+#endif
+
+#endif // NJU3711_CONFIG_H
@@ -0,0 +1,336 @@
+/*
+ * NJU3711_Console.cpp - Runtime Tuning Console and Telemetry
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_Console.h"
+
+// Characters taken from the stream per update() call
+#define NJU3711_CONSOLE_READ_BUDGET 16
+
+const char CONSOLE_HELP[] PROGMEM =
+    "step|mux|blank <us>\n"
+    "bright <0-255>, dim auto|soft\n"
+    "budget <segments>\n"
+    "policy fixed|suspend|adaptive, floor <hz>\n"
+    "tele <ms>, get";
+
+// Compare the first 'length' characters of 'text' with a whole word
+static bool isWord(const char* text, uint8_t length, const char* word) {
+    return strlen(word) == length && strncmp(text, word, length) == 0;
+}
+
+// Parse a decimal number that makes up the rest of the line
+static bool parseUnsigned(const char* text, unsigned long& value) {
+    if (*text < '0' || *text > '9') return false;
+    
+    value = 0;
+    while (*text >= '0' && *text <= '9') {
+        value = value * 10 + (*text - '0');
+        text++;
+    }
+    while (*text == ' ') text++;
+    return *text == '\0';
+}
+
+NJU3711_Console::NJU3711_Console(NJU3711_7Segment_Multi& display, Stream& stream)
+    : _display(display), _stream(stream) {
+    _lineLength = 0;
+    _lineOverflow = false;
+    _outputHead = 0;
+    _outputLength = 0;
+    _outputLineStart = 0;
+    _outputOverflow = false;
+    _reportsRoom = false;
+    _droppedLines = 0;
+    _telemetryPeriod = 0;
+    _lastTelemetry = 0;
+    _lastFrameCount = 0;
+}
+
+// A serial port reports its free transmit buffer, so 0 means full
+NJU3711_Console::NJU3711_Console(NJU3711_7Segment_Multi& display, HardwareSerial& serial)
+    : NJU3711_Console(display, (Stream&)serial) {
+    _reportsRoom = true;
+}
+
+void NJU3711_Console::update() {
+    receive();
+    
+    if (_telemetryPeriod > 0) {
+        unsigned long now = millis();
+        if ((now - _lastTelemetry) >= _telemetryPeriod) {
+            sendTelemetry(now);
+        }
+    }
+    
+    transmit();
+}
+
+// Collect input up to the read budget, handling at most one line per call.
+// A new command is only read once the previous reply has been sent, so
+// replies are not lost; input waits in the stream's receive buffer.
+void NJU3711_Console::receive() {
+    if (_outputLength != 0) return;
+    
+    for (uint8_t budget = NJU3711_CONSOLE_READ_BUDGET; budget > 0; budget--) {
+        if (_stream.available() <= 0) return;
+        int c = _stream.read();
+        if (c < 0) return;
+        
+        if (c == '\r' || c == '\n') {
+            if (_lineLength == 0 && !_lineOverflow) continue; // Empty line or CRLF
+            
+            _line[_lineLength] = '\0';
+            if (_lineOverflow) {
+                beginLine();
+                put("err too long");
+                endLine();
+            } else {
+                execute(_line);
+            }
+            _lineLength = 0;
+            _lineOverflow = false;
+            return;
+        }
+        
+        if (_lineLength < NJU3711_CONSOLE_LINE - 1) {
+            _line[_lineLength++] = (char)c;
+        } else {
+            _lineOverflow = true;
+        }
+    }
+}
+
+// Send as much pending output as the stream takes without blocking.
+// Streams without availableForWrite() report 0 forever; they get one
+// byte per call, so a slow one can only stall update() briefly.
+void NJU3711_Console::transmit() {
+    uint8_t pending = _outputLength - _outputHead;
+    if (pending == 0) return;
+    
+    int room = _stream.availableForWrite();
+    if (room > 0) {
+        _reportsRoom = true;
+    } else if (_reportsRoom) {
+        return;                 // Transmit buffer full
+    } else {
+        room = 1;
+    }
+    if ((unsigned int)room < pending) pending = (uint8_t)room;
+    
+    _stream.write((const uint8_t*)&_output[_outputHead], pending);
+    _outputHead += pending;
+    if (_outputHead == _outputLength) {
+        _outputHead = 0;
+        _outputLength = 0;
+    }
+}
+
+bool NJU3711_Console::execute(const char* line) {
+    // Split into command word and argument
+    while (*line == ' ') line++;
+    const char* argument = line;
+    while (*argument != '\0' && *argument != ' ') argument++;
+    uint8_t length = argument - line;
+    while (*argument == ' ') argument++;
+    
+    unsigned long value = 0;
+    bool number = parseUnsigned(argument, value);
+    bool ok = true;
+    
+    if (isWord(line, length, "?")) {
+        sendHelp();
+        return true;
+    } else if (isWord(line, length, "get")) {
+        // Settings are sent below
+    } else if (isWord(line, length, "step") && number) {
+        _display.setStepDelay(value);
+    } else if (isWord(line, length, "mux") && number && value > 0) {
+        ok = _display.setMultiplexDelay(value);
+    } else if (isWord(line, length, "blank") && number) {
+        ok = _display.setBlankingTime(value);
+    } else if (isWord(line, length, "tele") && number) {
+        setTelemetryPeriod(value);
+#if NJU3711_ENABLE_DIMMING
+    } else if (isWord(line, length, "bright") && number && value <= 255) {
+        _display.setBrightness((uint8_t)value);
+    } else if (isWord(line, length, "dim") && strcmp(argument, "auto") == 0) {
+        _display.setDimmingMode(NJU3711_DIM_AUTO);
+    } else if (isWord(line, length, "dim") && strcmp(argument, "soft") == 0) {
+        _display.setDimmingMode(NJU3711_DIM_SOFTWARE);
+#endif
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    } else if (isWord(line, length, "budget") && number && value <= 8) {
+        _display.setSegmentBudget((uint8_t)value);
+#endif
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    } else if (isWord(line, length, "policy") && strcmp(argument, "fixed") == 0) {
+        _display.setRefreshPolicy(NJU3711_REFRESH_FIXED);
+    } else if (isWord(line, length, "policy") && strcmp(argument, "suspend") == 0) {
+        _display.setRefreshPolicy(NJU3711_REFRESH_SUSPEND);
+    } else if (isWord(line, length, "policy") && strcmp(argument, "adaptive") == 0) {
+        _display.setRefreshPolicy(NJU3711_REFRESH_ADAPTIVE);
+    } else if (isWord(line, length, "floor") && number && value <= 255) {
+        _display.setFlickerFloor((uint8_t)value);
+#endif
+    } else {
+        ok = false;
+    }
+    
+    if (ok) {
+        sendSettings();
+    } else {
+        beginLine();
+        put("err ");
+        put(line);
+        endLine();
+    }
+    return ok;
+}
+
+void NJU3711_Console::setTelemetryPeriod(unsigned long periodMillis) {
+    _telemetryPeriod = periodMillis;
+    _lastTelemetry = millis();
+    _lastFrameCount = _display.getFrameCount();
+}
+
+unsigned long NJU3711_Console::getTelemetryPeriod() {
+    return _telemetryPeriod;
+}
+
+unsigned long NJU3711_Console::getDroppedLines() {
+    return _droppedLines;
+}
+
+// "T hz=166 duty=30.41 q=0 load=1.52" - refresh rate of the whole display,
+// lit share of each digit slot, queue depth and update() load
+void NJU3711_Console::sendTelemetry(unsigned long now) {
+    uint16_t frames = _display.getFrameCount();
+    uint16_t scans = frames - _lastFrameCount;
+    unsigned long elapsed = now - _lastTelemetry;
+    _lastFrameCount = frames;
+    _lastTelemetry = now;
+    if (elapsed == 0) return;
+    
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    unsigned long lit = _display.getScanDelay();
+#else
+    unsigned long lit = _display.getMultiplexDelay();
+#endif
+#if NJU3711_ENABLE_DIMMING
+    lit = (lit * _display.getBrightness()) / 255;
+#endif
+    
+    beginLine();
+    put('T');
+    putField(" hz=", (scans * 1000UL) / elapsed);
+    put(" duty=");
+    putFixed((lit * (float)scans) / (elapsed * 10.0));
+    putField(" q=", _display.getQueueSize());
+#if NJU3711_ENABLE_LOAD_METER
+    put(" load=");
+    putFixed(_display.getLoadMeter().getLoadPercent());
+#endif
+    endLine();
+}
+
+// "S step=1 mux=2000 blank=50 ..." - current settings
+void NJU3711_Console::sendSettings() {
+    beginLine();
+    put('S');
+    putField(" step=", _display.getStepDelay());
+    putField(" mux=", _display.getMultiplexDelay());
+    putField(" blank=", _display.getBlankingTime());
+#if NJU3711_ENABLE_DIMMING
+    putField(" bright=", _display.getBrightness());
+    put((_display.getDimmingMode() == NJU3711_DIM_AUTO) ? " dim=auto" : " dim=soft");
+#endif
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+    putField(" budget=", _display.getSegmentBudget());
+#endif
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    switch (_display.getRefreshPolicy()) {
+        case NJU3711_REFRESH_FIXED:    put(" policy=fixed"); break;
+        case NJU3711_REFRESH_SUSPEND:  put(" policy=suspend"); break;
+        case NJU3711_REFRESH_ADAPTIVE: put(" policy=adaptive"); break;
+    }
+#endif
+    putField(" tele=", _telemetryPeriod);
+    endLine();
+}
+
+void NJU3711_Console::sendHelp() {
+    beginLine();
+    putProgmem(CONSOLE_HELP);
+    endLine();
+}
+
+// Start a line after moving unsent output to the front of the buffer
+void NJU3711_Console::beginLine() {
+    if (_outputHead > 0) {
+        memmove(_output, &_output[_outputHead], _outputLength - _outputHead);
+        _outputLength -= _outputHead;
+        _outputHead = 0;
+    }
+    _outputLineStart = _outputLength;
+    _outputOverflow = false;
+}
+
+void NJU3711_Console::endLine() {
+    put('\n');
+    if (_outputOverflow) {
+        // Never send part of a line
+        _outputLength = _outputLineStart;
+        _droppedLines++;
+    }
+}
+
+void NJU3711_Console::put(char c) {
+    if (_outputLength < NJU3711_CONSOLE_OUTPUT) {
+        _output[_outputLength++] = c;
+    } else {
+        _outputOverflow = true;
+    }
+}
+
+void NJU3711_Console::put(const char* text) {
+    while (*text != '\0') {
+        put(*text++);
+    }
+}
+
+void NJU3711_Console::putProgmem(const char* text) {
+    char c;
+    while ((c = (char)pgm_read_byte(text++)) != '\0') {
+        put(c);
+    }
+}
+
+void NJU3711_Console::putNumber(unsigned long value) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        put(digits[--count]);
+    }
+}
+
+void NJU3711_Console::putFixed(float value) {
+    if (value < 0) value = 0;
+    unsigned long hundredths = (unsigned long)(value * 100.0 + 0.5);
+    putNumber(hundredths / 100);
+    put('.');
+    put('0' + (hundredths / 10) % 10);
+    put('0' + hundredths % 10);
+}
+
+void NJU3711_Console::putField(const char* name, unsigned long value) {
+    put(name);
+    putNumber(value);
+}
@@ -0,0 +1,92 @@
+/*
+ * NJU3711_Console.h - Runtime Tuning Console and Telemetry
+ * 
+ * Line-based command console for NJU3711_7Segment_Multi over any Stream
+ * (usually Serial). Timing, brightness and scan strategy can be changed
+ * at runtime, and a compact telemetry line is sent at a fixed rate.
+ * 
+ * update() never blocks: it reads only what has arrived, handles at most
+ * one command per call, and writes only as much output as the stream
+ * accepts without waiting (availableForWrite()). A stream that never
+ * reports free space (availableForWrite() always 0) gets one byte per
+ * call. Output that does not fit the buffer is dropped line by line and
+ * counted.
+ * 
+ * Commands (one per line):
+ *   step <us>      mux <us>      blank <us>
+ *   bright <0-255> dim auto|soft budget <n>
+ *   policy fixed|suspend|adaptive   floor <hz>
+ *   tele <ms>      get           ?
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_CONSOLE_H
+#define NJU3711_CONSOLE_H
+
+#include <Arduino.h>
+#include "NJU3711_7Segment_Multi.h"
+
+#define NJU3711_CONSOLE_LINE 24     // Longest command line
+#define NJU3711_CONSOLE_OUTPUT 128  // Output buffer, at least one full line
+
+class NJU3711_Console {
+private:
+    NJU3711_7Segment_Multi& _display;
+    Stream& _stream;
+    
+    // Input line being received
+    char _line[NJU3711_CONSOLE_LINE];
+    uint8_t _lineLength;
+    bool _lineOverflow;
+    
+    // Pending output - bytes [_outputHead, _outputLength) are unsent
+    char _output[NJU3711_CONSOLE_OUTPUT];
+    uint8_t _outputHead;
+    uint8_t _outputLength;
+    uint8_t _outputLineStart;
+    bool _outputOverflow;
+    bool _reportsRoom;              // availableForWrite() gives real free space
+    unsigned long _droppedLines;
+    
+    // Telemetry
+    unsigned long _telemetryPeriod;     // Milliseconds, 0 = off
+    unsigned long _lastTelemetry;
+    uint16_t _lastFrameCount;
+    
+    void receive();
+    void transmit();
+    void sendTelemetry(unsigned long now);
+    void sendSettings();
+    void sendHelp();
+    
+    // Build one output line; endLine() drops it if it did not fit
+    void beginLine();
+    void endLine();
+    void put(char c);
+    void put(const char* text);
+    void putProgmem(const char* text);
+    void putNumber(unsigned long value);
+    void putFixed(float value);     // Two decimals
+    void putField(const char* name, unsigned long value);
+
+public:
+    NJU3711_Console(NJU3711_7Segment_Multi& display, Stream& stream);
+    NJU3711_Console(NJU3711_7Segment_Multi& display, HardwareSerial& serial);
+    
+    // Call regularly in loop(), next to display.update()
+    void update();
+    
+    // Run one command line, as if it had been received
+    bool execute(const char* line);
+    
+    // Telemetry rate
+    void setTelemetryPeriod(unsigned long periodMillis);   // 0 = off (default)
+    unsigned long getTelemetryPeriod();
+    
+    // Output lines lost because the stream was too slow
+    unsigned long getDroppedLines();
+};
+
+#endif // NJU3711_CONSOLE_H
@@ -0,0 +1,177 @@
+/*
+ * NJU3711_Display.h - Static Dispatch for Generic Display Code
+ *
+ * The display classes extend each other without virtual functions, and
+ * each level hides its parent's update() and display methods. Code that
+ * holds a base class reference therefore calls the wrong methods, and
+ * the overloads differ between levels (setDecimalPoint(bool) on a single
+ * digit, setDecimalPoint(position, bool) on the multiplexed display).
+ *
+ * NJU3711_Display<Display> resolves every call against the concrete
+ * display type at compile time through NJU3711_DisplayTraits<Display>.
+ * There is no vtable and each call inlines into the underlying method.
+ * Write generic managers and effects as templates over NJU3711_Display
+ * (or over the display type itself) instead of taking base references.
+ *
+ * Digit positions count from 0 = rightmost digit on every display type.
+ *
+ * To drive your own display class, specialise NJU3711_DisplayTraits for it.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_DISPLAY_H
+#define NJU3711_DISPLAY_H
+
+#include <Arduino.h>
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_SegmentRenderer.h"
+
+// Maps the common display operations onto each class's own methods.
+// Deliberately left undefined so unsupported types fail to compile.
+template <class Display>
+struct NJU3711_DisplayTraits;
+
+// Bare expander: the 8 outputs are one raw "digit"
+template <>
+struct NJU3711_DisplayTraits<NJU3711> {
+    static const uint8_t DIGITS = 1;
+
+    static bool showNumber(NJU3711& display, int value) {
+        if (value < 0 || value > 255) return false;
+        return display.write((uint8_t)value);
+    }
+    static bool showRaw(NJU3711& display, uint8_t position, uint8_t pattern) {
+        if (position != 0) return false;
+        return display.write(pattern);
+    }
+    static bool showError(NJU3711& display) {
+        (void)display;
+        return false;
+    }
+    static bool setDecimalPoint(NJU3711& display, uint8_t position, bool state) {
+        (void)display; (void)position; (void)state;
+        return false;
+    }
+    static bool blank(NJU3711& display) {
+        return display.clear();
+    }
+};
+
+// Single 7-segment digit
+template <>
+struct NJU3711_DisplayTraits<NJU3711_7Segment> {
+    static const uint8_t DIGITS = 1;
+
+    static bool showNumber(NJU3711_7Segment& display, int value) {
+        if (value < 0 || value > 9) return display.displayError();
+        return display.displayDigit((uint8_t)value);
+    }
+    static bool showRaw(NJU3711_7Segment& display, uint8_t position, uint8_t pattern) {
+        if (position != 0) return false;
+        return display.displayRaw(pattern);
+    }
+    static bool showError(NJU3711_7Segment& display) {
+        return display.displayError();
+    }
+    static bool setDecimalPoint(NJU3711_7Segment& display, uint8_t position, bool state) {
+        if (position != 0) return false;
+        return display.setDecimalPoint(state);
+    }
+    static bool blank(NJU3711_7Segment& display) {
+        return display.displayBlank();
+    }
+};
+
+// Multiplexed 3-digit display
+template <>
+struct NJU3711_DisplayTraits<NJU3711_7Segment_Multi> {
+    static const uint8_t DIGITS = 3;
+
+    static bool showNumber(NJU3711_7Segment_Multi& display, int value) {
+        if (value < -99 || value > 999) return display.displayError();
+        if (value >= 0) return display.displayNumber((uint16_t)value);
+        
+        // Negative values: minus sign in the leftmost digit
+        value = -value;
+        display.setDigitChar(2, '-');
+        display.setDigit(1, value / 10);
+        display.setDigit(0, value % 10);
+        if (value < 10) display.disableDigit(1);
+        return true;
+    }
+    static bool showRaw(NJU3711_7Segment_Multi& display, uint8_t position, uint8_t pattern) {
+        return display.setDigitRaw(position, pattern);
+    }
+    static bool showError(NJU3711_7Segment_Multi& display) {
+        return display.displayError();
+    }
+    static bool setDecimalPoint(NJU3711_7Segment_Multi& display, uint8_t position, bool state) {
+        return display.setDecimalPoint(position, state);
+    }
+    static bool blank(NJU3711_7Segment_Multi& display) {
+        display.disableAllDigits();
+        return true;
+    }
+};
+
+// Single digit rendered on any byte sink
+template <class Sink>
+struct NJU3711_DisplayTraits<NJU3711_SegmentRenderer<Sink> > {
+    typedef NJU3711_SegmentRenderer<Sink> Display;
+    static const uint8_t DIGITS = 1;
+
+    static bool showNumber(Display& display, int value) {
+        if (value < 0 || value > 9) return display.displayError();
+        return display.displayDigit((uint8_t)value);
+    }
+    static bool showRaw(Display& display, uint8_t position, uint8_t pattern) {
+        if (position != 0) return false;
+        return display.displayRaw(pattern);
+    }
+    static bool showError(Display& display) {
+        return display.displayError();
+    }
+    static bool setDecimalPoint(Display& display, uint8_t position, bool state) {
+        if (position != 0) return false;
+        return display.setDecimalPoint(state);
+    }
+    static bool blank(Display& display) {
+        return display.displayBlank();
+    }
+};
+
+// Uniform, statically dispatched view of any supported display
+template <class Display, class Traits = NJU3711_DisplayTraits<Display> >
+class NJU3711_Display {
+private:
+    Display& _display;
+
+public:
+    static const uint8_t DIGITS = Traits::DIGITS;
+
+    explicit NJU3711_Display(Display& display) : _display(display) {}
+
+    // The wrapped display, for type-specific calls
+    Display& device() { return _display; }
+
+    // Always the concrete type's update(), never a hidden base version
+    void update() { _display.update(); }
+    unsigned long getTimeToNextEvent() { return _display.getTimeToNextEvent(); }
+    bool isBusy() { return _display.isBusy(); }
+
+    bool showNumber(int value) { return Traits::showNumber(_display, value); }
+    bool showRaw(uint8_t position, uint8_t pattern) { return Traits::showRaw(_display, position, pattern); }
+    bool showError() { return Traits::showError(_display); }
+    bool setDecimalPoint(uint8_t position, bool state) { return Traits::setDecimalPoint(_display, position, state); }
+    bool blank() { return Traits::blank(_display); }
+};
+
+// Deduce the display type: auto view = NJU3711_makeDisplay(display);
+template <class Display>
+inline NJU3711_Display<Display> NJU3711_makeDisplay(Display& display) {
+    return NJU3711_Display<Display>(display);
+}
+
+#endif // NJU3711_DISPLAY_H
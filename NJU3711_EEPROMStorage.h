@@ -0,0 +1,64 @@
+/*
+ * NJU3711_EEPROMStorage.h - Arduino EEPROM Storage for the Frame Store
+ *
+ * Stores the frame store's records in the Arduino EEPROM library.
+ *
+ * On AVR boards each byte takes about 3.3ms to program. isReady()
+ * reports when the previous byte has finished, so the frame store
+ * writes one byte per update() and never waits for the EEPROM.
+ *
+ * On ESP8266, ESP32 and RP2040 the EEPROM is emulated in flash: writes
+ * go to a RAM copy and commit() writes the flash sector, which blocks
+ * for a few milliseconds once per saved record.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_EEPROMSTORAGE_H
+#define NJU3711_EEPROMSTORAGE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#if defined(ESP8266) || defined(ESP32) || defined(ARDUINO_ARCH_RP2040)
+#define NJU3711_EEPROM_EMULATED 1
+#else
+#define NJU3711_EEPROM_EMULATED 0
+#endif
+
+class NJU3711_EEPROMStorage {
+public:
+    void begin(uint16_t size) {
+#if NJU3711_EEPROM_EMULATED
+        EEPROM.begin(size);
+#endif
+    }
+
+    uint8_t read(uint16_t address) {
+        return EEPROM.read(address);
+    }
+
+    bool isReady() {
+#if defined(__AVR__)
+        return eeprom_is_ready();
+#else
+        return true;
+#endif
+    }
+
+    void write(uint16_t address, uint8_t value) {
+        // Unchanged bytes cost no wear
+        if (EEPROM.read(address) != value) {
+            EEPROM.write(address, value);
+        }
+    }
+
+    void commit() {
+#if NJU3711_EEPROM_EMULATED
+        EEPROM.commit();
+#endif
+    }
+};
+
+#endif // NJU3711_EEPROMSTORAGE_H
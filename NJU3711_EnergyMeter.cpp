@@ -0,0 +1,148 @@
+/*
+ * NJU3711_EnergyMeter.cpp - Display Current and Energy Estimation
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_EnergyMeter.h"
+
+// Microamp-microseconds per milliamp-hour
+#define NJU3711_UAUS_PER_MAH 3600000000000.0
+
+NJU3711_EnergyMeter::NJU3711_EnergyMeter() {
+    _windowLength = 1000000; // 1s default
+    setSegmentCurrent(10000); // 10mA per segment default
+    reset();
+}
+
+void NJU3711_EnergyMeter::reset() {
+    _windowStart = micros();
+    _windowCharge = 0;
+    _totalCharge = 0;
+    _peakCurrent = 0;
+    _lastAverage = 0;
+    _lastWindow = 0;
+    for (int d = 0; d < NJU3711_ENERGY_DIGITS; d++) {
+        _digitOnTime[d] = 0;
+        _lastDigitDuty[d] = 0;
+        for (int s = 0; s < 8; s++) {
+            _segmentOnTime[d][s] = 0;
+            _lastSegmentDuty[d][s] = 0;
+        }
+    }
+}
+
+void NJU3711_EnergyMeter::setWindow(unsigned long windowMicros) {
+    _windowLength = windowMicros;
+}
+
+void NJU3711_EnergyMeter::setSegmentCurrent(uint16_t microamps) {
+    for (int s = 0; s < 8; s++) {
+        _segmentCurrent[s] = microamps;
+    }
+}
+
+void NJU3711_EnergyMeter::setSegmentCurrent(uint8_t segment, uint16_t microamps) {
+    if (segment < 8) {
+        _segmentCurrent[segment] = microamps;
+    }
+}
+
+uint16_t NJU3711_EnergyMeter::getSegmentCurrent(uint8_t segment) {
+    return (segment < 8) ? _segmentCurrent[segment] : 0;
+}
+
+unsigned long NJU3711_EnergyMeter::getCurrentFor(uint8_t segments) {
+    unsigned long current = 0;
+    for (uint8_t s = 0; s < 8; s++) {
+        if (segments & (1 << s)) {
+            current += _segmentCurrent[s];
+        }
+    }
+    return current;
+}
+
+void NJU3711_EnergyMeter::addOnTime(uint8_t digit, uint8_t segments, unsigned long duration) {
+    if (digit >= NJU3711_ENERGY_DIGITS) return;
+    
+    _digitOnTime[digit] += duration;
+    for (uint8_t s = 0; s < 8; s++) {
+        if (segments & (1 << s)) {
+            _segmentOnTime[digit][s] += duration;
+        }
+    }
+    
+    unsigned long current = getCurrentFor(segments);
+    if (current > _peakCurrent) {
+        _peakCurrent = current;
+    }
+    uint64_t charge = (uint64_t)current * duration;
+    _windowCharge += charge;
+    _totalCharge += charge;
+    
+    update();
+}
+
+void NJU3711_EnergyMeter::update() {
+    unsigned long now = micros();
+    if (isWindowDue(now)) {
+        finishWindow(now);
+    }
+}
+
+bool NJU3711_EnergyMeter::isWindowDue(unsigned long now) {
+    return (now - _windowStart) >= _windowLength;
+}
+
+// Duty in 1/100 percent. A span booked when it ends can have started in
+// the previous window, so the on-time may exceed the window.
+static uint16_t dutyOf(unsigned long onTime, unsigned long window) {
+    uint64_t duty = ((uint64_t)onTime * 10000) / window;
+    return (duty > 10000) ? 10000 : (uint16_t)duty;
+}
+
+// Window complete - convert on-times to duty cycles and start a new one
+void NJU3711_EnergyMeter::finishWindow(unsigned long now) {
+    unsigned long window = now - _windowStart;
+    if (window == 0) return; // setWindow(0) - nothing to average yet
+    
+    for (int d = 0; d < NJU3711_ENERGY_DIGITS; d++) {
+        _lastDigitDuty[d] = dutyOf(_digitOnTime[d], window);
+        _digitOnTime[d] = 0;
+        for (int s = 0; s < 8; s++) {
+            _lastSegmentDuty[d][s] = dutyOf(_segmentOnTime[d][s], window);
+            _segmentOnTime[d][s] = 0;
+        }
+    }
+    _lastAverage = (unsigned long)(_windowCharge / window);
+    _windowCharge = 0;
+    _lastWindow = window;
+    _windowStart = now;
+}
+
+float NJU3711_EnergyMeter::getAverageCurrent() {
+    return _lastAverage / 1000.0;
+}
+
+float NJU3711_EnergyMeter::getDigitDuty(uint8_t digit) {
+    if (digit >= NJU3711_ENERGY_DIGITS) return 0.0;
+    return _lastDigitDuty[digit] / 100.0;
+}
+
+float NJU3711_EnergyMeter::getSegmentDuty(uint8_t digit, uint8_t segment) {
+    if (digit >= NJU3711_ENERGY_DIGITS || segment >= 8) return 0.0;
+    return _lastSegmentDuty[digit][segment] / 100.0;
+}
+
+unsigned long NJU3711_EnergyMeter::getWindowMicros() {
+    return _lastWindow;
+}
+
+float NJU3711_EnergyMeter::getPeakCurrent() {
+    return _peakCurrent / 1000.0;
+}
+
+float NJU3711_EnergyMeter::getConsumedmAh() {
+    return _totalCharge / NJU3711_UAUS_PER_MAH;
+}
@@ -0,0 +1,76 @@
+/*
+ * NJU3711_EnergyMeter.h - Display Current and Energy Estimation
+ * 
+ * Integrates how long each segment of each digit is lit and combines it
+ * with a per-segment current model, giving average and peak current and
+ * the charge consumed. NJU3711_7Segment_Multi feeds it from the scan; on
+ * a host, call addOnTime() directly to estimate a display offline.
+ * 
+ * Averages and duty cycles are reported for the last completed window.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_ENERGYMETER_H
+#define NJU3711_ENERGYMETER_H
+
+#include <Arduino.h>
+
+#define NJU3711_ENERGY_DIGITS 3
+
+class NJU3711_EnergyMeter {
+private:
+    uint16_t _segmentCurrent[8];    // Current per lit segment by bit position (microamps)
+    unsigned long _windowLength;    // Window length (microseconds)
+    unsigned long _windowStart;
+    
+    // Current window
+    unsigned long _digitOnTime[NJU3711_ENERGY_DIGITS];
+    unsigned long _segmentOnTime[NJU3711_ENERGY_DIGITS][8];
+    uint64_t _windowCharge;         // Microamp-microseconds
+    
+    // Last completed window, duty in 1/100 percent
+    uint16_t _lastDigitDuty[NJU3711_ENERGY_DIGITS];
+    uint16_t _lastSegmentDuty[NJU3711_ENERGY_DIGITS][8];
+    unsigned long _lastAverage;     // Microamps
+    unsigned long _lastWindow;
+    
+    // Since reset()
+    uint64_t _totalCharge;          // Microamp-microseconds
+    unsigned long _peakCurrent;     // Microamps
+    
+    void finishWindow(unsigned long now);
+
+public:
+    NJU3711_EnergyMeter();
+    
+    // Current model
+    void setSegmentCurrent(uint16_t microamps);                     // All segments, default 10000uA
+    void setSegmentCurrent(uint8_t segment, uint16_t microamps);    // One segment (SEG_A ... SEG_DP)
+    uint16_t getSegmentCurrent(uint8_t segment);
+    unsigned long getCurrentFor(uint8_t segments);                  // Microamps drawn while lit
+    
+    // Record 'segments' (active-high) lit on 'digit' for 'duration' microseconds
+    void addOnTime(uint8_t digit, uint8_t segments, unsigned long duration);
+    
+    // Roll the window - call regularly, also while nothing is lit
+    void update();
+    bool isWindowDue(unsigned long now);            // update() would roll the window at 'now'
+    
+    // Configuration
+    void setWindow(unsigned long windowMicros);    // Default 1000000us (1s)
+    void reset();
+    
+    // Results for the last completed window
+    float getAverageCurrent();                      // Milliamps
+    float getDigitDuty(uint8_t digit);              // Percent of the window the digit was on
+    float getSegmentDuty(uint8_t digit, uint8_t segment);
+    unsigned long getWindowMicros();
+    
+    // Results since reset()
+    float getPeakCurrent();                         // Milliamps
+    float getConsumedmAh();
+};
+
+#endif // NJU3711_ENERGYMETER_H
@@ -0,0 +1,113 @@
+/*
+ * NJU3711_Font.cpp - 7-Segment Font Implementation
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_Font.h"
+
+// 7-segment patterns for digits 0-9 
+// Using your specific pin mapping: A=P8(bit7), B=P6(bit5), C=P3(bit2), D=P2(bit1), E=P4(bit3), F=P7(bit6), G=P5(bit4), DP=P1(bit0)
+const uint8_t DIGIT_PATTERNS[] PROGMEM = {
+    0b11101110, // 0: ABCDEF
+    0b00100100, // 1: BC
+    0b10111010, // 2: ABDEG
+    0b10110110, // 3: ABCDG
+    0b01110100, // 4: BCFG
+    0b11010110, // 5: ACDFG
+    0b11011110, // 6: ACDEFG
+    0b10100100, // 7: ABC
+    0b11111110, // 8: ABCDEFG
+    0b11110110  // 9: ABCDFG
+};
+
+#if NJU3711_ENABLE_FONT
+// Hexadecimal patterns for A-F (using your pin mapping)
+const uint8_t HEX_PATTERNS[] PROGMEM = {
+    0b11111100, // A: ABCEFG
+    0b01011110, // b: CDEFG  
+    0b11001010, // C: ADEF
+    0b00111110, // d: BCDEG
+    0b11011010, // E: ADEFG
+    0b11011000  // F: AEFG
+};
+
+// Character patterns for common letters and symbols
+const uint8_t CHAR_PATTERNS[] PROGMEM = {
+    // Letters that can be displayed on 7-segment
+    0b11111100, // A
+    0b01011110, // b
+    0b11001010, // C
+    0b00111110, // d
+    0b11011010, // E
+    0b11011000, // F
+    0b00010000, // G
+    0b00010000, // H
+    0b00010000, // I
+    0b00010000, // J
+    0b00010000, // K (same as H)
+    0b00010000, // L
+    0b00010000, // M (approximation)
+    0b00010000, // n
+    0b00010000, // o
+    0b00010000, // P
+    0b00010000, // q
+    0b00011000, // r
+    0b00010000, // S
+    0b00010000, // t
+    0b00010000, // U
+    0b00010000, // V (same as U)
+    0b00010000, // W (same as U)
+    0b00010000, // X (same as H)
+    0b00010000, // y
+    0b00010000  // Z (same as 2)
+};
+#endif
+
+// Get digit pattern (0-9)
+uint8_t NJU3711_Font::digit(uint8_t digit) {
+    if (digit > 9) return PATTERN_BLANK;
+    return pgm_read_byte(&DIGIT_PATTERNS[digit]);
+}
+
+// Get hex pattern (0-F)
+uint8_t NJU3711_Font::hex(uint8_t hexValue) {
+    if (hexValue <= 9) {
+        return pgm_read_byte(&DIGIT_PATTERNS[hexValue]);
+    }
+#if NJU3711_ENABLE_FONT
+    if (hexValue <= 15) {
+        return pgm_read_byte(&HEX_PATTERNS[hexValue - 10]);
+    }
+#endif
+    return PATTERN_BLANK;
+}
+
+// Get character pattern
+uint8_t NJU3711_Font::character(char character) {
+    // Convert to uppercase
+    if (character >= 'a' && character <= 'z') {
+        character = character - 'a' + 'A';
+    }
+    
+    // Handle digits
+    if (character >= '0' && character <= '9') {
+        return digit(character - '0');
+    }
+    
+#if NJU3711_ENABLE_FONT
+    // Handle letters A-Z
+    if (character >= 'A' && character <= 'Z') {
+        return pgm_read_byte(&CHAR_PATTERNS[character - 'A']);
+    }
+#endif
+    
+    // Handle special characters
+    switch (character) {
+        case '-': return PATTERN_MINUS;
+        case '_': return PATTERN_UNDERSCORE;
+        case ' ': return PATTERN_BLANK;
+        default: return PATTERN_BLANK;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * NJU3711_Font.h - 7-Segment Font
+ * 
+ * Segment patterns for digits, hex digits, letters and symbols, shared
+ * by every 7-segment renderer regardless of how bytes reach the device.
+ * Patterns are active-high (bit set = segment on); applyMode() converts
+ * them for active-low wiring.
+ * 
+ * Bit Position: 7   6   5   4   3   2   1   0
+ * Shifts to   : P8  P7  P6  P5  P4  P3  P2  P1
+ * Segment     : A   F   B   G   E   C   D   DP
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_FONT_H
+#define NJU3711_FONT_H
+
+#include <Arduino.h>
+#include "NJU3711_Config.h"
+
+// Segment bit positions (matches your specific pin mapping)
+#define SEG_A   7  // P8
+#define SEG_B   5  // P6
+#define SEG_C   2  // P3
+#define SEG_D   1  // P2
+#define SEG_E   3  // P4
+#define SEG_F   6  // P7
+#define SEG_G   4  // P5
+#define SEG_DP  0  // P1
+
+// Display modes
+enum DisplayMode : uint8_t {
+    ACTIVE_LOW,        // LEDs light when output is LOW (your case)
+    ACTIVE_HIGH        // LEDs light when output is HIGH
+};
+
+class NJU3711_Font {
+public:
+    // Special character patterns (using your pin mapping)
+    static const uint8_t PATTERN_MINUS      = 0b00010000;  // G segment only (bit 4)
+    static const uint8_t PATTERN_UNDERSCORE = 0b00000010;  // D segment only (bit 1)
+    static const uint8_t PATTERN_DEGREE     = 0b11110000;  // ABFG segments
+    static const uint8_t PATTERN_BLANK      = 0b00000000;  // All segments off
+    static const uint8_t PATTERN_ALL        = 0b11111111;  // All segments on
+    static const uint8_t PATTERN_ERROR      = 0b11011010;  // E pattern
+    
+    // Pattern lookups (unknown values give PATTERN_BLANK)
+    static uint8_t digit(uint8_t digit);        // 0-9
+    static uint8_t hex(uint8_t hexValue);       // 0-F
+    static uint8_t character(char character);   // 0-9, A-Z, '-', '_', ' '
+    
+    // Convert an active-high pattern to the output level for the wiring
+    static uint8_t applyMode(uint8_t segments, DisplayMode mode) {
+        return (mode == ACTIVE_LOW) ? (uint8_t)~segments : segments;
+    }
+};
+
+#endif // NJU3711_FONT_H
@@ -0,0 +1,260 @@
+/*
+ * NJU3711_FrameStore.h - Instant-On Restore of the Last Frame
+ *
+ * Saves the frame of an NJU3711_7Segment_Multi, with its brightness and
+ * scan timing, to non-volatile storage. At the next boot begin() puts
+ * it back on the display before setup() continues, so the display shows
+ * its last content while the application is still starting.
+ *
+ * Saving is wear-aware:
+ * - Records rotate through a ring of slots, so each slot is written only
+ *   once per 'slots' saves.
+ * - A record is saved at most once per minimum interval (default 60s),
+ *   and only when the state differs from the last saved record.
+ * - Each record carries a sequence number and a CRC. A save cut short
+ *   by a reset leaves an invalid slot, and the previous record is used.
+ * - update() writes one byte per call, and only when the storage is
+ *   ready, so saving never blocks the display.
+ *
+ * The storage class is chosen at compile time (see NJU3711_Storage.h):
+ *
+ *   NJU3711_EEPROMStorage eeprom;
+ *   NJU3711_FrameStore<NJU3711_EEPROMStorage> store(display, eeprom);
+ *
+ *   void setup() {
+ *       store.begin();          // Instead of display.begin()
+ *   }
+ *
+ *   void loop() {
+ *       display.update();
+ *       store.update();
+ *   }
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_FRAMESTORE_H
+#define NJU3711_FRAMESTORE_H
+
+#include <Arduino.h>
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_Storage.h"
+
+template <class Storage>
+class NJU3711_FrameStore {
+public:
+    // Bytes per slot
+    static const uint8_t RECORD_SIZE = 13;
+
+private:
+    // Record layout
+    enum {
+        REC_MAGIC = 0,          // MAGIC when the record is valid
+        REC_SEQUENCE = 1,       // Increments with every save
+        REC_SEGMENTS = 2,       // Three digits
+        REC_DP_MASK = 5,
+        REC_ENABLED_MASK = 6,
+        REC_BRIGHTNESS = 7,
+        REC_MULTIPLEX = 8,      // Multiplex delay, low byte first
+        REC_BLANKING = 10,      // Blanking time, low byte first
+        REC_CRC = 12            // CRC-8 of the bytes before it
+    };
+    static const uint8_t MAGIC = 0x37;
+    static const uint8_t IDLE = 0xFF;
+
+    NJU3711_7Segment_Multi& _display;
+    Storage& _storage;
+    uint16_t _address;          // First byte of slot 0
+    uint8_t _slots;
+    uint8_t _nextSlot;          // Slot the next save goes to
+    uint8_t _record[RECORD_SIZE];   // Last saved or restored record, or the one being written
+    uint8_t _writeStep;         // Next byte to write, IDLE if not saving
+    bool _saved;                // _record holds the state in storage
+    bool _saveRequested;        // Save at the next update(), interval or not
+    unsigned long _lastSave;
+    unsigned long _minInterval; // Milliseconds
+    unsigned long _saveCount;
+
+    static uint8_t crc8(const uint8_t* data, uint8_t length) {
+        uint8_t crc = 0;
+        for (uint8_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    uint16_t slotAddress(uint8_t slot) {
+        return _address + (uint16_t)slot * RECORD_SIZE;
+    }
+
+    bool readSlot(uint8_t slot, uint8_t* record) {
+        for (uint8_t i = 0; i < RECORD_SIZE; i++) {
+            record[i] = _storage.read(slotAddress(slot) + i);
+        }
+        return record[REC_MAGIC] == MAGIC && record[REC_CRC] == crc8(record, REC_CRC);
+    }
+
+    void capture(uint8_t* record) {
+        NJU3711_Frame frame = _display.getFrame();
+        for (uint8_t i = 0; i < 3; i++) {
+            record[REC_SEGMENTS + i] = frame.segments[i];
+        }
+        record[REC_DP_MASK] = frame.dpMask;
+        record[REC_ENABLED_MASK] = frame.enabledMask;
+#if NJU3711_ENABLE_DIMMING
+        record[REC_BRIGHTNESS] = _display.getBrightness();
+#else
+        record[REC_BRIGHTNESS] = 255;
+#endif
+        uint16_t multiplex = _display.getMultiplexDelay();
+        uint16_t blanking = _display.getBlankingTime();
+        record[REC_MULTIPLEX] = multiplex & 0xFF;
+        record[REC_MULTIPLEX + 1] = multiplex >> 8;
+        record[REC_BLANKING] = blanking & 0xFF;
+        record[REC_BLANKING + 1] = blanking >> 8;
+    }
+
+    void apply(const uint8_t* record) {
+        NJU3711_Frame frame;
+        for (uint8_t i = 0; i < 3; i++) {
+            frame.segments[i] = record[REC_SEGMENTS + i];
+        }
+        frame.dpMask = record[REC_DP_MASK];
+        frame.enabledMask = record[REC_ENABLED_MASK];
+        _display.setFrame(frame);
+        _display.publishFrame();
+#if NJU3711_ENABLE_DIMMING
+        _display.setBrightness(record[REC_BRIGHTNESS]);
+#endif
+        _display.setMultiplexDelay(record[REC_MULTIPLEX] | (record[REC_MULTIPLEX + 1] << 8));
+        _display.setBlankingTime(record[REC_BLANKING] | (record[REC_BLANKING + 1] << 8));
+    }
+
+    // Find the newest valid record. Sequence numbers of the slots in use
+    // lie within 'slots' of each other, so they compare by difference.
+    bool restore() {
+        uint8_t record[RECORD_SIZE];
+        bool found = false;
+
+        for (uint8_t slot = 0; slot < _slots; slot++) {
+            if (!readSlot(slot, record)) continue;
+            if (!found || (int8_t)(record[REC_SEQUENCE] - _record[REC_SEQUENCE]) > 0) {
+                memcpy(_record, record, RECORD_SIZE);
+                _nextSlot = (slot + 1) % _slots;
+                found = true;
+            }
+        }
+
+        _saved = found;
+        if (found) apply(_record);
+        return found;
+    }
+
+    // A save writes MAGIC last, after invalidating the slot first, so a
+    // slot is only valid once its whole record is in place
+    void writeStep() {
+        uint16_t address = slotAddress(_nextSlot);
+
+        if (_writeStep == 0) {
+            _storage.write(address + REC_MAGIC, 0);
+        } else if (_writeStep < RECORD_SIZE) {
+            _storage.write(address + _writeStep, _record[_writeStep]);
+        } else {
+            _storage.write(address + REC_MAGIC, MAGIC);
+            _storage.commit();
+            _nextSlot = (_nextSlot + 1) % _slots;
+            _writeStep = IDLE;
+            _saved = true;
+            _lastSave = millis();
+            _saveCount++;
+            return;
+        }
+        _writeStep++;
+    }
+
+    void startSave(const uint8_t* state) {
+        uint8_t sequence = _saved ? _record[REC_SEQUENCE] + 1 : 0;
+        memcpy(_record, state, RECORD_SIZE);
+        _record[REC_MAGIC] = MAGIC;
+        _record[REC_SEQUENCE] = sequence;
+        _record[REC_CRC] = crc8(_record, REC_CRC);
+        _saved = false;
+        _writeStep = 0;
+    }
+
+public:
+    // slots: ring length, at least 2 (uses slots * RECORD_SIZE bytes from address)
+    NJU3711_FrameStore(NJU3711_7Segment_Multi& display, Storage& storage,
+                       uint16_t address = 0, uint8_t slots = 8)
+        : _display(display), _storage(storage), _address(address),
+          _slots((slots < 2) ? 2 : slots), _nextSlot(0), _writeStep(IDLE),
+          _saved(false), _saveRequested(false), _lastSave(0),
+          _minInterval(60000), _saveCount(0) {}
+
+    // Restore the last saved state, start the display and scan one full
+    // frame so it is lit before begin() returns. Call instead of
+    // display.begin(). Returns false if no valid record was found.
+    bool begin() {
+        _storage.begin(getSize());
+        bool restored = restore();
+        _display.begin();
+
+        if (restored && _display.isMultiplexing()) {
+            uint16_t frames = _display.getFrameCount();
+            unsigned long start = millis();
+            while ((uint16_t)(_display.getFrameCount() - frames) < 2 && (millis() - start) < 50) {
+                _display.update();
+            }
+        }
+
+        _lastSave = millis();
+        return restored;
+    }
+
+    // Save changes when the interval allows. Call regularly in loop().
+    void update() {
+        if (_writeStep != IDLE) {
+            if (_storage.isReady()) writeStep();
+            return;
+        }
+        if (!_saveRequested && (millis() - _lastSave) < _minInterval) return;
+
+        uint8_t state[RECORD_SIZE];
+        capture(state);
+        _saveRequested = false;
+
+        // Compare the payload only, the header belongs to the stored record
+        if (_saved && memcmp(state + REC_SEGMENTS, _record + REC_SEGMENTS, REC_CRC - REC_SEGMENTS) == 0) return;
+        startSave(state);
+    }
+
+    // Save at the next update() without waiting for the interval
+    void saveNow() {
+        _saveRequested = true;
+    }
+
+    // Invalidate every slot, so the next boot starts blank. Blocks while
+    // the storage is busy (about 3.3ms per slot on AVR).
+    void forget() {
+        _writeStep = IDLE;
+        for (uint8_t slot = 0; slot < _slots; slot++) {
+            while (!_storage.isReady()) {}
+            _storage.write(slotAddress(slot) + REC_MAGIC, 0);
+        }
+        _storage.commit();
+        _saved = false;
+        _nextSlot = 0;
+    }
+
+    void setMinInterval(unsigned long intervalMillis) { _minInterval = intervalMillis; }
+    unsigned long getMinInterval() { return _minInterval; }
+    bool isSaving() { return _writeStep != IDLE; }
+    unsigned long getSaveCount() { return _saveCount; }
+    uint16_t getSize() { return _address + (uint16_t)_slots * RECORD_SIZE; }  // Storage bytes needed
+};
+
+#endif // NJU3711_FRAMESTORE_H
@@ -0,0 +1,140 @@
+/*
+ * NJU3711_LoadMeter.cpp - update() CPU Load Meter Implementation
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_LoadMeter.h"
+
+#define NJU3711_LOAD_SLOT_COUNT (NJU3711_LOAD_METER_SLOTS + 1)
+
+static uint16_t capMicros(unsigned long micros) {
+    return (micros > 0xFFFF) ? 0xFFFF : (uint16_t)micros;
+}
+
+NJU3711_LoadMeter::NJU3711_LoadMeter() {
+    setWindow(1000000); // 1s default
+    reset();
+}
+
+void NJU3711_LoadMeter::reset() {
+    _slotStart = micros();
+    _callStart = _slotStart;
+    _depth = 0;
+    _current = 0;
+    for (uint8_t i = 0; i < NJU3711_LOAD_SLOT_COUNT; i++) {
+        clearSlot(i);
+    }
+}
+
+void NJU3711_LoadMeter::clearSlot(uint8_t slot) {
+    NJU3711_LoadSlot& s = _slots[slot];
+    for (int i = 0; i < NJU3711_LOAD_SUBSYSTEMS; i++) {
+        s.busy[i] = 0;
+        s.worst[i] = 0;
+    }
+    s.length = 0;
+    s.worstCall = 0;
+}
+
+// The window slides by one sub-window at a time
+void NJU3711_LoadMeter::setWindow(unsigned long windowMicros) {
+    _slotLength = windowMicros / NJU3711_LOAD_METER_SLOTS;
+    if (_slotLength == 0) _slotLength = 1;
+}
+
+unsigned long NJU3711_LoadMeter::beginCall() {
+    unsigned long now = micros();
+    if (_depth == 0) {
+        _callStart = now;
+    }
+    _depth++;
+    return now;
+}
+
+void NJU3711_LoadMeter::endCall(NJU3711_LoadSubsystem subsystem, unsigned long since) {
+    unsigned long now = micros();
+    unsigned long elapsed = now - since;
+    NJU3711_LoadSlot& slot = _slots[_current];
+    
+    slot.busy[subsystem] += elapsed;
+    if (capMicros(elapsed) > slot.worst[subsystem]) {
+        slot.worst[subsystem] = capMicros(elapsed);
+    }
+    
+    if (_depth > 0) _depth--;
+    if (_depth == 0) {
+        finishCall(now);
+    }
+}
+
+// Outermost update() returned - track worst case and, once the
+// sub-window is over, make it part of the window in place of the oldest
+void NJU3711_LoadMeter::finishCall(unsigned long now) {
+    NJU3711_LoadSlot& slot = _slots[_current];
+    uint16_t callTime = capMicros(now - _callStart);
+    if (callTime > slot.worstCall) {
+        slot.worstCall = callTime;
+    }
+    
+    if ((now - _slotStart) < _slotLength) return;
+    
+    slot.length = now - _slotStart;
+    _current = (_current + 1) % NJU3711_LOAD_SLOT_COUNT;
+    clearSlot(_current);
+    _slotStart = now;
+}
+
+float NJU3711_LoadMeter::getLoadPercent() {
+    unsigned long window = getWindowMicros();
+    if (window == 0) return 0.0;
+    
+    unsigned long busy = 0;
+    for (uint8_t s = 0; s < NJU3711_LOAD_SLOT_COUNT; s++) {
+        if (s == _current) continue;
+        for (int i = 0; i < NJU3711_LOAD_SUBSYSTEMS; i++) {
+            busy += _slots[s].busy[i];
+        }
+    }
+    return (100.0 * busy) / window;
+}
+
+float NJU3711_LoadMeter::getLoadPercent(NJU3711_LoadSubsystem subsystem) {
+    unsigned long window = getWindowMicros();
+    if (window == 0 || subsystem >= NJU3711_LOAD_SUBSYSTEMS) return 0.0;
+    
+    unsigned long busy = 0;
+    for (uint8_t s = 0; s < NJU3711_LOAD_SLOT_COUNT; s++) {
+        if (s != _current) busy += _slots[s].busy[subsystem];
+    }
+    return (100.0 * busy) / window;
+}
+
+unsigned long NJU3711_LoadMeter::getWorstCallMicros() {
+    uint16_t worst = 0;
+    for (uint8_t s = 0; s < NJU3711_LOAD_SLOT_COUNT; s++) {
+        if (s != _current && _slots[s].worstCall > worst) worst = _slots[s].worstCall;
+    }
+    return worst;
+}
+
+unsigned long NJU3711_LoadMeter::getWorstCallMicros(NJU3711_LoadSubsystem subsystem) {
+    if (subsystem >= NJU3711_LOAD_SUBSYSTEMS) return 0;
+    
+    uint16_t worst = 0;
+    for (uint8_t s = 0; s < NJU3711_LOAD_SLOT_COUNT; s++) {
+        if (s != _current && _slots[s].worst[subsystem] > worst) worst = _slots[s].worst[subsystem];
+    }
+    return worst;
+}
+
+// Sum of the completed sub-windows; shorter than the window until enough
+// sub-windows have passed since reset()
+unsigned long NJU3711_LoadMeter::getWindowMicros() {
+    unsigned long window = 0;
+    for (uint8_t s = 0; s < NJU3711_LOAD_SLOT_COUNT; s++) {
+        if (s != _current) window += _slots[s].length;
+    }
+    return window;
+}
@@ -0,0 +1,66 @@
+/*
+ * NJU3711_LoadMeter.h - update() CPU Load Meter
+ * 
+ * Accumulates the time spent inside update() per subsystem and compares
+ * it with wall time. Results are reported over a sliding window made of
+ * the last NJU3711_LOAD_METER_SLOTS completed sub-windows.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_LOADMETER_H
+#define NJU3711_LOADMETER_H
+
+#include <Arduino.h>
+#include "NJU3711_Config.h"
+
+// Subsystems that report time to the load meter
+enum NJU3711_LoadSubsystem {
+    NJU3711_LOAD_BUS,           // Shift/latch state machine (NJU3711)
+    NJU3711_LOAD_ANIMATION,     // Animation processing (NJU3711_7Segment)
+    NJU3711_LOAD_MULTIPLEX,     // Digit scanning (NJU3711_7Segment_Multi)
+    NJU3711_LOAD_SUBSYSTEMS
+};
+
+// One sub-window of the sliding window
+struct NJU3711_LoadSlot {
+    unsigned long busy[NJU3711_LOAD_SUBSYSTEMS];
+    unsigned long length;                       // 0 until the sub-window is complete
+    uint16_t worst[NJU3711_LOAD_SUBSYSTEMS];    // Microseconds, capped at 65535
+    uint16_t worstCall;
+};
+
+class NJU3711_LoadMeter {
+private:
+    unsigned long _slotLength;      // Sub-window length (microseconds)
+    unsigned long _slotStart;
+    unsigned long _callStart;
+    uint8_t _depth;                 // Nesting depth of update() calls
+    uint8_t _current;               // Sub-window being filled; the others are the window
+    NJU3711_LoadSlot _slots[NJU3711_LOAD_METER_SLOTS + 1];
+    
+    void finishCall(unsigned long now);
+    void clearSlot(uint8_t slot);
+
+public:
+    NJU3711_LoadMeter();
+    
+    // Mark the start of an update() call, returns the current time
+    unsigned long beginCall();
+    // Attribute the time since 'since' to a subsystem and end the call
+    void endCall(NJU3711_LoadSubsystem subsystem, unsigned long since);
+    
+    // Configuration
+    void setWindow(unsigned long windowMicros);    // Default 1000000us (1s)
+    void reset();
+    
+    // Results over the sliding window
+    float getLoadPercent();
+    float getLoadPercent(NJU3711_LoadSubsystem subsystem);
+    unsigned long getWorstCallMicros();
+    unsigned long getWorstCallMicros(NJU3711_LoadSubsystem subsystem);
+    unsigned long getWindowMicros();
+};
+
+#endif // NJU3711_LOADMETER_H
@@ -0,0 +1,316 @@
+/*
+ * NJU3711_Measurement.cpp - Windowed Measurement Display Pipeline
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_Measurement.h"
+
+// Guard the open bucket against addSample() from an interrupt handler
+#if defined(__AVR__)
+#define NJU3711_MEASURE_LOCK() uint8_t oldSREG = SREG; cli()
+#define NJU3711_MEASURE_UNLOCK() SREG = oldSREG
+#else
+#define NJU3711_MEASURE_LOCK() noInterrupts()
+#define NJU3711_MEASURE_UNLOCK() interrupts()
+#endif
+
+NJU3711_Measurement::NJU3711_Measurement(NJU3711_7Segment_Multi& display)
+    : _display(display) {
+    _bucketLength = 1000 / NJU3711_MEASUREMENT_BUCKETS;
+    _refreshInterval = 250;
+    _peakHold = 2000;
+    _statistic = NJU3711_STAT_AVERAGE;
+    _multiplier = 1;
+    _divisor = 1;
+    _offset = 0;
+    _decimals = 0;
+    reset();
+}
+
+bool NJU3711_Measurement::addSample(int16_t value) {
+    _last = value;
+    _hasLast = true;
+
+    if (_openEmpty) {
+        _openMin = value;
+        _openMax = value;
+        _openEmpty = false;
+    } else if (value < _openMin) {
+        _openMin = value;
+    } else if (value > _openMax) {
+        _openMax = value;
+    }
+
+    // The sum is sized for a full window of capped buckets
+    if (_openCount >= NJU3711_MEASUREMENT_BUCKET_SAMPLES) return false;
+    _openSum += value;
+    _openCount++;
+    return true;
+}
+
+void NJU3711_Measurement::reset() {
+    NJU3711_MEASURE_LOCK();
+    _openSum = 0;
+    _openCount = 0;
+    _openEmpty = true;
+    _hasLast = false;
+    NJU3711_MEASURE_UNLOCK();
+
+    for (uint8_t i = 0; i < NJU3711_MEASUREMENT_BUCKETS; i++) {
+        _bucketSum[i] = 0;
+        _bucketCount[i] = 0;
+    }
+    _bucketSerial = 0;
+    _windowSum = 0;
+    _windowCount = 0;
+    _minQueue.head = 0;
+    _minQueue.size = 0;
+    _maxQueue.head = 0;
+    _maxQueue.size = 0;
+    _hasPeak = false;
+
+    unsigned long now = millis();
+    _bucketStart = now;
+    _peakTime = now;
+    _lastRender = now;
+}
+
+void NJU3711_Measurement::update() {
+    unsigned long now = millis();
+
+    // Close every bucket that has ended. After a long stall the whole
+    // window is replaced, so there is no need to close more than that.
+    uint8_t closed = 0;
+    while ((now - _bucketStart) >= _bucketLength) {
+        _bucketStart += _bucketLength;
+        closeBucket(now);
+        if (++closed == NJU3711_MEASUREMENT_BUCKETS) {
+            _bucketStart = now;
+            break;
+        }
+    }
+
+    // Peak decays to the window maximum once the hold time is over
+    if (_hasPeak && (now - _peakTime) >= _peakHold) {
+        if (_maxQueue.size > 0) {
+            _peak = _maxQueue.entries[_maxQueue.head].value;
+        } else {
+            _hasPeak = false;
+        }
+        _peakTime = now;
+    }
+
+    if ((now - _lastRender) >= _refreshInterval) {
+        _lastRender = now;
+        render();
+    }
+}
+
+void NJU3711_Measurement::refresh() {
+    _lastRender = millis();
+    render();
+}
+
+// Move the open bucket into the window, evicting the oldest bucket
+void NJU3711_Measurement::closeBucket(unsigned long now) {
+    NJU3711_MEASURE_LOCK();
+    int32_t sum = _openSum;
+    uint16_t count = _openCount;
+    bool empty = _openEmpty;
+    int16_t minimum = _openMin;
+    int16_t maximum = _openMax;
+    _openSum = 0;
+    _openCount = 0;
+    _openEmpty = true;
+    NJU3711_MEASURE_UNLOCK();
+
+    _bucketSerial++;
+    uint8_t slot = _bucketSerial % NJU3711_MEASUREMENT_BUCKETS;
+    _windowSum += sum - _bucketSum[slot];
+    _windowCount += count;
+    _windowCount -= _bucketCount[slot];
+    _bucketSum[slot] = sum;
+    _bucketCount[slot] = count;
+
+    uint16_t oldest = _bucketSerial - (NJU3711_MEASUREMENT_BUCKETS - 1);
+    expire(_minQueue, oldest);
+    expire(_maxQueue, oldest);
+    if (empty) return;
+
+    push(_minQueue, _bucketSerial, minimum, false);
+    push(_maxQueue, _bucketSerial, maximum, true);
+
+    if (!_hasPeak || maximum >= _peak) {
+        _peak = maximum;
+        _peakTime = now;
+        _hasPeak = true;
+    }
+}
+
+// Drop entries from the back that can never be the extreme again, then append
+void NJU3711_Measurement::push(ExtremeQueue& queue, uint16_t bucket, int16_t value, bool maximum) {
+    while (queue.size > 0) {
+        int16_t back = queue.entries[(queue.head + queue.size - 1) % NJU3711_MEASUREMENT_BUCKETS].value;
+        if (maximum ? (back > value) : (back < value)) break;
+        queue.size--;
+    }
+    Extreme& entry = queue.entries[(queue.head + queue.size) % NJU3711_MEASUREMENT_BUCKETS];
+    entry.bucket = bucket;
+    entry.value = value;
+    queue.size++;
+}
+
+// Drop entries from the front whose bucket has left the window
+void NJU3711_Measurement::expire(ExtremeQueue& queue, uint16_t oldest) {
+    while (queue.size > 0 && (int16_t)(queue.entries[queue.head].bucket - oldest) < 0) {
+        queue.head = (queue.head + 1) % NJU3711_MEASUREMENT_BUCKETS;
+        queue.size--;
+    }
+}
+
+// Statistic in sample units with 8 fractional bits
+bool NJU3711_Measurement::getRaw(NJU3711_Statistic statistic, int32_t& valueQ8) {
+    int16_t sample;
+
+    switch (statistic) {
+        case NJU3711_STAT_LAST: {
+            NJU3711_MEASURE_LOCK();
+            bool hasLast = _hasLast;
+            sample = _last;
+            NJU3711_MEASURE_UNLOCK();
+            if (!hasLast) return false;
+            break;
+        }
+
+        case NJU3711_STAT_AVERAGE: {
+            if (_windowCount == 0) return false;
+            // Quotient and remainder separately, so the sum needs no shift
+            int32_t count = (int32_t)_windowCount;
+            int32_t quotient = _windowSum / count;
+            int32_t remainder = _windowSum % count;
+            valueQ8 = quotient * 256 + (remainder * 256) / count;
+            return true;
+        }
+
+        case NJU3711_STAT_MIN:
+            if (_minQueue.size == 0) return false;
+            sample = _minQueue.entries[_minQueue.head].value;
+            break;
+
+        case NJU3711_STAT_MAX:
+            if (_maxQueue.size == 0) return false;
+            sample = _maxQueue.entries[_maxQueue.head].value;
+            break;
+
+        case NJU3711_STAT_PEAK:
+            if (!_hasPeak) return false;
+            sample = _peak;
+            break;
+
+        default:
+            return false;
+    }
+
+    valueQ8 = (int32_t)sample * 256;
+    return true;
+}
+
+bool NJU3711_Measurement::getValue(NJU3711_Statistic statistic, int32_t& value) {
+    int32_t valueQ8;
+    if (!getRaw(statistic, valueQ8)) return false;
+
+    // Scale and round to nearest, once per redraw
+    int64_t scaled = (int64_t)valueQ8 * _multiplier;
+    int64_t divisor = (int64_t)_divisor * 256;
+    scaled += (scaled >= 0) ? divisor / 2 : -(divisor / 2);
+    value = (int32_t)(scaled / divisor) + _offset;
+    return true;
+}
+
+// Draw the selected statistic, right-aligned with the decimal point
+// placed _decimals digits from the right
+void NJU3711_Measurement::render() {
+    int32_t value;
+    if (!getValue(_statistic, value)) {
+        _display.displayDashes();
+        _display.publishFrame();
+        return;
+    }
+
+    bool negative = value < 0;
+    uint32_t magnitude = negative ? -value : value;
+
+    // Digits needed: the number itself, at least one before the point,
+    // and the minus sign
+    uint8_t needed = 1;
+    for (uint32_t rest = magnitude / 10; rest > 0; rest /= 10) needed++;
+    if (needed < _decimals + 1) needed = _decimals + 1;
+    if (negative) needed++;
+
+    if (needed > 3) {
+        _display.displayError();    // Over range
+        _display.publishFrame();
+        return;
+    }
+
+    uint16_t rest = magnitude;
+    for (uint8_t position = 0; position < 3; position++) {
+        if (position <= _decimals || rest > 0) {
+            bool showDP = (_decimals > 0 && position == _decimals);
+            _display.setDigit(position, rest % 10, showDP);
+            rest /= 10;
+        } else if (negative) {
+            _display.setDigitChar(position, '-');
+            negative = false;
+        } else {
+            _display.setDigitRaw(position, 0);
+        }
+    }
+    _display.publishFrame();
+}
+
+void NJU3711_Measurement::setWindow(unsigned long windowMillis) {
+    _bucketLength = windowMillis / NJU3711_MEASUREMENT_BUCKETS;
+    if (_bucketLength == 0) _bucketLength = 1;
+}
+
+unsigned long NJU3711_Measurement::getWindow() {
+    return _bucketLength * NJU3711_MEASUREMENT_BUCKETS;
+}
+
+void NJU3711_Measurement::setRefreshInterval(unsigned long intervalMillis) {
+    _refreshInterval = intervalMillis;
+}
+
+void NJU3711_Measurement::setPeakHold(unsigned long holdMillis) {
+    _peakHold = holdMillis;
+}
+
+void NJU3711_Measurement::setStatistic(NJU3711_Statistic statistic) {
+    _statistic = statistic;
+}
+
+NJU3711_Statistic NJU3711_Measurement::getStatistic() {
+    return _statistic;
+}
+
+void NJU3711_Measurement::setScale(int32_t multiplier, int32_t divisor, int32_t offset) {
+    if (divisor == 0) return;
+    if (divisor < 0) {
+        multiplier = -multiplier;
+        divisor = -divisor;
+    }
+    _multiplier = multiplier;
+    _divisor = divisor;
+    _offset = offset;
+}
+
+void NJU3711_Measurement::setDecimals(uint8_t decimals) {
+    _decimals = (decimals > 2) ? 2 : decimals;
+}
+
+uint32_t NJU3711_Measurement::getSampleCount() {
+    return _windowCount;
+}
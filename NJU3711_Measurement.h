@@ -0,0 +1,138 @@
+/*
+ * NJU3711_Measurement.h - Windowed Measurement Display Pipeline
+ *
+ * Turns a stream of raw samples into a steady reading on a 3-digit
+ * NJU3711_7Segment_Multi. Samples are taken at any rate, from loop() or
+ * from an interrupt handler, and collected into short buckets. The last
+ * NJU3711_MEASUREMENT_BUCKETS buckets form a sliding window with:
+ *
+ * - minimum and maximum, kept in monotonic queues (O(1) amortised)
+ * - running average, kept as an integer sum and shown in fixed point
+ * - peak hold: the highest sample, held for a set time before it decays
+ *
+ * The selected statistic is scaled to display units and redrawn at a
+ * human-readable rate (4 times per second by default).
+ *
+ * Samples must come from a single source: one interrupt handler on the
+ * core that calls update(), or loop() itself.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_MEASUREMENT_H
+#define NJU3711_MEASUREMENT_H
+
+#include <Arduino.h>
+#include "NJU3711_7Segment_Multi.h"
+
+#define NJU3711_MEASUREMENT_BUCKETS 8   // Buckets per window
+#define NJU3711_MEASUREMENT_BUCKET_SAMPLES (65535 / NJU3711_MEASUREMENT_BUCKETS) // Averaged per bucket
+
+// Statistic shown on the display
+enum NJU3711_Statistic : uint8_t {
+    NJU3711_STAT_LAST,          // Most recent sample
+    NJU3711_STAT_AVERAGE,       // Mean over the window (default)
+    NJU3711_STAT_MIN,           // Lowest sample in the window
+    NJU3711_STAT_MAX,           // Highest sample in the window
+    NJU3711_STAT_PEAK           // Highest sample, held for the peak hold time
+};
+
+class NJU3711_Measurement {
+private:
+    // Bucket extreme, tagged with the serial number of its bucket
+    struct Extreme {
+        uint16_t bucket;
+        int16_t value;
+    };
+
+    // Monotonic queue: values rise (minimum) or fall (maximum) front to
+    // back, so the front is always the extreme of the window
+    struct ExtremeQueue {
+        Extreme entries[NJU3711_MEASUREMENT_BUCKETS];
+        uint8_t head;
+        uint8_t size;
+    };
+
+    NJU3711_7Segment_Multi& _display;
+
+    // Open bucket, written by addSample()
+    volatile int32_t _openSum;
+    volatile uint16_t _openCount;       // Samples in _openSum
+    volatile bool _openEmpty;           // No sample in _openMin/_openMax yet
+    volatile int16_t _openMin;
+    volatile int16_t _openMax;
+    volatile int16_t _last;
+    volatile bool _hasLast;
+
+    // Closed buckets in the window
+    int32_t _bucketSum[NJU3711_MEASUREMENT_BUCKETS];
+    uint16_t _bucketCount[NJU3711_MEASUREMENT_BUCKETS];
+    uint16_t _bucketSerial;             // Serial number of the newest bucket
+    int32_t _windowSum;
+    uint32_t _windowCount;
+    ExtremeQueue _minQueue;
+    ExtremeQueue _maxQueue;
+
+    // Peak hold
+    int16_t _peak;
+    bool _hasPeak;
+    unsigned long _peakTime;
+    unsigned long _peakHold;            // Milliseconds
+
+    // Timing
+    unsigned long _bucketLength;        // Milliseconds
+    unsigned long _bucketStart;
+    unsigned long _refreshInterval;     // Milliseconds
+    unsigned long _lastRender;
+
+    // Presentation
+    NJU3711_Statistic _statistic;
+    int32_t _multiplier;
+    int32_t _divisor;
+    int32_t _offset;
+    uint8_t _decimals;
+
+    void closeBucket(unsigned long now);
+    void render();
+    bool getRaw(NJU3711_Statistic statistic, int32_t& valueQ8);
+
+    static void push(ExtremeQueue& queue, uint16_t bucket, int16_t value, bool maximum);
+    static void expire(ExtremeQueue& queue, uint16_t oldest);
+
+public:
+    NJU3711_Measurement(NJU3711_7Segment_Multi& display);
+
+    // Add one sample. Safe to call from an interrupt handler.
+    // Returns false if the bucket is full and the average skipped it.
+    bool addSample(int16_t value);
+
+    // Call regularly in loop(), next to display.update()
+    void update();
+
+    // Redraw now instead of at the next refresh
+    void refresh();
+
+    // Forget all samples
+    void reset();
+
+    // Window and rates
+    void setWindow(unsigned long windowMillis);         // Default 1000ms
+    unsigned long getWindow();
+    void setRefreshInterval(unsigned long intervalMillis); // Default 250ms
+    void setPeakHold(unsigned long holdMillis);         // Default 2000ms
+
+    // What is shown and how
+    void setStatistic(NJU3711_Statistic statistic);
+    NJU3711_Statistic getStatistic();
+    // Displayed value = sample * multiplier / divisor + offset
+    void setScale(int32_t multiplier, int32_t divisor, int32_t offset = 0);
+    void setDecimals(uint8_t decimals);                 // Digits after the point, 0-2
+
+    // Statistic in display units (before the decimal point is placed).
+    // Returns false if the window holds no samples.
+    bool getValue(NJU3711_Statistic statistic, int32_t& value);
+    uint32_t getSampleCount();                          // Averaged samples in the window
+};
+
+#endif // NJU3711_MEASUREMENT_H
@@ -0,0 +1,209 @@
+/*
+ * NJU3711_RTOS.h - FreeRTOS Task Adapter
+ *
+ * Runs a display's update() in its own FreeRTOS task. Instead of polling,
+ * the task sleeps until the next deadline reported by
+ * getTimeToNextEvent() and is woken early by a task notification whenever
+ * a write is queued through this adapter.
+ *
+ * All access to the display from other tasks must go through the adapter
+ * (write(), clear(), call(), ...), which serialises it with a mutex.
+ *
+ * Uses only the portable FreeRTOS API, so it builds against the FreeRTOS
+ * POSIX port as well as ESP32 and other FreeRTOS targets.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_RTOS_H
+#define NJU3711_RTOS_H
+
+#include <Arduino.h>
+#include "NJU3711.h"
+
+#if defined(__has_include)
+#if __has_include(<freertos/FreeRTOS.h>)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#else
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#endif
+#else
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#endif
+
+template <class Display>
+class NJU3711_RTOSTask {
+private:
+    Display& _display;
+    TaskHandle_t _task;
+    SemaphoreHandle_t _mutex;
+    volatile bool _running;
+    volatile bool _finished;    // The task has left run(), or none was started
+    unsigned long _wakeups;     // Times the task woke up
+
+    static void taskEntry(void* arg) {
+        static_cast<NJU3711_RTOSTask*>(arg)->run();
+    }
+
+    void run() {
+        while (_running) {
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            _display.update();
+            unsigned long next = _display.getTimeToNextEvent();
+            xSemaphoreGive(_mutex);
+
+            if (next == NJU3711_NO_EVENT) {
+                // Nothing scheduled - sleep until a write wakes us
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                _wakeups++;
+                continue;
+            }
+
+            // Whole ticks, rounded down so the task never wakes after the
+            // deadline. Not through portTICK_PERIOD_MS, which is 0 above 1kHz.
+            TickType_t ticks = (TickType_t)(((uint64_t)next * configTICK_RATE_HZ) / 1000000UL);
+            if (ticks == 0) {
+                // Deadline is shorter than a tick - let equal priority tasks run
+                taskYIELD();
+            } else {
+                ulTaskNotifyTake(pdTRUE, ticks);
+                _wakeups++;
+            }
+        }
+        _task = NULL;
+        _finished = true;
+        vTaskDelete(NULL);
+    }
+
+public:
+    explicit NJU3711_RTOSTask(Display& display) : _display(display) {
+        _task = NULL;
+        _mutex = NULL;
+        _running = false;
+        _finished = true;
+        _wakeups = 0;
+    }
+
+    // Create the driver task. Call display.begin() first. Returns false
+    // while a task stopped from inside has not exited yet.
+    bool begin(UBaseType_t priority = 2, uint32_t stackDepth = 2048,
+               const char* name = "NJU3711") {
+        if (_running) return true;
+        if (!_finished) return false;
+
+        if (_mutex == NULL) {
+            _mutex = xSemaphoreCreateMutex();
+            if (_mutex == NULL) return false;
+        }
+
+        _running = true;
+        _finished = false;
+        if (xTaskCreate(taskEntry, name, stackDepth, this, priority, &_task) != pdPASS) {
+            _task = NULL;
+            _running = false;
+            _finished = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Stop the task and wait until it has exited. Called from the task
+    // itself (e.g. from a callback in update()), it only asks the task to
+    // exit after the current iteration.
+    void end() {
+        if (!_running) return;
+        _running = false;
+        notify();
+        if (xTaskGetCurrentTaskHandle() == _task) return;
+
+        while (!_finished) {
+            vTaskDelay(1);
+        }
+    }
+
+    // Wake the task now (e.g. after changing display content via call())
+    void notify() {
+        if (_task != NULL) {
+            xTaskNotifyGive(_task);
+        }
+    }
+
+    // Run fn(display) with the display locked, then wake the task
+    template <class Function>
+    void call(Function fn) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        fn(_display);
+        xSemaphoreGive(_mutex);
+        notify();
+    }
+
+    // Thread-safe queue operations
+    bool write(uint8_t data) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool queued = _display.write(data);
+        xSemaphoreGive(_mutex);
+        if (queued) notify();
+        return queued;
+    }
+
+    bool shift(uint8_t data) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool queued = _display.shift(data);
+        xSemaphoreGive(_mutex);
+        if (queued) notify();
+        return queued;
+    }
+
+    bool latch() {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool queued = _display.latch();
+        xSemaphoreGive(_mutex);
+        if (queued) notify();
+        return queued;
+    }
+
+    bool clear() {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool queued = _display.clear();
+        xSemaphoreGive(_mutex);
+        if (queued) notify();
+        return queued;
+    }
+
+    void clearQueue() {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        _display.clearQueue();
+        xSemaphoreGive(_mutex);
+    }
+
+    uint8_t getQueueSize() {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        uint8_t size = _display.getQueueSize();
+        xSemaphoreGive(_mutex);
+        return size;
+    }
+
+    bool isBusy() {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        bool busy = _display.isBusy();
+        xSemaphoreGive(_mutex);
+        return busy;
+    }
+
+    bool isRunning() {
+        return _running;
+    }
+
+    unsigned long getWakeups() {
+        return _wakeups;
+    }
+};
+
+#endif // NJU3711_RTOS_H
@@ -0,0 +1,138 @@
+/*
+ * NJU3711_RefreshThread.h - Run update() on a Dedicated Core or Thread
+ *
+ * Portable wrapper that keeps calling update() on a display object from
+ * its own execution context, so the bus engine and digit scan run beside
+ * the application instead of inside loop().
+ *
+ * Supported contexts:
+ * - ESP32: FreeRTOS task pinned to a core
+ * - Host builds (no ARDUINO define, or the extras/host stand-in):
+ *   std::thread
+ * - Anything else (e.g. RP2040 loop1()): start() returns false, call
+ *   service() repeatedly from the other core yourself
+ *
+ * Pair with NJU3711_7Segment_Multi::enableFrameHandoff() so frames cross
+ * between cores through the lock-free triple buffer.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_REFRESHTHREAD_H
+#define NJU3711_REFRESHTHREAD_H
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define NJU3711_REFRESH_ESP32
+#elif !defined(ARDUINO) || defined(NJU3711_HOST)
+#include <atomic>
+#include <thread>
+#define NJU3711_REFRESH_STD_THREAD
+#endif
+
+template <class Display>
+class NJU3711_RefreshThread {
+private:
+    Display& _display;
+
+#if defined(NJU3711_REFRESH_ESP32)
+    TaskHandle_t _task;
+    volatile bool _running;
+    volatile bool _finished;
+
+    static void taskEntry(void* arg) {
+        NJU3711_RefreshThread* self = static_cast<NJU3711_RefreshThread*>(arg);
+        while (self->_running) {
+            self->_display.update();
+        }
+        self->_finished = true;
+        vTaskDelete(NULL);
+    }
+#elif defined(NJU3711_REFRESH_STD_THREAD)
+    std::thread _thread;
+    std::atomic<bool> _running;
+
+    void threadEntry() {
+        while (_running.load(std::memory_order_relaxed)) {
+            _display.update();
+        }
+    }
+#else
+    bool _running;
+#endif
+
+public:
+    explicit NJU3711_RefreshThread(Display& display) : _display(display) {
+#if defined(NJU3711_REFRESH_ESP32)
+        _task = NULL;
+        _finished = true;
+#endif
+        _running = false;
+    }
+
+    ~NJU3711_RefreshThread() {
+        stop();
+    }
+
+    // Start calling update() continuously on the given core.
+    // Returns false where no thread support exists - call service() instead.
+    bool start(uint8_t core = 0, uint8_t priority = 1) {
+        if (_running) return true;
+
+#if defined(NJU3711_REFRESH_ESP32)
+        // A busy refresh task on core 0 starves the idle task: call
+        // disableCore0WDT() first or give the task a lower priority
+        _running = true;
+        _finished = false;
+        if (xTaskCreatePinnedToCore(taskEntry, "NJU3711", 2048, this,
+                                    priority, &_task, core) != pdPASS) {
+            _running = false;
+            _finished = true;
+            return false;
+        }
+        return true;
+#elif defined(NJU3711_REFRESH_STD_THREAD)
+        (void)core;
+        (void)priority;
+        _running = true;
+        _thread = std::thread(&NJU3711_RefreshThread::threadEntry, this);
+        return true;
+#else
+        (void)core;
+        (void)priority;
+        return false;
+#endif
+    }
+
+    // Stop the refresh loop and wait for it to exit
+    void stop() {
+        if (!_running) return;
+        _running = false;
+
+#if defined(NJU3711_REFRESH_ESP32)
+        while (!_finished) {
+            vTaskDelay(1);
+        }
+        _task = NULL;
+#elif defined(NJU3711_REFRESH_STD_THREAD)
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+#endif
+    }
+
+    bool isRunning() {
+        return _running;
+    }
+
+    // One refresh step, for platforms where you run the other core's loop
+    void service() {
+        _display.update();
+    }
+};
+
+#endif // NJU3711_REFRESHTHREAD_H
@@ -0,0 +1,55 @@
+/*
+ * NJU3711_SPISink.h - Hardware SPI Byte Sink
+ * 
+ * Drives the NJU3711 from the SPI peripheral instead of bit-banging:
+ * MOSI to DATA, SCK to CLOCK and any pin to STB (CLR strapped HIGH).
+ * Each write transfers one byte MSB first and pulses STB to latch it.
+ * 
+ * write() blocks for the transfer, about 2us at the default 4MHz, so
+ * the sink is never busy between calls.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_SPISINK_H
+#define NJU3711_SPISINK_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "NJU3711.h"
+
+class NJU3711_SPISink {
+private:
+    SPIClass& _spi;
+    SPISettings _settings;
+    uint8_t _strobePin;
+
+public:
+    // NJU3711 shifts on the rising clock edge: SPI mode 0, up to 5MHz
+    NJU3711_SPISink(uint8_t strobePin, uint32_t clockHz = 4000000, SPIClass& spi = SPI)
+        : _spi(spi), _settings(clockHz, MSBFIRST, SPI_MODE0), _strobePin(strobePin) {}
+
+    void begin() {
+        pinMode(_strobePin, OUTPUT);
+        digitalWrite(_strobePin, HIGH);  // STB high for shifting
+        _spi.begin();
+    }
+
+    bool write(uint8_t data) {
+        _spi.beginTransaction(_settings);
+        _spi.transfer(data);
+        _spi.endTransaction();
+        
+        // Latch pulse
+        digitalWrite(_strobePin, LOW);
+        digitalWrite(_strobePin, HIGH);
+        return true;
+    }
+
+    void update() {}
+    bool isBusy() { return false; }
+    unsigned long getTimeToNextEvent() { return NJU3711_NO_EVENT; }
+};
+
+#endif // NJU3711_SPISINK_H
@@ -0,0 +1,132 @@
+/*
+ * NJU3711_SegmentRenderer.h - 7-Segment Rendering on Any Byte Sink
+ * 
+ * The glyph and animation layer of NJU3711_7Segment, written against a
+ * byte sink chosen at compile time instead of the bit-banged NJU3711.
+ * Calls go straight to the sink's write(), with no virtual functions, so
+ * the same font and animation code drives an NJU3711, a hardware SPI
+ * transport, a direct MCU port or a host-side recorder at no extra cost.
+ * See NJU3711_Sink.h for what a sink must provide.
+ * 
+ * Example:
+ *   NJU3711 device(2, 3, 4);
+ *   NJU3711_SegmentRenderer<NJU3711> display(device);
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_SEGMENTRENDERER_H
+#define NJU3711_SEGMENTRENDERER_H
+
+#include <Arduino.h>
+#include "NJU3711.h"
+#include "NJU3711_Font.h"
+#include "NJU3711_Animator.h"
+
+template <class Sink>
+class NJU3711_SegmentRenderer {
+private:
+    Sink& _sink;
+    DisplayMode _displayMode;
+    uint8_t _segments;          // Shown pattern, active-high (bit set = on)
+    
+#if NJU3711_ENABLE_ANIMATIONS
+    NJU3711_Animator _animator;
+#endif
+
+    bool show(uint8_t pattern, bool showDP) {
+        stopAnimation();
+        if (showDP) pattern |= (1 << SEG_DP);
+        return output(pattern);
+    }
+
+    bool output(uint8_t pattern) {
+        if (!_sink.write(NJU3711_Font::applyMode(pattern, _displayMode))) return false;
+        _segments = pattern;
+        return true;
+    }
+
+public:
+    explicit NJU3711_SegmentRenderer(Sink& sink, DisplayMode mode = ACTIVE_LOW)
+        : _sink(sink), _displayMode(mode), _segments(0) {}
+
+    Sink& sink() { return _sink; }
+
+    // Runs the sink's update(), then the animation
+    void update() {
+        _sink.update();
+#if NJU3711_ENABLE_ANIMATIONS
+        uint8_t pattern;
+        if (_animator.nextFrame(micros(), pattern)) {
+            output(pattern);
+        }
+#endif
+    }
+
+    unsigned long getTimeToNextEvent() {
+        unsigned long next = _sink.getTimeToNextEvent();
+#if NJU3711_ENABLE_ANIMATIONS
+        unsigned long animation = _animator.getTimeToNextFrame(micros());
+        if (animation < next) next = animation;
+#endif
+        return next;
+    }
+
+    bool isBusy() { return _sink.isBusy(); }
+
+    // Basic display functions
+    bool displayDigit(uint8_t digit, bool showDP = false) { return show(NJU3711_Font::digit(digit), showDP); }
+    bool displayHex(uint8_t hexValue, bool showDP = false) { return show(NJU3711_Font::hex(hexValue), showDP); }
+    bool displayChar(char character, bool showDP = false) { return show(NJU3711_Font::character(character), showDP); }
+    bool displayRaw(uint8_t segmentMask, bool showDP = false) { return show(segmentMask, showDP); }
+
+    // Special display functions
+    bool displayBlank() { return show(NJU3711_Font::PATTERN_BLANK, false); }
+    bool displayAll() { return show(NJU3711_Font::PATTERN_ALL, false); }
+    bool displayMinus() { return show(NJU3711_Font::PATTERN_MINUS, false); }
+    bool displayUnderscore() { return show(NJU3711_Font::PATTERN_UNDERSCORE, false); }
+    bool displayDegree() { return show(NJU3711_Font::PATTERN_DEGREE, false); }
+    bool displayError() { return show(NJU3711_Font::PATTERN_ERROR, false); }
+
+    // Individual segment control (rewrites the whole byte)
+    bool setSegment(uint8_t segment, bool state) {
+        if (segment > 7) return false;
+        stopAnimation();
+        uint8_t pattern = state ? (_segments | (1 << segment)) : (_segments & ~(1 << segment));
+        return output(pattern);
+    }
+    bool clearSegment(uint8_t segment) { return setSegment(segment, false); }
+    bool toggleSegment(uint8_t segment) {
+        if (segment > 7) return false;
+        return setSegment(segment, !(_segments & (1 << segment)));
+    }
+
+    // Decimal point control
+    bool setDecimalPoint(bool state) { return setSegment(SEG_DP, state); }
+    bool toggleDecimalPoint() { return toggleSegment(SEG_DP); }
+    bool getDecimalPointState() { return (_segments & (1 << SEG_DP)) != 0; }
+
+    // Shown pattern, active-high
+    uint8_t getSegments() { return _segments; }
+
+    // Display mode control (takes effect on the next write)
+    void setDisplayMode(DisplayMode mode) { _displayMode = mode; }
+    DisplayMode getDisplayMode() { return _displayMode; }
+
+    // Animation functions
+#if NJU3711_ENABLE_ANIMATIONS
+    bool startAnimation(AnimationType type, unsigned long animDelay = 100000) {
+        if (_sink.isBusy()) return false;
+        _animator.start(type, animDelay, micros());
+        return true;
+    }
+    void stopAnimation() { _animator.stop(); }
+    bool isAnimating() { return _animator.isActive(); }
+#else
+    void stopAnimation() {}
+    bool isAnimating() { return false; }
+#endif
+};
+
+#endif // NJU3711_SEGMENTRENDERER_H
@@ -0,0 +1,117 @@
+/*
+ * NJU3711_Sequencer.cpp - Display Scripts as Linear Code
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_Sequencer.h"
+
+NJU3711_Script::NJU3711_Script() {
+    _next = NULL;
+    _linked = false;
+    _running = false;
+    _sleeping = false;
+    _sequencer = NULL;
+    _resumeLine = 0;
+    _since = 0;
+    _length = 0;
+}
+
+bool NJU3711_Script::isRunning() {
+    return _running;
+}
+
+void NJU3711_Script::sleep(unsigned long millisDelay) {
+    _since = millis();
+    _length = millisDelay;
+    _sleeping = true;
+}
+
+void NJU3711_Script::finish() {
+    _running = false;
+    _resumeLine = 0;
+}
+
+NJU3711_Sequencer::NJU3711_Sequencer() {
+    _scripts = NULL;
+}
+
+void NJU3711_Sequencer::start(NJU3711_Script& script) {
+    script._resumeLine = 0;
+    script._sleeping = false;
+    script._running = true;
+    script._sequencer = this;
+
+    // New scripts go to the front and get their first turn on the next
+    // update(), so starting one from inside a script is safe
+    if (!script._linked) {
+        script._next = _scripts;
+        script._linked = true;
+        _scripts = &script;
+    }
+}
+
+// Stopped scripts are unlinked by update(), which may be walking the list
+void NJU3711_Sequencer::stop(NJU3711_Script& script) {
+    script._running = false;
+    script._sleeping = false;
+}
+
+void NJU3711_Sequencer::update() {
+    unsigned long now = millis();
+    NJU3711_Script** link = &_scripts;
+
+    while (*link != NULL) {
+        NJU3711_Script* script = *link;
+
+        if (script->_running) {
+            if (script->_sleeping) {
+                if ((now - script->_since) < script->_length) {
+                    link = &script->_next;
+                    continue;
+                }
+                script->_sleeping = false;
+            }
+            script->run();
+        }
+
+        // The list head may have changed if run() started a script
+        if (*link != script) {
+            link = &script->_next;
+            continue;
+        }
+
+        if (!script->_running) {
+            *link = script->_next;
+            script->_linked = false;
+        } else {
+            link = &script->_next;
+        }
+    }
+}
+
+unsigned long NJU3711_Sequencer::getTimeToNextEvent() {
+    unsigned long now = millis();
+    unsigned long next = NJU3711_NO_EVENT;
+
+    for (NJU3711_Script* script = _scripts; script != NULL; script = script->_next) {
+        if (!script->_running) return 0;   // Waiting to be unlinked
+        if (!script->_sleeping) return 0;  // Polling a condition
+
+        unsigned long elapsed = now - script->_since;
+        if (elapsed >= script->_length) return 0;
+        unsigned long remaining = script->_length - elapsed;
+        if (remaining < NJU3711_NO_EVENT / 1000UL && remaining * 1000UL < next) {
+            next = remaining * 1000UL;
+        }
+    }
+    return next;
+}
+
+bool NJU3711_Sequencer::isIdle() {
+    for (NJU3711_Script* script = _scripts; script != NULL; script = script->_next) {
+        if (script->_running) return false;
+    }
+    return true;
+}
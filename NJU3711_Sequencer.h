@@ -0,0 +1,126 @@
+/*
+ * NJU3711_Sequencer.h - Display Scripts as Linear Code
+ *
+ * A script is a class whose run() reads top to bottom - show a value,
+ * wait, blink, scroll - and suspends at each wait instead of blocking.
+ * The sequencer resumes every script where it left off once its wait is
+ * over, from loop() next to display.update().
+ *
+ * Scripts are stackless protothreads: the resume point is a line number
+ * stored in the script, so they need no stack, no heap and compile with
+ * any C++11 toolchain. Two rules follow from that:
+ * - Local variables do not survive a wait. Keep loop counters and other
+ *   state in members of the script class.
+ * - Waits cannot be placed inside a switch statement of run(), and
+ *   there can be at most one wait per source line.
+ *
+ *   class Intro : public NJU3711_Script {
+ *       uint8_t i;
+ *       void run() {
+ *           NJU3711_SCRIPT_BEGIN();
+ *           display.displayNumber(123);
+ *           NJU3711_DELAY(1000);
+ *           for (i = 0; i < 3; i++) {
+ *               display.disableAllDigits();
+ *               NJU3711_DELAY(200);
+ *               display.enableAllDigits();
+ *               NJU3711_DELAY(200);
+ *           }
+ *           NJU3711_SCRIPT_END();
+ *       }
+ *   };
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_SEQUENCER_H
+#define NJU3711_SEQUENCER_H
+
+#include <Arduino.h>
+#include "NJU3711.h"
+
+class NJU3711_Sequencer;
+
+class NJU3711_Script {
+    friend class NJU3711_Sequencer;
+
+private:
+    NJU3711_Script* _next;      // Next script in the sequencer's list
+    bool _linked : 1;           // In a sequencer's list
+    bool _running : 1;
+    bool _sleeping : 1;         // In a delay - not resumed before it ends
+
+protected:
+    NJU3711_Sequencer* _sequencer;  // Sequencer running this script
+    uint16_t _resumeLine;       // Where run() continues, 0 = top
+    unsigned long _since;       // Start of the current wait
+    unsigned long _length;      // Length of the current delay (milliseconds)
+
+    // Body of the script, written with the NJU3711_ macros below
+    virtual void run() = 0;
+
+    void sleep(unsigned long millisDelay);
+    void finish();
+
+public:
+    NJU3711_Script();
+
+    bool isRunning();
+};
+
+class NJU3711_Sequencer {
+private:
+    NJU3711_Script* _scripts;   // Linked through NJU3711_Script::_next
+
+public:
+    NJU3711_Sequencer();
+
+    // Start a script from the top (restarts it if already running)
+    void start(NJU3711_Script& script);
+    void stop(NJU3711_Script& script);
+
+    // Resume every script whose wait is over. Call regularly in loop().
+    void update();
+
+    // Microseconds until a delay ends, 0 while a script polls a condition
+    unsigned long getTimeToNextEvent();
+
+    // No script running
+    bool isIdle();
+};
+
+// Script body markers - every run() starts and ends with these
+#define NJU3711_SCRIPT_BEGIN() switch (_resumeLine) { case 0:
+#define NJU3711_SCRIPT_END() } finish(); return
+
+// Give other scripts and the display a turn, continue on the next update()
+#define NJU3711_YIELD() \
+    do { _resumeLine = __LINE__; return; case __LINE__:; } while (0)
+
+// Suspend until the condition is true, checked on every update()
+#define NJU3711_WAIT_UNTIL(condition) \
+    do { _resumeLine = __LINE__; if (false) { case __LINE__:; } \
+         if (!(condition)) return; } while (0)
+
+// Suspend for a number of milliseconds without being polled
+#define NJU3711_DELAY(millisDelay) \
+    do { sleep(millisDelay); _resumeLine = __LINE__; return; case __LINE__:; } while (0)
+
+// Suspend until the display has finished all queued bus operations
+#define NJU3711_WAIT_IDLE(display) NJU3711_WAIT_UNTIL(!(display).isBusy())
+
+// Suspend until an animation started with startAnimation() has ended
+#define NJU3711_WAIT_ANIMATION(display) NJU3711_WAIT_UNTIL(!(display).isAnimating())
+
+// Suspend until a multiplexed display has begun its next scan of all
+// digits, so the last change is on the glass
+#define NJU3711_WAIT_FRAME(display) \
+    do { _since = (display).getFrameCount(); \
+         NJU3711_WAIT_UNTIL((display).getFrameCount() != (uint16_t)_since); } while (0)
+
+// Run another script and suspend until it has finished
+#define NJU3711_RUN_SCRIPT(script) \
+    do { _sequencer->start(script); NJU3711_WAIT_UNTIL(!(script).isRunning()); } while (0)
+
+#endif // NJU3711_SEQUENCER_H
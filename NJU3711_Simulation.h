@@ -0,0 +1,111 @@
+/*
+ * NJU3711_Simulation.h - Fast-Forward Simulation on a Host
+ *
+ * Runs the library on virtual time, so hours or days of operation can be
+ * checked in seconds: micros() rollover, scan timing over long runs,
+ * clocks that must not drift.
+ *
+ * NJU3711_VirtualClock holds the time. The host's Arduino stand-in
+ * returns it from micros() and millis():
+ *
+ *   NJU3711_VirtualClock simClock;
+ *   unsigned long micros() { return simClock.micros(); }
+ *   unsigned long millis() { return simClock.millis(); }
+ *
+ * NJU3711_FastForward then calls update() and jumps the clock straight to
+ * the next deadline from getTimeToNextEvent(), instead of spinning
+ * through every microsecond in between. Any class with update() and
+ * getTimeToNextEvent() can be run this way.
+ *
+ * micros() wraps after 2^32 microseconds (71.6 minutes) as on the board.
+ * Build the host test with a 32-bit unsigned long (e.g. -m32), otherwise
+ * time differences in the library do not wrap like on the board.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_SIMULATION_H
+#define NJU3711_SIMULATION_H
+
+#include <Arduino.h>
+#include "NJU3711.h"
+
+class NJU3711_VirtualClock {
+private:
+    uint64_t _now;              // Microseconds since time 0, never wraps
+
+public:
+    // Start close to 0xFFFFFFFF to see the first micros() rollover early
+    explicit NJU3711_VirtualClock(uint64_t startMicros = 0) : _now(startMicros) {}
+
+    // What the board's micros() and millis() would return
+    unsigned long micros() { return (uint32_t)_now; }
+    unsigned long millis() { return (uint32_t)(_now / 1000); }
+
+    uint64_t now() { return _now; }
+    void advance(unsigned long micros) { _now += micros; }
+};
+
+// Called after every update() during run(). Return false to stop.
+typedef bool (*NJU3711_SimCheck)();
+
+template <class Device>
+class NJU3711_FastForward {
+private:
+    Device& _device;
+    NJU3711_VirtualClock& _clock;
+    unsigned long _updateCost;  // Virtual time one update() takes (microseconds)
+    unsigned long _maxJump;     // Longest single jump (microseconds)
+    uint64_t _updates;
+    uint64_t _jumps;            // Updates followed by a wait for a deadline
+    uint32_t _busyStreak;       // Consecutive updates with work still due now
+    uint32_t _worstBusyStreak;
+
+public:
+    NJU3711_FastForward(Device& device, NJU3711_VirtualClock& clock)
+        : _device(device), _clock(clock), _updateCost(1), _maxJump(1000000),
+          _updates(0), _jumps(0), _busyStreak(0), _worstBusyStreak(0) {}
+
+    // Run for a span of virtual time. Returns false if the check stopped it.
+    bool run(uint64_t durationMicros, NJU3711_SimCheck check = NULL) {
+        uint64_t end = _clock.now() + durationMicros;
+
+        while (_clock.now() < end) {
+            _device.update();
+            _updates++;
+            if (check != NULL && !check()) return false;
+
+            // A device with work due now still costs one update per call
+            unsigned long next = _device.getTimeToNextEvent();
+            if (next == 0) {
+                if (++_busyStreak > _worstBusyStreak) _worstBusyStreak = _busyStreak;
+            } else {
+                _busyStreak = 0;
+                _jumps++;
+            }
+            if (next < _updateCost) next = _updateCost;
+            if (next > _maxJump) next = _maxJump;
+            if (end - _clock.now() < next) next = (unsigned long)(end - _clock.now());
+            _clock.advance(next);
+        }
+        return true;
+    }
+
+    // Time each update() takes on the board (default 1us). A realistic
+    // figure makes the simulated timing match the board more closely.
+    void setUpdateCost(unsigned long micros) { _updateCost = (micros == 0) ? 1 : micros; }
+
+    // Longest jump, so a check still runs this often while the device is
+    // idle (default 1s)
+    void setMaxJump(unsigned long micros) { _maxJump = (micros == 0) ? 1 : micros; }
+
+    uint64_t getUpdates() { return _updates; }
+    uint64_t getJumps() { return _jumps; }
+
+    // Most consecutive update() calls that reported work due at once. A
+    // large value means a state machine spins without making progress.
+    uint32_t getWorstBusyStreak() { return _worstBusyStreak; }
+};
+
+#endif // NJU3711_SIMULATION_H
@@ -0,0 +1,93 @@
+/*
+ * NJU3711_Sink.h - Byte Sinks for the 7-Segment Renderer
+ * 
+ * NJU3711_SegmentRenderer writes whole segment bytes to a "sink" chosen
+ * at compile time. A sink is any class with these four members:
+ * 
+ *   bool write(uint8_t data);             // Output a byte (false if dropped)
+ *   void update();                        // Called from the renderer's update()
+ *   bool isBusy();                        // Output still in progress
+ *   unsigned long getTimeToNextEvent();   // Or NJU3711_NO_EVENT
+ * 
+ * NJU3711 itself is a sink. This file adds a direct MCU port and a
+ * recorder for host tests; NJU3711_SPISink.h adds hardware SPI.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_SINK_H
+#define NJU3711_SINK_H
+
+#include <Arduino.h>
+#include "NJU3711.h"
+
+// Eight segment lines wired straight to one MCU output port
+class NJU3711_PortSink {
+private:
+    volatile uint8_t* _port;
+
+public:
+    // Set the port's pins to outputs first (e.g. DDRD = 0xFF)
+    explicit NJU3711_PortSink(volatile uint8_t* port) : _port(port) {}
+
+    bool write(uint8_t data) {
+        *_port = data;
+        return true;
+    }
+
+    void update() {}
+    bool isBusy() { return false; }
+    unsigned long getTimeToNextEvent() { return NJU3711_NO_EVENT; }
+};
+
+// Keeps the last Capacity bytes written, for checking output on a host
+template <uint8_t Capacity = 16>
+class NJU3711_RecorderSink {
+private:
+    uint8_t _bytes[Capacity];
+    uint8_t _next;              // Slot for the next byte
+    unsigned long _writes;      // Total bytes written
+
+public:
+    NJU3711_RecorderSink() {
+        reset();
+    }
+
+    bool write(uint8_t data) {
+        _bytes[_next] = data;
+        _next = (_next + 1) % Capacity;
+        _writes++;
+        return true;
+    }
+
+    void update() {}
+    bool isBusy() { return false; }
+    unsigned long getTimeToNextEvent() { return NJU3711_NO_EVENT; }
+
+    // Number of bytes held (at most Capacity)
+    uint8_t size() {
+        return (_writes < Capacity) ? (uint8_t)_writes : Capacity;
+    }
+
+    // Held byte by age, 0 = oldest
+    uint8_t get(uint8_t index) {
+        if (index >= size()) return 0;
+        return _bytes[(_next + Capacity - size() + index) % Capacity];
+    }
+
+    uint8_t last() {
+        return _writes ? _bytes[(_next + Capacity - 1) % Capacity] : 0;
+    }
+
+    unsigned long getWriteCount() {
+        return _writes;
+    }
+
+    void reset() {
+        _next = 0;
+        _writes = 0;
+    }
+};
+
+#endif // NJU3711_SINK_H
@@ -0,0 +1,81 @@
+/*
+ * NJU3711_Storage.h - Non-Volatile Storage for the Frame Store
+ *
+ * NJU3711_FrameStore saves the display state to a storage class chosen
+ * at compile time. A storage class is any class with these members:
+ *
+ *   void begin(uint16_t size);            // Store uses addresses 0 to size-1
+ *   uint8_t read(uint16_t address);
+ *   bool isReady();                       // A write can start without waiting
+ *   void write(uint16_t address, uint8_t value);  // Skip if unchanged
+ *   void commit();                        // A complete record has been written
+ *
+ * This file adds a RAM stand-in for host tests; NJU3711_EEPROMStorage.h
+ * adds the Arduino EEPROM.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_STORAGE_H
+#define NJU3711_STORAGE_H
+
+#include <Arduino.h>
+
+// Size bytes of EEPROM simulated in RAM, starting erased (0xFF).
+// Counts the writes to each address so wear levelling can be checked.
+template <uint16_t Size = 128>
+class NJU3711_RamStorage {
+private:
+    uint8_t _bytes[Size];
+    uint16_t _wear[Size];       // Writes per address
+    unsigned long _writes;      // Total writes
+    unsigned long _commits;
+
+public:
+    NJU3711_RamStorage() {
+        erase();
+    }
+
+    void begin(uint16_t size) {}
+
+    uint8_t read(uint16_t address) {
+        return (address < Size) ? _bytes[address] : 0xFF;
+    }
+
+    bool isReady() { return true; }
+
+    void write(uint16_t address, uint8_t value) {
+        if (address >= Size || _bytes[address] == value) return;
+        _bytes[address] = value;
+        _wear[address]++;
+        _writes++;
+    }
+
+    void commit() {
+        _commits++;
+    }
+
+    unsigned long getWriteCount() {
+        return _writes;
+    }
+
+    unsigned long getCommitCount() {
+        return _commits;
+    }
+
+    uint16_t getWear(uint16_t address) {
+        return (address < Size) ? _wear[address] : 0;
+    }
+
+    void erase() {
+        for (uint16_t i = 0; i < Size; i++) {
+            _bytes[i] = 0xFF;
+            _wear[i] = 0;
+        }
+        _writes = 0;
+        _commits = 0;
+    }
+};
+
+#endif // NJU3711_STORAGE_H
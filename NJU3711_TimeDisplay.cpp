@@ -0,0 +1,303 @@
+/*
+ * NJU3711_TimeDisplay.cpp - Clock and Stopwatch Time Display
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include "NJU3711_TimeDisplay.h"
+
+// Digit value that renders as a blank position
+#define TIME_BLANK 10
+
+// 24-hour BCD hours (by binary hour) as 12-hour BCD hours
+const uint8_t HOURS_12[24] PROGMEM = {
+    0x12, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11,
+    0x12, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11
+};
+
+// Increment a packed BCD value; wraps to 0 and returns true at 'limit' (BCD)
+static bool incrementBCD(uint8_t& value, uint8_t limit) {
+    value++;
+    if ((value & 0x0F) > 9) {
+        value = (value & 0xF0) + 0x10;
+    }
+    if (value >= limit) {
+        value = 0;
+        return true;
+    }
+    return false;
+}
+
+static uint8_t fromBCD(uint8_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+static uint8_t toBCD(uint8_t value) {
+    uint8_t tens = 0;
+    while (value >= 10) {
+        value -= 10;
+        tens++;
+    }
+    return (tens << 4) | value;
+}
+
+NJU3711_TimeDisplay::NJU3711_TimeDisplay(NJU3711_TimeMode mode) {
+    _24Hour = true;
+    _colonBlink = true;
+    _leadingZero = true;
+    for (uint8_t i = 0; i < NJU3711_TIME_DIGITS; i++) {
+        _shown[i] = TIME_BLANK;
+        _segments[i] = 0;
+    }
+    _shownDP = 0;
+    _dirty = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        _lap[i] = 0;
+    }
+    _lapPending = 0;
+    setMode(mode);
+}
+
+bool NJU3711_TimeDisplay::update() {
+    unsigned long now = millis();
+    unsigned long elapsed = now - _lastMillis;
+    _lastMillis = now;
+    return advance(elapsed);
+}
+
+bool NJU3711_TimeDisplay::advance(unsigned long elapsedMillis) {
+    if (_running) {
+        addMillis(elapsedMillis);
+    }
+    render();
+    return _dirty != 0;
+}
+
+// Whole seconds first, then the remainder in hundredths - both by carry
+void NJU3711_TimeDisplay::addMillis(unsigned long elapsed) {
+    elapsed += _pending;
+    while (elapsed >= 1000) {
+        elapsed -= 1000;
+        countSecond();
+    }
+    while (elapsed >= 10) {
+        elapsed -= 10;
+        countHundredth();
+    }
+    _pending = (uint8_t)elapsed;
+}
+
+void NJU3711_TimeDisplay::countHundredth() {
+    if (incrementBCD(_hundredths, 0xA0)) {
+        countSecond();
+    }
+}
+
+void NJU3711_TimeDisplay::countSecond() {
+    if (!incrementBCD(_seconds, 0x60)) return;
+    if (!incrementBCD(_minutes, 0x60)) return;
+    incrementBCD(_hours, (_mode == NJU3711_TIME_CLOCK) ? 0x24 : 0xA0);
+}
+
+// Work out what each position should show and redraw only the changes
+void NJU3711_TimeDisplay::render() {
+    const uint8_t* source;
+    uint8_t running[4] = {_hours, _minutes, _seconds, _hundredths};
+    source = _lapFrozen ? _lap : running;
+    
+    uint8_t first, second, third;
+    uint8_t dp = 0;
+    bool separators = true;
+    
+    if (_mode == NJU3711_TIME_CLOCK) {
+        first = source[0];
+        if (!_24Hour) {
+            first = pgm_read_byte(&HOURS_12[fromBCD(source[0])]);
+            if (source[0] >= 0x12) dp |= (1 << 0); // PM
+        }
+        second = source[1];
+        third = source[2];
+        // Colon on for the first half of each second
+        if (_colonBlink && source[3] >= 0x50) separators = false;
+    } else if (source[0] == 0) {
+        first = source[1];
+        second = source[2];
+        third = source[3];
+    } else {
+        first = source[0];
+        second = source[1];
+        third = source[2];
+    }
+    if (separators) {
+        dp |= (1 << 1) | (1 << 3);
+    }
+    
+    uint8_t leading = first >> 4;
+    if (!_leadingZero && leading == 0) leading = TIME_BLANK;
+    
+    setPosition(0, leading, dp & (1 << 0));
+    setPosition(1, first & 0x0F, dp & (1 << 1));
+    setPosition(2, second >> 4, false);
+    setPosition(3, second & 0x0F, dp & (1 << 3));
+    setPosition(4, third >> 4, false);
+    setPosition(5, third & 0x0F, false);
+}
+
+void NJU3711_TimeDisplay::setPosition(uint8_t position, uint8_t digit, bool dp) {
+    uint8_t mask = (1 << position);
+    bool shownDP = (_shownDP & mask) != 0;
+    if (digit == _shown[position] && dp == shownDP) return;
+    
+    _shown[position] = digit;
+    _shownDP = dp ? (_shownDP | mask) : (_shownDP & ~mask);
+    _segments[position] = NJU3711_Font::digit(digit) | (dp ? (1 << SEG_DP) : 0);
+    _dirty |= mask;
+}
+
+// Mode
+void NJU3711_TimeDisplay::setMode(NJU3711_TimeMode mode) {
+    _mode = mode;
+    _hours = 0;
+    _minutes = 0;
+    _seconds = 0;
+    _hundredths = 0;
+    _pending = 0;
+    _lapFrozen = false;
+    _running = (mode == NJU3711_TIME_CLOCK);
+    _lastMillis = millis();
+    render();
+}
+
+NJU3711_TimeMode NJU3711_TimeDisplay::getMode() {
+    return _mode;
+}
+
+// Clock
+bool NJU3711_TimeDisplay::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    if (hours > 23 || minutes > 59 || seconds > 59) return false;
+    
+    _hours = toBCD(hours);
+    _minutes = toBCD(minutes);
+    _seconds = toBCD(seconds);
+    _hundredths = 0;
+    _pending = 0;
+    _lastMillis = millis();
+    render();
+    return true;
+}
+
+void NJU3711_TimeDisplay::set24Hour(bool enable) {
+    _24Hour = enable;
+    render();
+}
+
+bool NJU3711_TimeDisplay::is24Hour() {
+    return _24Hour;
+}
+
+void NJU3711_TimeDisplay::setColonBlink(bool enable) {
+    _colonBlink = enable;
+    render();
+}
+
+void NJU3711_TimeDisplay::setLeadingZero(bool enable) {
+    _leadingZero = enable;
+    render();
+}
+
+uint8_t NJU3711_TimeDisplay::getHours() {
+    return fromBCD(_hours);
+}
+
+uint8_t NJU3711_TimeDisplay::getMinutes() {
+    return fromBCD(_minutes);
+}
+
+uint8_t NJU3711_TimeDisplay::getSeconds() {
+    return fromBCD(_seconds);
+}
+
+bool NJU3711_TimeDisplay::isPM() {
+    return _hours >= 0x12;
+}
+
+// Stopwatch
+void NJU3711_TimeDisplay::start() {
+    if (_running) return;
+    _lastMillis = millis();
+    _running = true;
+}
+
+void NJU3711_TimeDisplay::stop() {
+    if (!_running) return;
+    update();   // Count up to the moment of stopping
+    _running = false;
+}
+
+void NJU3711_TimeDisplay::reset() {
+    _hours = 0;
+    _minutes = 0;
+    _seconds = 0;
+    _hundredths = 0;
+    _pending = 0;
+    _lapFrozen = false;
+    _lastMillis = millis();
+    render();
+}
+
+bool NJU3711_TimeDisplay::isRunning() {
+    return _running;
+}
+
+// Snapshot the registers at this millisecond; the display holds the
+// snapshot from the next render on, while counting carries on underneath
+void NJU3711_TimeDisplay::lap() {
+    if (_running) {
+        unsigned long now = millis();
+        addMillis(now - _lastMillis);
+        _lastMillis = now;
+    }
+    _lap[0] = _hours;
+    _lap[1] = _minutes;
+    _lap[2] = _seconds;
+    _lap[3] = _hundredths;
+    _lapPending = _pending;
+    _lapFrozen = true;
+    render();
+}
+
+void NJU3711_TimeDisplay::release() {
+    _lapFrozen = false;
+    render();
+}
+
+bool NJU3711_TimeDisplay::isLapFrozen() {
+    return _lapFrozen;
+}
+
+unsigned long NJU3711_TimeDisplay::getElapsedMillis() {
+    unsigned long seconds = (fromBCD(_hours) * 60UL + fromBCD(_minutes)) * 60UL + fromBCD(_seconds);
+    return seconds * 1000UL + fromBCD(_hundredths) * 10UL + _pending;
+}
+
+unsigned long NJU3711_TimeDisplay::getLapMillis() {
+    unsigned long seconds = (fromBCD(_lap[0]) * 60UL + fromBCD(_lap[1])) * 60UL + fromBCD(_lap[2]);
+    return seconds * 1000UL + fromBCD(_lap[3]) * 10UL + _lapPending;
+}
+
+// Rendered output
+uint8_t NJU3711_TimeDisplay::getSegments(uint8_t position) {
+    if (position >= NJU3711_TIME_DIGITS) return 0;
+    return _segments[position];
+}
+
+uint8_t NJU3711_TimeDisplay::takeDirty() {
+    uint8_t dirty = _dirty;
+    _dirty = 0;
+    return dirty;
+}
+
+void NJU3711_TimeDisplay::markAllDirty() {
+    _dirty = (1 << NJU3711_TIME_DIGITS) - 1;
+}
@@ -0,0 +1,108 @@
+/*
+ * NJU3711_TimeDisplay.h - Clock and Stopwatch Time Display
+ * 
+ * Keeps the time in BCD registers and advances it from a millisecond
+ * tick source with carry propagation, so counting never divides. The
+ * six digit positions (left to right) are rendered to segment patterns,
+ * and only positions whose digit or decimal point changed are redrawn
+ * and reported dirty.
+ * 
+ * Clock:     HH.MM.SS - 12/24h, PM on the leftmost DP, blinking colon
+ * Stopwatch: MM.SS.cc, HH.MM.SS from the first hour - lap() freezes the
+ *            display at millisecond resolution while counting continues
+ * 
+ * The component drives no hardware: copy getSegments() of the dirty
+ * positions to whatever display shows them.
+ * 
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_TIMEDISPLAY_H
+#define NJU3711_TIMEDISPLAY_H
+
+#include <Arduino.h>
+#include "NJU3711_Font.h"
+
+#define NJU3711_TIME_DIGITS 6
+
+enum NJU3711_TimeMode : uint8_t {
+    NJU3711_TIME_CLOCK,         // Time of day (default)
+    NJU3711_TIME_STOPWATCH      // Elapsed time, started with start()
+};
+
+class NJU3711_TimeDisplay {
+private:
+    // Running time, packed BCD (one decimal digit per nibble)
+    uint8_t _hours;             // 00-23 (clock) or 00-99 (stopwatch)
+    uint8_t _minutes;
+    uint8_t _seconds;
+    uint8_t _hundredths;
+    uint8_t _pending;           // Milliseconds not yet counted (0-9)
+    unsigned long _lastMillis;  // Tick source reading at the last update()
+    
+    // Frozen lap, packed BCD
+    uint8_t _lap[4];            // Hours, minutes, seconds, hundredths
+    uint8_t _lapPending;
+    
+    // Rendered output
+    uint8_t _shown[NJU3711_TIME_DIGITS];    // Digit on each position (10 = blank)
+    uint8_t _segments[NJU3711_TIME_DIGITS]; // Active-high patterns including DP
+    uint8_t _shownDP;           // Decimal points on (bit n = position n)
+    uint8_t _dirty;             // Positions changed since takeDirty()
+    
+    NJU3711_TimeMode _mode;
+    bool _running : 1;
+    bool _24Hour : 1;
+    bool _colonBlink : 1;
+    bool _leadingZero : 1;
+    bool _lapFrozen : 1;
+    
+    void addMillis(unsigned long elapsed);
+    void countHundredth();
+    void countSecond();
+    void render();
+    void setPosition(uint8_t position, uint8_t digit, bool dp);
+
+public:
+    NJU3711_TimeDisplay(NJU3711_TimeMode mode = NJU3711_TIME_CLOCK);
+    
+    // Advance from millis() - call regularly. Returns true if any position changed.
+    bool update();
+    
+    // Advance by an explicit amount (external tick source, e.g. 1000 per RTC pulse)
+    bool advance(unsigned long elapsedMillis);
+    
+    // Mode - switching resets the time (the clock runs, the stopwatch is stopped)
+    void setMode(NJU3711_TimeMode mode);
+    NJU3711_TimeMode getMode();
+    
+    // Clock
+    bool setTime(uint8_t hours, uint8_t minutes, uint8_t seconds); // 24-hour values
+    void set24Hour(bool enable);            // Default 24-hour
+    bool is24Hour();
+    void setColonBlink(bool enable);        // Separators blink at 1Hz, default on
+    void setLeadingZero(bool enable);       // Show a leading zero on the first position, default on
+    uint8_t getHours();                     // 0-23 (binary)
+    uint8_t getMinutes();
+    uint8_t getSeconds();
+    bool isPM();
+    
+    // Stopwatch
+    void start();
+    void stop();
+    void reset();                           // Zero and release a frozen lap
+    bool isRunning();
+    void lap();                             // Freeze the display at the current time
+    void release();                         // Show the running time again
+    bool isLapFrozen();
+    unsigned long getElapsedMillis();
+    unsigned long getLapMillis();
+    
+    // Rendered output - positions 0 (left) to 5 (right)
+    uint8_t getSegments(uint8_t position);  // Active-high, DP included
+    uint8_t takeDirty();                    // Changed positions (bit n = position n), then clear
+    void markAllDirty();                    // Redraw everything, e.g. after clearing the display
+};
+
+#endif // NJU3711_TIMEDISPLAY_H
@@ -0,0 +1,89 @@
+/*
+ * NJU3711_TripleBuffer.h - Lock-Free Triple Buffer
+ *
+ * Hands complete frames from one writer (application) to one reader
+ * (refresh engine) without locks. The writer fills back() and calls
+ * publish(); the reader calls fetch() and reads front(). Neither side
+ * ever waits, and the reader never sees a half-written frame.
+ *
+ * The only shared variable is a single byte holding the index of the
+ * middle buffer plus a "fresh" flag, swapped atomically by both sides.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef NJU3711_TRIPLEBUFFER_H
+#define NJU3711_TRIPLEBUFFER_H
+
+#include <Arduino.h>
+
+template <typename T>
+class NJU3711_TripleBuffer {
+private:
+    static const uint8_t FRESH = 0x04;  // Middle buffer holds an unread frame
+    static const uint8_t INDEX = 0x03;
+
+    T _buffers[3];
+    uint8_t _back;              // Owned by the writer
+    uint8_t _front;             // Owned by the reader
+    volatile uint8_t _middle;   // Shared: middle index | FRESH
+
+    uint8_t exchangeMiddle(uint8_t value) {
+#if defined(__AVR__)
+        // Single core: only an ISR can interleave, so mask interrupts
+        uint8_t oldSREG = SREG;
+        cli();
+        uint8_t previous = _middle;
+        _middle = value;
+        SREG = oldSREG;
+        return previous;
+#else
+        return __atomic_exchange_n(&_middle, value, __ATOMIC_ACQ_REL);
+#endif
+    }
+
+    uint8_t loadMiddle() const {
+#if defined(__AVR__)
+        return _middle; // Single byte reads are atomic on AVR
+#else
+        return __atomic_load_n(&_middle, __ATOMIC_ACQUIRE);
+#endif
+    }
+
+public:
+    NJU3711_TripleBuffer() {
+        _back = 0;
+        _middle = 1;
+        _front = 2;
+    }
+
+    // Writer side
+    T& back() { return _buffers[_back]; }
+
+    // Publish the back buffer. The new back buffer starts as a copy of the
+    // published frame so incremental edits build on what was just sent.
+    void publish() {
+        uint8_t published = _back;
+        _back = exchangeMiddle(published | FRESH) & INDEX;
+        _buffers[_back] = _buffers[published];
+    }
+
+    // Reader side: pick up the latest published frame, if any
+    bool fetch() {
+        if (!(loadMiddle() & FRESH)) return false;
+        _front = exchangeMiddle(_front) & INDEX;
+        return true;
+    }
+
+    const T& front() const { return _buffers[_front]; }
+
+    // Set all three buffers at once (only while no other core is running)
+    void fill(const T& value) {
+        for (int i = 0; i < 3; i++) {
+            _buffers[i] = value;
+        }
+    }
+};
+
+#endif // NJU3711_TRIPLEBUFFER_H
@@ -25,12 +25,17 @@
  * - Far left DP = PM indicator (12-hour mode only)
  * - Middle DPs = Colon separator (blinks every second)
  * 
+ * Time keeping and digit rendering are done by NJU3711_TimeDisplay: the
+ * time is counted in BCD and only digits that changed are copied to the
+ * scan buffer. A second instance runs a stopwatch (MM.SS.cc) with laps.
+ * 
  * Author: justdienow
  * Version: 1.0
  * 
  */
 
 #include "NJU3711_7Segment.h"
+#include "NJU3711_TimeDisplay.h"
 
 // Control pins (shared bus)
 #define DATA_PIN  2
@@ -51,9 +56,8 @@ NJU3711_7Segment display(DATA_PIN, CLK_PIN, STB_PIN, ACTIVE_LOW);
 // Array to hold digit select pins
 const uint8_t digitPins[6] = {DIGIT_1, DIGIT_2, DIGIT_3, DIGIT_4, DIGIT_5, DIGIT_6};
 
-// Display buffer - holds the 6 digits to display
-uint8_t displayBuffer[6] = {0};
-bool displayDP[6] = {false}; // Decimal point state for each digit
+// Display buffer - segment patterns (DP included) for the 6 digits
+uint8_t displaySegments[6] = {0};
 
 // Multiplexing variables
 uint8_t currentDigit = 0;
@@ -76,15 +80,10 @@ uint8_t nextDigit = 0;
 unsigned long lastStateTime = 0;
 const unsigned long BLANKING_TIME = 10; // 10us blanking period to prevent ghosting
 
-// Clock variables
-uint8_t hours = 12;
-uint8_t minutes = 0;
-uint8_t seconds = 0;
-bool is24HourMode = false;
-bool colonBlinkState = false;
-unsigned long lastSecondUpdate = 0;
-unsigned long lastBlinkUpdate = 0;
-const unsigned long BLINK_INTERVAL = 500000; // 500ms blink rate
+// Time keeping
+NJU3711_TimeDisplay timeOfDay(NJU3711_TIME_CLOCK);
+NJU3711_TimeDisplay stopwatch(NJU3711_TIME_STOPWATCH);
+NJU3711_TimeDisplay* shown = &timeOfDay;   // Instance on the display
 
 void setup() {
     Serial.begin(9600);
@@ -101,12 +100,17 @@ void setup() {
         digitalWrite(digitPins[i], HIGH); // All digits off initially (active LOW)
     }
     
-    // Initialize clock display
-    updateClockDisplay();
+    // Initialize clock: 12:00:00 PM, 12-hour format
+    timeOfDay.setTime(12, 0, 0);
+    timeOfDay.set24Hour(false);
     
     Serial.println("Commands:");
-    Serial.println("HHMMSS - Set time (e.g., 013055 = 01:30:55)");
+    Serial.println("HHMMSS - Set time (e.g., 133055 = 1:30:55 PM)");
     Serial.println("h      - Toggle 12/24 hour format");
+    Serial.println("w      - Switch between clock and stopwatch");
+    Serial.println("g      - Start/stop stopwatch");
+    Serial.println("l      - Freeze lap / release lap");
+    Serial.println("x      - Reset stopwatch");
     Serial.println("r      - Set refresh interval (microseconds)");
     Serial.println("i      - Show current refresh info");
     Serial.println("t      - Show current time");
@@ -114,7 +118,7 @@ void setup() {
     Serial.print("Current time: ");
     printTime();
     Serial.print(" (");
-    Serial.print(is24HourMode ? "24" : "12");
+    Serial.print(timeOfDay.is24Hour() ? "24" : "12");
     Serial.println("-hour mode)");
 }
 
@@ -125,11 +129,8 @@ void loop() {
     // Handle multiplexing refresh
     refreshDisplay();
     
-    // Update clock (increment seconds)
-    updateClock();
-    
-    // Handle colon blinking
-    updateColonBlink();
+    // Advance the clock and stopwatch, copy changed digits
+    updateTime();
     
     // Handle serial commands
     handleSerialInput();
@@ -168,8 +169,8 @@ void refreshDisplay() {
         case SCAN_WRITE_SEGMENTS:
             // Only proceed if NJU3711 is not busy
             if (!display.isBusy()) {
-                // Write segment data for this digit with its decimal point
-                display.displayDigit(displayBuffer[nextDigit], displayDP[nextDigit]);
+                // Write segment data for this digit (DP included)
+                display.displayRaw(displaySegments[nextDigit]);
                 scanState = SCAN_WAIT_DATA;
                 lastStateTime = currentTime;
             }
@@ -201,142 +202,74 @@ void refreshDisplay() {
     }
 }
 
-void updateClock() {
-    unsigned long currentTime = millis();
+void updateTime() {
+    // Both instances keep counting, only the shown one reaches the display
+    timeOfDay.update();
+    stopwatch.update();
     
-    // Update every second
-    if (currentTime - lastSecondUpdate >= 1000) {
-        seconds++;
-        
-        if (seconds >= 60) {
-            seconds = 0;
-            minutes++;
-            
-            if (minutes >= 60) {
-                minutes = 0;
-                hours++;
-                
-                if (is24HourMode) {
-                    if (hours >= 24) {
-                        hours = 0;
-                    }
-                } else {
-                    if (hours > 12) {
-                        hours = 1;
-                    }
-                }
-            }
+    // Copy only the digits that changed since the last call
+    uint8_t dirty = shown->takeDirty();
+    for (uint8_t i = 0; i < 6; i++) {
+        if (dirty & (1 << i)) {
+            displaySegments[i] = shown->getSegments(i);
         }
-        
-        updateClockDisplay();
-        lastSecondUpdate = currentTime;
     }
 }
 
-void updateColonBlink() {
-    unsigned long currentTime = micros();
-    
-    // Blink the colon separators every 500ms
-    if (currentTime - lastBlinkUpdate >= BLINK_INTERVAL) {
-        colonBlinkState = !colonBlinkState;
-        
-        // Update the decimal points for the colon
-        displayDP[2] = colonBlinkState; // After hours
-        displayDP[4] = colonBlinkState; // After minutes
-        
-        lastBlinkUpdate = currentTime;
-    }
-}
-
-void updateClockDisplay() {
-    uint8_t displayHours = hours;
-    
-    // Handle 12-hour mode
-    if (!is24HourMode) {
-        // Set PM indicator (far left DP)
-        if (hours >= 12) {
-            displayDP[0] = true; // PM
-        } else {
-            displayDP[0] = false; // AM
-        }
-        
-        // Convert to 12-hour format
-        if (hours == 0) {
-            displayHours = 12;
-        } else if (hours > 12) {
-            displayHours = hours - 12;
-        }
-    } else {
-        displayDP[0] = false; // No PM indicator in 24-hour mode
-    }
-    
-    // Extract individual digits
-    displayBuffer[0] = displayHours / 10;      // Hour tens
-    displayBuffer[1] = displayHours % 10;      // Hour ones
-    displayBuffer[2] = minutes / 10;           // Minute tens
-    displayBuffer[3] = minutes % 10;           // Minute ones
-    displayBuffer[4] = seconds / 10;           // Second tens
-    displayBuffer[5] = seconds % 10;           // Second ones
-    
-    // Handle leading zero for hours in 12-hour mode
-    if (!is24HourMode && displayBuffer[0] == 0) {
-        // We could blank it, but for clock clarity, we'll keep the zero
-        // Uncomment the next line to blank the leading zero:
-        // displayBuffer[0] = 10; // Use 10 as blank marker
-    }
+void showInstance(NJU3711_TimeDisplay* instance) {
+    shown = instance;
+    shown->markAllDirty();
 }
 
 void setTime(uint8_t h, uint8_t m, uint8_t s) {
-    // Validate and constrain values
-    if (is24HourMode) {
-        hours = constrain(h, 0, 23);
-    } else {
-        hours = constrain(h, 1, 12);
+    // 24-hour input, e.g. 133055 = 1:30:55 PM
+    if (!timeOfDay.setTime(h, m, s)) {
+        Serial.println("Invalid time");
     }
-    
-    minutes = constrain(m, 0, 59);
-    seconds = constrain(s, 0, 59);
-    
-    updateClockDisplay();
-    lastSecondUpdate = millis(); // Reset second counter
 }
 
 void toggle12_24Hour() {
-    is24HourMode = !is24HourMode;
-    
-    // Convert current time if switching modes
-    if (!is24HourMode) {
-        // Switching to 12-hour mode
-        if (hours == 0) {
-            hours = 12;
-        } else if (hours > 12) {
-            // Keep the hour value, PM indicator will show it's PM
-        }
-    } else {
-        // Switching to 24-hour mode
-        if (hours == 12 && !displayDP[0]) {
-            // 12 AM becomes 00
-            hours = 0;
-        } else if (hours < 12 && displayDP[0]) {
-            // PM times need 12 added
-            hours += 12;
-        }
-    }
-    
-    updateClockDisplay();
+    timeOfDay.set24Hour(!timeOfDay.is24Hour());
     
     Serial.print("Switched to ");
-    Serial.print(is24HourMode ? "24" : "12");
+    Serial.print(timeOfDay.is24Hour() ? "24" : "12");
     Serial.println("-hour mode");
     Serial.print("Current time: ");
     printTime();
     Serial.println();
 }
 
+void toggleStopwatch() {
+    if (stopwatch.isRunning()) {
+        stopwatch.stop();
+        Serial.print("Stopwatch stopped at ");
+    } else {
+        stopwatch.start();
+        Serial.print("Stopwatch started at ");
+    }
+    Serial.print(stopwatch.getElapsedMillis());
+    Serial.println(" ms");
+    showInstance(&stopwatch);
+}
+
+void toggleLap() {
+    if (stopwatch.isLapFrozen()) {
+        stopwatch.release();
+        Serial.println("Lap released");
+    } else {
+        stopwatch.lap();
+        Serial.print("Lap: ");
+        Serial.print(stopwatch.getLapMillis());
+        Serial.println(" ms");
+    }
+    showInstance(&stopwatch);
+}
+
 void printTime() {
+    uint8_t hours = timeOfDay.getHours();
     uint8_t displayHours = hours;
     
-    if (!is24HourMode) {
+    if (!timeOfDay.is24Hour()) {
         if (hours > 12) {
             displayHours = hours - 12;
         } else if (hours == 0) {
@@ -347,14 +280,14 @@ void printTime() {
     if (displayHours < 10) Serial.print('0');
     Serial.print(displayHours);
     Serial.print(':');
-    if (minutes < 10) Serial.print('0');
-    Serial.print(minutes);
+    if (timeOfDay.getMinutes() < 10) Serial.print('0');
+    Serial.print(timeOfDay.getMinutes());
     Serial.print(':');
-    if (seconds < 10) Serial.print('0');
-    Serial.print(seconds);
+    if (timeOfDay.getSeconds() < 10) Serial.print('0');
+    Serial.print(timeOfDay.getSeconds());
     
-    if (!is24HourMode) {
-        Serial.print(displayDP[0] ? " PM" : " AM");
+    if (!timeOfDay.is24Hour()) {
+        Serial.print(timeOfDay.isPM() ? " PM" : " AM");
     }
 }
 
@@ -381,6 +314,20 @@ void handleSerialInput() {
         else if (cmd == 'h' || cmd == 'H') {
             toggle12_24Hour();
         }
+        else if (cmd == 'w' || cmd == 'W') {
+            showInstance((shown == &timeOfDay) ? &stopwatch : &timeOfDay);
+            Serial.println((shown == &timeOfDay) ? "Showing clock" : "Showing stopwatch");
+        }
+        else if (cmd == 'g' || cmd == 'G') {
+            toggleStopwatch();
+        }
+        else if (cmd == 'l' || cmd == 'L') {
+            toggleLap();
+        }
+        else if (cmd == 'x' || cmd == 'X') {
+            stopwatch.reset();
+            Serial.println("Stopwatch reset");
+        }
         else if (cmd == 'r' || cmd == 'R') {
             setRefreshInterval();
         }
@@ -391,7 +338,7 @@ void handleSerialInput() {
             Serial.print("Current time: ");
             printTime();
             Serial.print(" (");
-            Serial.print(is24HourMode ? "24" : "12");
+            Serial.print(timeOfDay.is24Hour() ? "24" : "12");
             Serial.println("-hour mode)");
         }
     }
@@ -421,8 +368,7 @@ void setRefreshInterval() {
     while (!Serial.available()) {
         display.update();
         refreshDisplay();
-        updateClock();
-        updateColonBlink();
+        updateTime();
     }
     
     String input = Serial.readStringUntil('\n');
@@ -480,4 +426,4 @@ void showRefreshInfo() {
     Serial.println("  Normal: 1500-2500us (balanced, default 2000us)");
     Serial.println("  Slow:   3000-5000us (may flicker on some displays)");
     Serial.println();
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,425 @@
+/*
+ * NJU3711_Benchmark.ino
+ * Example measuring the library on real hardware, with a report a
+ * script can read
+ *
+ * At start-up, with the digit scan stopped:
+ * - Write latency: time from write() until the byte is latched, 64 times
+ * - Throughput per transport: bytes latched per second with the queue
+ *   kept full, bit-banged at the default and at the shortest step delay,
+ *   and through hardware SPI when BENCH_SPI is 1
+ *
+ * Then the display scans and counts, and every BENCH_SECONDS the sketch
+ * reports loop rate, update() load, bus use, refresh rate and jitter,
+ * multiplex duty and the cost of update() in each bus state.
+ *
+ * Short spans are timed with a cycle counter where the board has one:
+ * Timer1 on AVR (pins 9 and 10 lose PWM), the CPU counter on ESP8266,
+ * ESP32 and Cortex-M3/M4/M7. Other boards use micros().
+ *
+ * Each report is one line of JSON at 115200 baud. It has the same keys
+ * as "extras/benchmark_report.sh --json", which runs this sketch on the
+ * PC, so figures from the board and the simulator compare key by key:
+ *
+ *   {"schema":"nju3711-bench/1","source":"board","sketch":"NJU3711_Benchmark",
+ *    "timer":"cycles","cpu_mhz":16,"seconds":10,"loops_per_s":..., ...}
+ *
+ * Wiring as in NJU3711_7Segment_Multi_Demo. For BENCH_SPI, connect DATA
+ * to MOSI and CLK to SCK instead (pins 11 and 13 on an Uno).
+ */
+
+#include "NJU3711_7Segment_Multi.h"
+
+#define BENCH_SPI 0             // 1: also measure NJU3711_SPISink
+#define BENCH_SECONDS 10        // Report period (at most 17 on a 240MHz ESP32)
+#define LATENCY_WRITES 64
+
+#if BENCH_SPI
+#include "NJU3711_SPISink.h"
+#define DATA_PIN   MOSI
+#define CLOCK_PIN  SCK
+#else
+#define DATA_PIN   2
+#define CLOCK_PIN  3
+#endif
+#define STROBE_PIN 4
+#define DIGIT1_PIN 5  // Rightmost digit (ones)
+#define DIGIT2_PIN 6  // Middle digit (tens)
+#define DIGIT3_PIN 7  // Leftmost digit (hundreds)
+
+NJU3711_7Segment_Multi display(DATA_PIN, CLOCK_PIN, STROBE_PIN,
+                               DIGIT1_PIN, DIGIT2_PIN, DIGIT3_PIN,
+                               ACTIVE_LOW);
+
+// Cycle counter for short spans
+class CycleCounter {
+public:
+#if defined(__AVR__)
+    typedef uint16_t Cycles;    // Wraps after 4ms at 16MHz
+    const char* name() { return "cycles"; }
+    void begin() {
+        TCCR1A = 0;             // Timer1 free-running at the CPU clock
+        TCCR1B = _BV(CS10);
+    }
+    Cycles read() { return TCNT1; }
+    float perMicro() { return F_CPU / 1000000.0; }
+#elif defined(ESP8266) || defined(ESP32)
+    typedef uint32_t Cycles;
+    const char* name() { return "cycles"; }
+    void begin() {}
+    Cycles read() { return ESP.getCycleCount(); }
+    float perMicro() { return ESP.getCpuFreqMHz(); }
+#elif (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)) && defined(F_CPU)
+    typedef uint32_t Cycles;
+    const char* name() { return "cycles"; }
+    void begin() {
+        *(volatile uint32_t*)0xE000EDFC |= (1UL << 24);    // DEMCR: enable trace
+        *(volatile uint32_t*)0xE0001004 = 0;                // DWT_CYCCNT
+        *(volatile uint32_t*)0xE0001000 |= 1;               // DWT_CTRL: count
+    }
+    Cycles read() { return *(volatile uint32_t*)0xE0001004; }
+    float perMicro() { return F_CPU / 1000000.0; }
+#else
+    typedef unsigned long Cycles;
+    const char* name() { return "micros"; }
+    void begin() {}
+    Cycles read() { return micros(); }
+    float perMicro() { return 1.0; }
+#endif
+};
+
+CycleCounter cycles;
+
+// Start-up results
+float latencyMin, latencyMean, latencyMax;  // Microseconds
+float bitbangRate, bitbangFastRate, spiRate;  // Bytes per second
+
+// update() cost per bus state, in cycles
+const char* const stateNames[4] = {"idle", "shifting", "latching", "clearing"};
+unsigned long stateCalls[4];
+uint32_t stateCycles[4];
+uint32_t stateWorst[4];
+
+// Current report window
+unsigned long windowStart;
+unsigned long loops;
+unsigned long nextSample;
+float loadSum, loadMax;
+unsigned long loadSamples;
+unsigned long worstCall;
+unsigned long overflowsStart;
+unsigned long busStart, busBusy, busBytes;
+uint16_t lastFrames;
+unsigned long lastFrameTime;
+unsigned long frameIntervals;
+unsigned long frameReference;   // First interval; sums are kept relative to it for precision
+float frameSum, frameSumSquares;
+unsigned long worstGap;
+
+// Workload
+uint16_t counter = 0;
+unsigned long lastCount = 0;
+
+void setup() {
+    Serial.begin(115200);
+    cycles.begin();
+
+    display.begin();
+    display.disableMultiplex();
+    drain();
+
+    measureLatency();
+    bitbangRate = measureThroughput();
+    unsigned long stepDelay = display.getStepDelay();
+    display.setStepDelay(0);
+    bitbangFastRate = measureThroughput();
+    display.setStepDelay(stepDelay);
+#if BENCH_SPI
+    spiRate = measureSpi();
+#else
+    spiRate = -1;
+#endif
+
+    display.displayNumber(0);
+    display.enableMultiplex();
+    startWindow();
+}
+
+void loop() {
+    // Time update() by the bus state it starts in
+    NJU3711_State state = display.getState();
+    CycleCounter::Cycles start = cycles.read();
+    display.update();
+    CycleCounter::Cycles spent = cycles.read() - start;
+    NJU3711_State after = display.getState();
+    unsigned long now = micros();
+
+    if (state <= NJU3711_CLEARING) {
+        stateCalls[state]++;
+        stateCycles[state] += spent;
+        if (spent > stateWorst[state]) stateWorst[state] = spent;
+    }
+
+    // Bus use, from leaving idle to returning to it
+    if (state == NJU3711_IDLE && after != NJU3711_IDLE) {
+        busStart = now;
+    } else if (state != NJU3711_IDLE && after == NJU3711_IDLE) {
+        busBusy += now - busStart;
+        if (state == NJU3711_LATCHING) busBytes++;
+    }
+
+    // Refresh: time between completed scans
+    uint16_t frames = display.getFrameCount();
+    if (frames != lastFrames) {
+        if (lastFrameTime != 0) {
+            unsigned long interval = now - lastFrameTime;
+            if (frameIntervals++ == 0) frameReference = interval;
+            float deviation = (long)(interval - frameReference);
+            frameSum += deviation;
+            frameSumSquares += deviation * deviation;
+            if (interval > worstGap) worstGap = interval;
+        }
+        lastFrames = frames;
+        lastFrameTime = now;
+    }
+
+#if NJU3711_ENABLE_LOAD_METER
+    // Load of the last completed one-second window
+    if ((long)(now - nextSample) >= 0) {
+        nextSample += 1000000UL;
+        NJU3711_LoadMeter& meter = display.getLoadMeter();
+        loadSum += meter.getLoadPercent();
+        if (meter.getLoadPercent() > loadMax) loadMax = meter.getLoadPercent();
+        if (meter.getWorstCallMicros() > worstCall) worstCall = meter.getWorstCallMicros();
+        loadSamples++;
+    }
+#endif
+
+    // Count up ten times a second, as in the demos
+    if (millis() - lastCount >= 100) {
+        lastCount = millis();
+        counter = (counter + 1) % 1000;
+        display.displayNumber(counter);
+    }
+
+    loops++;
+    if (now - windowStart >= BENCH_SECONDS * 1000000UL) {
+        report(now - windowStart);
+        startWindow();
+    }
+}
+
+void drain() {
+    while (display.isBusy()) {
+        display.update();
+    }
+}
+
+// Time from write() until the byte is latched
+void measureLatency() {
+    float sum = 0;
+    latencyMin = 1e9;
+    latencyMax = 0;
+
+    for (uint8_t i = 0; i < LATENCY_WRITES; i++) {
+        CycleCounter::Cycles start = cycles.read();
+        display.write(i);
+        drain();
+        float latency = (CycleCounter::Cycles)(cycles.read() - start) / cycles.perMicro();
+        sum += latency;
+        if (latency < latencyMin) latencyMin = latency;
+        if (latency > latencyMax) latencyMax = latency;
+    }
+    latencyMean = sum / LATENCY_WRITES;
+}
+
+// Bytes per second with the queue kept full for a second
+float measureThroughput() {
+    unsigned long accepted = 0;
+    unsigned long start = micros();
+
+    while (micros() - start < 1000000UL) {
+        while (display.getQueueSize() < NJU3711_QUEUE_SIZE && display.write(accepted & 0xFF)) {
+            accepted++;
+        }
+        display.update();
+    }
+    drain();
+    return accepted * 1000000.0 / (micros() - start);
+}
+
+#if BENCH_SPI
+// The SPI sink blocks for each byte, so it is never busy between writes
+float measureSpi() {
+    NJU3711_SPISink sink(STROBE_PIN);
+    unsigned long written = 0;
+
+    sink.begin();
+    unsigned long start = micros();
+    while (micros() - start < 1000000UL) {
+        sink.write(written & 0xFF);
+        written++;
+    }
+    float rate = written * 1000000.0 / (micros() - start);
+    SPI.end();                  // Give the pins back to the bit-banged bus
+    return rate;
+}
+#endif
+
+void startWindow() {
+    for (uint8_t i = 0; i < 4; i++) {
+        stateCalls[i] = 0;
+        stateCycles[i] = 0;
+        stateWorst[i] = 0;
+    }
+    loops = 0;
+    loadSum = 0;
+    loadMax = 0;
+    loadSamples = 0;
+    worstCall = 0;
+    busBusy = 0;
+    busBytes = 0;
+    frameIntervals = 0;
+    frameSum = 0;
+    frameSumSquares = 0;
+    worstGap = 0;
+    lastFrameTime = 0;
+#if NJU3711_ENABLE_STATISTICS
+    overflowsStart = display.getQueueOverflows();
+#endif
+#if NJU3711_ENABLE_LOAD_METER
+    display.getLoadMeter().reset();
+#endif
+    windowStart = micros();
+    nextSample = windowStart + 1000000UL;
+    busStart = windowStart;
+}
+
+// JSON output
+
+void printKey(const char* key) {
+    Serial.print(",\"");
+    Serial.print(key);
+    Serial.print("\":");
+}
+
+void printField(const char* key, float value, uint8_t decimals) {
+    printKey(key);
+    Serial.print(value, decimals);
+}
+
+void printField(const char* key, unsigned long value) {
+    printKey(key);
+    Serial.print(value);
+}
+
+void printNull(const char* key) {
+    printKey(key);
+    Serial.print("null");
+}
+
+void report(unsigned long elapsed) {
+    float seconds = elapsed / 1000000.0;
+
+    Serial.print("{\"schema\":\"nju3711-bench/1\"");
+#if defined(NJU3711_HOST)
+    Serial.print(",\"source\":\"host\"");
+#else
+    Serial.print(",\"source\":\"board\"");
+#endif
+    Serial.print(",\"sketch\":\"NJU3711_Benchmark\",\"timer\":\"");
+    Serial.print(cycles.name());
+    Serial.print("\"");
+    if (cycles.perMicro() > 1.0) {
+        printField("cpu_mhz", cycles.perMicro(), 0);
+    } else {
+        printNull("cpu_mhz");
+    }
+    printField("seconds", seconds, 0);
+    printField("loops_per_s", loops / seconds, 0);
+
+    // Keys shared with the host benchmark
+    if (loadSamples > 0) {
+        printField("load_pct", loadSum / loadSamples, 1);
+        printField("load_max_pct", loadMax, 1);
+        printField("worst_update_us", worstCall);
+    } else {
+        printNull("load_pct");
+        printNull("load_max_pct");
+        printNull("worst_update_us");
+    }
+#if NJU3711_ENABLE_STATISTICS
+    printField("queue_overflows", display.getQueueOverflows() - overflowsStart);
+#else
+    printNull("queue_overflows");
+#endif
+    printField("bus_pct", 100.0 * busBusy / elapsed, 1);
+    printField("bytes_per_s", busBytes / seconds, 0);
+    if (frameIntervals > 0) {
+        float offset = frameSum / frameIntervals;
+        float variance = frameSumSquares / frameIntervals - offset * offset;
+        printField("refresh_hz", 1000000.0 / (frameReference + offset), 1);
+        printField("jitter_us", (variance > 0) ? sqrt(variance) : 0.0, 0);
+        printField("worst_gap_us", worstGap);
+    } else {
+        printNull("refresh_hz");
+        printNull("jitter_us");
+        printNull("worst_gap_us");
+    }
+
+    // Board-only keys
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+    float lit = display.getScanDelay();
+#else
+    float lit = display.getMultiplexDelay();
+#endif
+#if NJU3711_ENABLE_DIMMING
+    lit = lit * display.getBrightness() / 255;
+#endif
+    printField("duty_pct", 100.0 * lit * frameIntervals / elapsed, 2);
+
+    printKey("write_latency_us");
+    Serial.print("{\"min\":");
+    Serial.print(latencyMin, 1);
+    Serial.print(",\"mean\":");
+    Serial.print(latencyMean, 1);
+    Serial.print(",\"max\":");
+    Serial.print(latencyMax, 1);
+    Serial.print("}");
+
+    printKey("transports");
+    Serial.print("{\"bitbang\":");
+    Serial.print(bitbangRate, 0);
+    Serial.print(",\"bitbang_step0\":");
+    Serial.print(bitbangFastRate, 0);
+    Serial.print(",\"spi\":");
+    if (spiRate >= 0) {
+        Serial.print(spiRate, 0);
+    } else {
+        Serial.print("null");
+    }
+    Serial.print("}");
+
+    printKey("update_us");
+    Serial.print("{");
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i > 0) Serial.print(",");
+        Serial.print("\"");
+        Serial.print(stateNames[i]);
+        Serial.print("\":{\"calls\":");
+        Serial.print(stateCalls[i]);
+        Serial.print(",\"mean\":");
+        if (stateCalls[i] > 0) {
+            Serial.print(stateCycles[i] / cycles.perMicro() / stateCalls[i], 2);
+        } else {
+            Serial.print("null");
+        }
+        Serial.print(",\"max\":");
+        Serial.print(stateWorst[i] / cycles.perMicro(), 2);
+        Serial.print("}");
+    }
+    Serial.println("}}");
+
+    // Do not count the time spent printing in the next window
+    Serial.flush();
+}
@@ -0,0 +1,122 @@
+/*
+ * NJU3711_Display_Script.ino
+ * Example showing multi-step display sequences written as linear scripts
+ *
+ * Instead of a state machine in loop(), each sequence is a script class
+ * whose run() reads top to bottom. NJU3711_DELAY() and the other waits
+ * suspend the script and return to loop(), so the display keeps scanning
+ * and the LED on pin 13 keeps blinking independently.
+ *
+ * Sequence: show 123, blink it three times, scroll "HELLO", count up to
+ * 100 one frame per step, then start over.
+ *
+ * Wiring as in NJU3711_7Segment_Multi_Demo.
+ */
+
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_Sequencer.h"
+
+// Pin definitions
+#define DATA_PIN   2
+#define CLOCK_PIN  3
+#define STROBE_PIN 4
+#define DIGIT1_PIN 5  // Rightmost digit (ones)
+#define DIGIT2_PIN 6  // Middle digit (tens)
+#define DIGIT3_PIN 7  // Leftmost digit (hundreds)
+#define LED_PIN    13
+
+NJU3711_7Segment_Multi display(DATA_PIN, CLOCK_PIN, STROBE_PIN,
+                               DIGIT1_PIN, DIGIT2_PIN, DIGIT3_PIN,
+                               ACTIVE_LOW);
+
+NJU3711_Sequencer sequencer;
+
+// Scroll a message from right to left through the three digits
+class Scroll : public NJU3711_Script {
+public:
+    const char* text;
+
+private:
+    uint8_t step;               // Kept across waits, so a member
+
+    char charAt(int index) {
+        if (index < 0 || index >= (int)strlen(text)) return ' ';
+        return text[index];
+    }
+
+    void run() {
+        NJU3711_SCRIPT_BEGIN();
+        for (step = 0; step < strlen(text) + 3; step++) {
+            display.setDigitChar(2, charAt(step - 2));
+            display.setDigitChar(1, charAt(step - 1));
+            display.setDigitChar(0, charAt(step));
+            NJU3711_DELAY(300);
+        }
+        NJU3711_SCRIPT_END();
+    }
+};
+
+Scroll scroll;
+
+// The whole show
+class Show : public NJU3711_Script {
+    uint8_t i;
+    uint16_t count;
+
+    void run() {
+        NJU3711_SCRIPT_BEGIN();
+        while (true) {
+            display.displayNumber(123);
+            NJU3711_DELAY(1000);
+
+            for (i = 0; i < 3; i++) {
+                display.disableAllDigits();
+                NJU3711_DELAY(200);
+                display.enableAllDigits();
+                NJU3711_DELAY(200);
+            }
+
+            scroll.text = "HELLO";
+            NJU3711_RUN_SCRIPT(scroll);
+
+            // One step per complete scan - as fast as the display can show it
+            for (count = 0; count <= 100; count++) {
+                display.displayNumber(count);
+                NJU3711_WAIT_FRAME(display);
+            }
+            NJU3711_DELAY(2000);
+        }
+        NJU3711_SCRIPT_END();
+    }
+};
+
+Show show;
+
+// A second script runs side by side with the show
+class Heartbeat : public NJU3711_Script {
+    void run() {
+        NJU3711_SCRIPT_BEGIN();
+        while (true) {
+            digitalWrite(LED_PIN, HIGH);
+            NJU3711_DELAY(100);
+            digitalWrite(LED_PIN, LOW);
+            NJU3711_DELAY(900);
+        }
+        NJU3711_SCRIPT_END();
+    }
+};
+
+Heartbeat heartbeat;
+
+void setup() {
+    pinMode(LED_PIN, OUTPUT);
+    display.begin();
+
+    sequencer.start(show);
+    sequencer.start(heartbeat);
+}
+
+void loop() {
+    display.update();
+    sequencer.update();
+}
@@ -0,0 +1,63 @@
+/*
+ * NJU3711_Tuning_Console.ino
+ * Example showing how to tune a multiplexed display at runtime over Serial
+ * 
+ * Open the Serial Monitor at 115200 baud with "Newline" line endings and
+ * type commands to change the timing without reflashing:
+ * 
+ *   mux 1500        Time per digit (microseconds)
+ *   blank 80        Blanking between digits (microseconds)
+ *   step 2          Bus step delay (microseconds)
+ *   bright 64       Brightness 0-255
+ *   policy adaptive Scan strategy: fixed, suspend or adaptive
+ *   tele 1000       Telemetry every 1000ms (0 = off)
+ *   get             Show the current settings
+ *   ?               List the commands
+ * 
+ * Telemetry lines look like "T hz=166 duty=30.41 q=0 load=1.52": display
+ * refresh rate, lit share of each digit slot (%), queue depth and the
+ * CPU load of update() (%).
+ * 
+ * Wiring as in NJU3711_7Segment_Multi_Demo.
+ */
+
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_Console.h"
+
+// Pin definitions
+#define DATA_PIN   2
+#define CLOCK_PIN  3
+#define STROBE_PIN 4
+#define DIGIT1_PIN 5  // Rightmost digit (ones)
+#define DIGIT2_PIN 6  // Middle digit (tens)
+#define DIGIT3_PIN 7  // Leftmost digit (hundreds)
+
+NJU3711_7Segment_Multi display(DATA_PIN, CLOCK_PIN, STROBE_PIN,
+                               DIGIT1_PIN, DIGIT2_PIN, DIGIT3_PIN,
+                               ACTIVE_LOW);
+
+NJU3711_Console console(display, Serial);
+
+uint16_t counter = 0;
+unsigned long lastCount = 0;
+
+void setup() {
+    Serial.begin(115200);
+    display.begin();
+    display.displayNumber(0);
+    
+    console.setTelemetryPeriod(1000);
+    console.execute("get");
+}
+
+void loop() {
+    display.update();
+    console.update();   // Never waits for the Serial port
+    
+    // Count up so refresh changes are easy to see
+    if (millis() - lastCount >= 100) {
+        lastCount = millis();
+        counter = (counter + 1) % 1000;
+        display.displayNumber(counter);
+    }
+}
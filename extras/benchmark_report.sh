@@ -0,0 +1,126 @@
+#!/bin/sh
+#
+# benchmark_report.sh - Runs the example sketches as benchmark workloads
+#
+# Builds each example on the PC against the host Arduino stand-in in
+# extras/host, feeds it a script of Serial input and runs it for a fixed
+# span of virtual time. Prints one line per sketch:
+#
+#   Loops/s    loop() calls per second
+#   Load %     average and worst one-second load of the listed devices
+#              (from their load meters)
+#   Worst us   longest single update() call
+#   Overflows  writes dropped because a queue was full
+#   Bus %      share of time the busiest bus spends on transfers
+#   Bytes/s    bytes latched on that bus
+#   Refresh Hz how often each digit is turned on, with the jitter
+#              (standard deviation) and the longest gap in microseconds
+#
+# Time is virtual and every run starts from the same state, so the report
+# is the same on every PC. Save it and diff later runs against it to spot
+# regressions in the library's hot paths.
+#
+# The figures count the cost of the Arduino calls only (see
+# extras/host/Arduino.h) - compare them with each other, not with a
+# stopwatch on the board.
+#
+# With --json each sketch gives one JSON object per line instead, with
+# the keys the NJU3711_Benchmark example prints on the board, so host and
+# board figures for that sketch can be compared key by key.
+#
+# Usage: extras/benchmark_report.sh [--json] [seconds]
+#   seconds defaults to 10. Set CXX or HOST_CXXFLAGS to change the host
+#   compiler (the default -m32 gives the board's 32-bit long). Sketches
+#   are built with -Wall -Wextra and the warning count goes to stderr.
+#
+# Author: justdienow
+# Version: 1.0
+
+JSON=0
+if [ "$1" = "--json" ]; then
+    JSON=1
+    shift
+fi
+SECONDS_RUN=${1:-10}
+CXX=${CXX:-g++}
+HOST_CXXFLAGS=${HOST_CXXFLAGS:--m32}
+LIBDIR=$(cd "$(dirname "$0")/.." && pwd)
+HOSTDIR="$LIBDIR/extras/host"
+BUILDDIR=${TMPDIR:-/tmp}/nju3711_benchmark
+
+# name|buses|digit pins|devices|Serial input (ms=text;...)
+SKETCHES="NJU3711_Basic|2,3,4||expander|3000=3;6000=4
+NJU3711_Advanced|2,3,4 5,6,7||expander1,expander2|2000=2;5000=3
+NJU3711_7Segment_Single_Demo|2,3,4||display|3000=4;6000=0
+NJU3711_7Segment_Multi_Demo|2,3,4|5,6,7|display|3000=2;6000=3456
+NJU3711_7Segment_Cascade_Demo|2,3,4|5,6,7,8,9,10|display|2000=654321\n;4000=t\n;7000=s\n
+NJU3711_7Segment_Cascade_Clock_Demo|2,3,4|5,6,7,8,9,10|display|2000=133055\n;5000=w\n;5500=g\n
+NJU3711_Display_Script|2,3,4|5,6,7|display|
+NJU3711_Tuning_Console|2,3,4|5,6,7|display|1000=get\n;3000=mux 3000\n;6000=bright 128\n
+NJU3711_Benchmark|2,3,4|5,6,7|display|"
+
+mkdir -p "$BUILDDIR" || exit 1
+
+if [ "$JSON" -eq 0 ]; then
+    printf "Virtual run: %s s per sketch\n\n" "$SECONDS_RUN"
+    printf "%-36s %10s %7s %7s %7s %9s %6s %8s %8s %8s %9s\n" \
+        "Sketch" "Loops/s" "Load %" "Max %" "Worst" "Overflows" "Bus %" "Bytes/s" "Refresh" "Jitter" "Worst gap"
+    printf "%-36s %10s %7s %7s %7s %9s %6s %8s %8s %8s %9s\n" \
+        "------" "-------" "------" "-----" "-----" "---------" "-----" "-------" "-------" "------" "---------"
+fi
+
+printf '%s\n' "$SKETCHES" | while IFS='|' read -r sketch buses digits devices input; do
+    ino="$LIBDIR/examples/$sketch/$sketch.ino"
+    src="$BUILDDIR/$sketch.cpp"
+
+    # Like the Arduino builder: prototypes for the sketch's functions go
+    # before its first function definition
+    pattern='^[A-Za-z_][A-Za-z0-9_]*[ *&]+[A-Za-z_][A-Za-z0-9_]*[ ]*\([^;]*\)[ ]*\{'
+    first=$(grep -nE "$pattern" "$ino" | head -n 1 | cut -d: -f1)
+    {
+        echo "#include <Arduino.h>"
+        echo "#line 1 \"$ino\""
+        if [ -n "$first" ]; then
+            head -n $((first - 1)) "$ino"
+            grep -E "$pattern" "$ino" | sed -e 's/[ ]*{.*$/;/'
+            echo "#line $first \"$ino\""
+            tail -n +"$first" "$ino"
+        else
+            cat "$ino"
+        fi
+        printf "\nNJU3711* benchDevices[] = {"
+        echo "$devices" | sed -e 's/^/\&/' -e 's/,/, \&/g' | tr -d '\n'
+        echo "};"
+        echo "uint8_t benchDeviceCount = sizeof(benchDevices) / sizeof(benchDevices[0]);"
+    } > "$src"
+
+    # shellcheck disable=SC2086
+    if ! "$CXX" $HOST_CXXFLAGS -O2 -std=gnu++11 -Wall -Wextra -I"$HOSTDIR" -I"$LIBDIR" \
+            -o "$BUILDDIR/$sketch" "$src" "$HOSTDIR/bench_main.cpp" "$HOSTDIR/Arduino.cpp" "$LIBDIR"/*.cpp -lm \
+            > "$BUILDDIR/$sketch.log" 2>&1; then
+        if [ "$JSON" -eq 0 ]; then
+            printf "%-36s %10s  (see %s)\n" "$sketch" "failed" "$BUILDDIR/$sketch.log"
+        else
+            printf "{\"schema\":\"nju3711-bench/1\",\"source\":\"host\",\"sketch\":\"%s\",\"error\":\"build failed\"}\n" "$sketch"
+        fi
+        continue
+    fi
+    warnings=$(grep -c "warning:" "$BUILDDIR/$sketch.log")
+    if [ "$warnings" -gt 0 ]; then
+        echo "$sketch: $warnings compiler warnings (see $BUILDDIR/$sketch.log)" >&2
+    fi
+
+    set -- --seconds "$SECONDS_RUN"
+    for bus in $buses; do
+        set -- "$@" --bus "$bus"
+    done
+    [ -n "$digits" ] && set -- "$@" --digits "$digits"
+    [ -n "$input" ] && set -- "$@" --input "$input"
+
+    if [ "$JSON" -eq 1 ]; then
+        "$BUILDDIR/$sketch" "$@" --json "$sketch"
+    else
+        printf "%-36s " "$sketch"
+        "$BUILDDIR/$sketch" "$@" || printf " run failed\n"
+    fi
+done
@@ -0,0 +1,130 @@
+#!/bin/sh
+#
+# footprint_report.sh - Flash/RAM cost of each NJU3711 feature
+#
+# Board pass: builds example sketches once per feature combination with
+# arduino-cli and prints a table of program (flash) and global variable
+# (RAM) usage.
+#
+# Host pass: compiles the library once per feature combination with the
+# host Arduino stand-in (extras/host) and prints the code and data size of
+# the library objects (from size) and sizeof() of NJU3711,
+# NJU3711_7Segment and NJU3711_7Segment_Multi. Objects are measured before
+# linking, so code a sketch never calls still counts; the board pass shows
+# what a linked sketch pays.
+#
+# Usage: extras/footprint_report.sh [fqbn | host]
+#   fqbn defaults to arduino:avr:uno (requires the arduino:avr core). Both
+#   passes run when arduino-cli is installed, only the host pass when it is
+#   not or when "host" is given. Set CXX, SIZE or HOST_CXXFLAGS to change
+#   the host tools (the default -m32 gives a 32-bit board's int and pointer
+#   sizes; AVR's are smaller still).
+#
+# Author: justdienow
+# Version: 1.0
+
+FQBN=${1:-arduino:avr:uno}
+LIBDIR=$(cd "$(dirname "$0")/.." && pwd)
+HOSTDIR="$LIBDIR/extras/host"
+BUILDDIR=${TMPDIR:-/tmp}/nju3711_footprint
+CXX=${CXX:-g++}
+SIZE=${SIZE:-size}
+HOST_CXXFLAGS=${HOST_CXXFLAGS:--m32}
+
+# Sketches that only use features present in every combination below
+SKETCHES="NJU3711_Basic NJU3711_7Segment_Multi_Demo"
+
+# name|flags
+COMBINATIONS="all features|
+no test patterns|-DNJU3711_ENABLE_TEST_PATTERNS=0
+no animations|-DNJU3711_ENABLE_ANIMATIONS=0
+direct mode (no queue)|-DNJU3711_ENABLE_QUEUE=0
+no statistics|-DNJU3711_ENABLE_STATISTICS=0
+no font|-DNJU3711_ENABLE_FONT=0
+no scrubber|-DNJU3711_ENABLE_SCRUBBER=0
+no adaptive refresh|-DNJU3711_ENABLE_ADAPTIVE_REFRESH=0
+no dimming|-DNJU3711_ENABLE_DIMMING=0
+no segment budget|-DNJU3711_ENABLE_SEGMENT_BUDGET=0
+no keypad|-DNJU3711_ENABLE_KEYPAD=0
+no quiet window|-DNJU3711_ENABLE_QUIET_WINDOW=0
+with energy meter|-DNJU3711_ENABLE_ENERGY_METER=1
+with deadlines|-DNJU3711_ENABLE_DEADLINES=1
+minimal|-DNJU3711_ENABLE_TEST_PATTERNS=0 -DNJU3711_ENABLE_ANIMATIONS=0 -DNJU3711_ENABLE_QUEUE=0 -DNJU3711_ENABLE_STATISTICS=0 -DNJU3711_ENABLE_FONT=0 -DNJU3711_ENABLE_SCRUBBER=0 -DNJU3711_ENABLE_ADAPTIVE_REFRESH=0 -DNJU3711_ENABLE_SEGMENT_BUDGET=0 -DNJU3711_ENABLE_DIMMING=0 -DNJU3711_ENABLE_KEYPAD=0 -DNJU3711_ENABLE_QUIET_WINDOW=0"
+
+board_pass() {
+    printf "Board: %s\n\n" "$FQBN"
+    printf "%-30s %-28s %10s %10s\n" "Sketch" "Configuration" "Flash" "RAM"
+    printf "%-30s %-28s %10s %10s\n" "------" "-------------" "-----" "---"
+
+    for sketch in $SKETCHES; do
+        echo "$COMBINATIONS" | while IFS='|' read -r name flags; do
+            output=$(arduino-cli compile --fqbn "$FQBN" \
+                --library "$LIBDIR" \
+                --build-path "$BUILDDIR/$sketch" \
+                --build-property "compiler.cpp.extra_flags=$flags" \
+                "$LIBDIR/examples/$sketch" 2>&1)
+            if [ $? -ne 0 ]; then
+                printf "%-30s %-28s %10s %10s\n" "$sketch" "$name" "failed" "-"
+                continue
+            fi
+            flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+            ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+            printf "%-30s %-28s %10s %10s\n" "$sketch" "$name" "$flash" "${ram:--}"
+        done
+    done
+}
+
+# Library objects and class sizes for one combination, as one table row
+host_row() {
+    name=$1
+    flags=$2
+    objdir="$BUILDDIR/host"
+    rm -rf "$objdir"
+    mkdir -p "$objdir" || return 1
+
+    for source in "$LIBDIR"/*.cpp; do
+        object="$objdir/$(basename "$source" .cpp).o"
+        # shellcheck disable=SC2086
+        if ! "$CXX" $HOST_CXXFLAGS $flags -Os -std=gnu++11 -I"$HOSTDIR" -I"$LIBDIR" \
+                -c "$source" -o "$object" > "$objdir/build.log" 2>&1; then
+            printf "%-28s %10s %10s %8s %8s %8s\n" "$name" "failed" "-" "-" "-" "-"
+            return 1
+        fi
+    done
+    # shellcheck disable=SC2086
+    if ! "$CXX" $HOST_CXXFLAGS $flags -Os -std=gnu++11 -I"$HOSTDIR" -I"$LIBDIR" \
+            -o "$objdir/footprint" "$HOSTDIR/footprint_main.cpp" "$HOSTDIR/Arduino.cpp" \
+            > "$objdir/build.log" 2>&1; then
+        printf "%-28s %10s %10s %8s %8s %8s\n" "$name" "failed" "-" "-" "-" "-"
+        return 1
+    fi
+
+    # size -t ends with the totals: text data bss dec hex (TOTALS)
+    totals=$("$SIZE" -t "$objdir"/*.o | tail -n 1)
+    code=$(echo "$totals" | awk '{ print $1 }')
+    data=$(echo "$totals" | awk '{ print $2 + $3 }')
+    sizes=$("$objdir/footprint")
+    # shellcheck disable=SC2086
+    set -- $sizes
+    printf "%-28s %10s %10s %8s %8s %8s\n" "$name" "$code" "$data" "$1" "$2" "$3"
+}
+
+host_pass() {
+    printf "Host: %s %s (library objects, -Os)\n\n" "$CXX" "$HOST_CXXFLAGS"
+    printf "%-28s %10s %10s %8s %8s %8s\n" "Configuration" "Code" "Data" "NJU3711" "7Seg" "Multi"
+    printf "%-28s %10s %10s %8s %8s %8s\n" "-------------" "----" "----" "-------" "----" "-----"
+
+    echo "$COMBINATIONS" | while IFS='|' read -r name flags; do
+        host_row "$name" "$flags"
+    done
+}
+
+if [ "$FQBN" != "host" ]; then
+    if command -v arduino-cli >/dev/null 2>&1; then
+        board_pass
+        echo
+    else
+        echo "arduino-cli not found - board pass skipped, host pass only" >&2
+    fi
+fi
+host_pass
@@ -0,0 +1,441 @@
+/*
+ * Arduino.cpp - Host Stand-In for the Arduino Core
+ *
+ * See Arduino.h. Call costs are typical figures for a 16MHz AVR with the
+ * stock core, rounded to whole microseconds.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <deque>
+#include "HostBoard.h"
+
+// Cost of each call (microseconds)
+#define COST_DIGITAL_WRITE  4
+#define COST_DIGITAL_READ   4
+#define COST_PIN_MODE       4
+#define COST_ANALOG_WRITE   8
+#define COST_ANALOG_READ    112
+#define COST_MICROS         4
+#define COST_MILLIS         2
+#define COST_SERIAL_CALL    2
+#define COST_SERIAL_WRITE   6       // Per byte, including the TX interrupt
+#define COST_LOOP           1       // main() around each loop() call
+
+#define SERIAL_BUFFER_SIZE  64
+
+HostBoard hostBoard;
+HardwareSerial Serial;
+
+// For sketches that measure free RAM the AVR way
+int __heap_start;
+int* __brkval;
+
+static uint8_t pinLevels[256];
+static unsigned long randomState = 1;
+
+static void spend(unsigned long micros) {
+    hostBoard.clock.advance(micros);
+}
+
+void hostAddBus(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin, uint8_t clearPin) {
+    if (hostBoard.busCount >= HOST_MAX_BUSES) return;
+    HostBusTrace& bus = hostBoard.buses[hostBoard.busCount++];
+    memset(&bus, 0, sizeof(bus));
+    bus.dataPin = dataPin;
+    bus.clockPin = clockPin;
+    bus.strobePin = strobePin;
+    bus.clearPin = clearPin;
+}
+
+void hostAddDigit(uint8_t pin) {
+    if (hostBoard.digitCount >= HOST_MAX_DIGITS) return;
+    HostDigitTrace& digit = hostBoard.digits[hostBoard.digitCount++];
+    memset(&digit, 0, sizeof(digit));
+    digit.pin = pin;
+}
+
+void hostLoopOverhead() {
+    spend(COST_LOOP);
+}
+
+// Pin trace
+
+static void traceBuses(uint8_t pin, uint8_t oldLevel, uint8_t level) {
+    uint64_t now = hostBoard.clock.now();
+
+    for (uint8_t i = 0; i < hostBoard.busCount; i++) {
+        HostBusTrace& bus = hostBoard.buses[i];
+        if (pin == bus.clockPin && level && !oldLevel) {
+            bus.shift = (uint8_t)((bus.shift << 1) | pinLevels[bus.dataPin]);
+            if (!bus.transferring) {
+                bus.transferring = true;
+                bus.transferStart = now;
+            }
+        } else if (pin == bus.strobePin && level && !oldLevel) {
+            bus.outputs = bus.shift;
+            if (bus.transferring) {
+                bus.transferring = false;
+                bus.busyMicros += now - bus.transferStart;
+                bus.latches++;
+            }
+        } else if (pin == bus.clearPin && !level && oldLevel) {
+            bus.outputs = 0;
+        }
+    }
+}
+
+static void traceDigits(uint8_t pin, bool lit) {
+    uint64_t now = hostBoard.clock.now();
+
+    for (uint8_t i = 0; i < hostBoard.digitCount; i++) {
+        HostDigitTrace& digit = hostBoard.digits[i];
+        if (digit.pin != pin || digit.lit == lit) continue;
+        digit.lit = lit;
+        if (!lit) continue;
+
+        for (uint8_t j = 0; j < hostBoard.digitCount; j++) {
+            if (j != i && hostBoard.digits[j].lit) hostBoard.digitOverlaps++;
+        }
+
+        if (digit.lastOn != 0) {
+            uint64_t interval = now - digit.lastOn;
+            digit.intervals++;
+            digit.sum += interval;
+            digit.sumSquares += (double)interval * interval;
+            if (interval > digit.worstInterval) digit.worstInterval = interval;
+        }
+        digit.lastOn = now;
+    }
+}
+
+// Digital and analog I/O
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+    spend(COST_PIN_MODE);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    uint8_t level = value ? HIGH : LOW;
+    traceBuses(pin, pinLevels[pin], level);
+    traceDigits(pin, level == LOW);
+    pinLevels[pin] = level;
+    hostBoard.pinWrites++;
+    spend(COST_DIGITAL_WRITE);
+}
+
+int digitalRead(uint8_t pin) {
+    spend(COST_DIGITAL_READ);
+    if (pin == hostBoard.keyReturnPin) {
+        for (uint8_t d = 0; d < hostBoard.digitCount && d < 8; d++) {
+            if ((hostBoard.keysDown & (1 << d)) && hostBoard.digits[d].lit) return LOW;
+        }
+    }
+    return pinLevels[pin];
+}
+
+void analogWrite(uint8_t pin, int value) {
+    uint8_t level = (value >= 128) ? HIGH : LOW;
+    traceBuses(pin, pinLevels[pin], level);
+    traceDigits(pin, value < 255);
+    pinLevels[pin] = level;
+    hostBoard.pinWrites++;
+    spend(COST_ANALOG_WRITE);
+}
+
+int analogRead(uint8_t pin) {
+    (void)pin;                  // Every input reads mid-scale
+    spend(COST_ANALOG_READ);
+    return 512;
+}
+
+// Time
+
+unsigned long micros() {
+    unsigned long now = hostBoard.clock.micros() & ~3UL;   // Timer0 ticks every 4us
+    hostBoard.microsReads++;
+    spend(COST_MICROS);
+    return now;
+}
+
+unsigned long millis() {
+    unsigned long now = hostBoard.clock.millis();
+    spend(COST_MILLIS);
+    return now;
+}
+
+void delay(unsigned long ms) {
+    spend(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    spend(us);
+}
+
+void yield() {}
+void noInterrupts() {}
+void interrupts() {}
+
+// Math - a fixed generator, so every run of a sketch is the same
+
+long random(long howBig) {
+    if (howBig <= 0) return 0;
+    randomState = randomState * 1103515245UL + 12345UL;
+    return (long)((randomState >> 16) & 0x7FFF) % howBig;
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) randomState = seed;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// String
+
+static std::string formatNumber(unsigned long n, bool negative, unsigned char base) {
+    char buffer[8 * sizeof(long) + 2];
+    char* p = &buffer[sizeof(buffer) - 1];
+    *p = '\0';
+    if (base < 2) base = 10;
+    do {
+        char digit = n % base;
+        *--p = (digit < 10) ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    if (negative) *--p = '-';
+    return std::string(p);
+}
+
+String::String(int value, unsigned char base) : _s(formatNumber(value < 0 && base == DEC ? -(long)value : (unsigned int)value, value < 0 && base == DEC, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatNumber(value, false, base)) {}
+String::String(long value, unsigned char base) : _s(formatNumber(value < 0 && base == DEC ? -value : value, value < 0 && base == DEC, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatNumber(value, false, base)) {}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) { unsigned int swap = from; from = to; to = swap; }
+    if (from >= _s.length()) return String();
+    if (to > _s.length()) to = _s.length();
+    return String(_s.substr(from, to - from));
+}
+
+int String::indexOf(char c) const {
+    size_t index = _s.find(c);
+    return (index == std::string::npos) ? -1 : (int)index;
+}
+
+void String::trim() {
+    size_t first = _s.find_first_not_of(" \t\r\n\f\v");
+    if (first == std::string::npos) {
+        _s.clear();
+        return;
+    }
+    size_t last = _s.find_last_not_of(" \t\r\n\f\v");
+    _s = _s.substr(first, last - first + 1);
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < _s.length(); i++) {
+        if (_s[i] >= 'a' && _s[i] <= 'z') _s[i] -= 'a' - 'A';
+    }
+}
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < _s.length(); i++) {
+        if (_s[i] >= 'A' && _s[i] <= 'Z') _s[i] += 'a' - 'A';
+    }
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    String a(*this), b(other);
+    a.toLowerCase();
+    b.toLowerCase();
+    return a == b;
+}
+
+// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+    return write(formatNumber(n, false, base).c_str());
+}
+
+size_t Print::print(long n, int base) {
+    if (base == DEC && n < 0) {
+        return write('-') + printNumber(-(unsigned long)n, DEC);
+    }
+    return printNumber((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    return printNumber(n, base);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+    char buffer[48];
+    if (isnan(number)) return write("nan");
+    if (isinf(number)) return write("inf");
+    if (number > 4294967040.0 || number < -4294967040.0) return write("ovf");
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, number);
+    return write(buffer);
+}
+
+// Stream
+
+int Stream::timedRead() {
+    uint64_t deadline = hostBoard.clock.now() + (uint64_t)_timeout * 1000;
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        spend(COST_SERIAL_CALL);
+    } while (hostBoard.clock.now() < deadline);
+    return -1;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int c = timedRead();
+    while (c >= 0 && c != terminator) {
+        result += (char)c;
+        c = timedRead();
+    }
+    return result;
+}
+
+String Stream::readString() {
+    String result;
+    int c = timedRead();
+    while (c >= 0) {
+        result += (char)c;
+        c = timedRead();
+    }
+    return result;
+}
+
+// HardwareSerial
+
+// A scripted byte arrives 'position' byte times after its line is sent
+struct SerialByte {
+    uint64_t sent;
+    uint16_t position;
+    uint8_t value;
+};
+
+static unsigned long serialByteTime = 1042;    // Microseconds per byte at 9600 baud
+static uint64_t serialTxFreeAt;                // When the TX buffer has drained
+static std::deque<SerialByte> serialInput;
+
+static bool serialArrived(const SerialByte& b) {
+    return b.sent + (uint64_t)(b.position + 1) * serialByteTime <= hostBoard.clock.now();
+}
+
+bool hostSetSerialScript(const char* script) {
+    serialInput.clear();
+    while (*script) {
+        char* end;
+        unsigned long ms = strtoul(script, &end, 10);
+        if (end == script || *end != '=') return false;
+        script = end + 1;
+
+        uint16_t position = 0;
+        while (*script && *script != ';') {
+            SerialByte b;
+            b.sent = (uint64_t)ms * 1000;
+            b.position = position++;
+            b.value = *script++;
+            if (b.value == '\\' && *script == 'n') {
+                b.value = '\n';
+                script++;
+            }
+            serialInput.push_back(b);
+        }
+        if (*script == ';') script++;
+    }
+    return true;
+}
+
+void hostReset(uint64_t startMicros) {
+    hostBoard.clock = NJU3711_VirtualClock(startMicros);
+    hostBoard.busCount = 0;
+    hostBoard.digitCount = 0;
+    hostBoard.serialBytes = 0;
+    hostBoard.digitOverlaps = 0;
+    hostBoard.pinWrites = 0;
+    hostBoard.microsReads = 0;
+    hostBoard.keyReturnPin = 255;
+    hostBoard.keysDown = 0;
+    memset(pinLevels, LOW, sizeof(pinLevels));
+    serialInput.clear();
+    serialTxFreeAt = 0;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    if (baud != 0) serialByteTime = 10000000UL / baud;   // Start + 8 data + stop bits
+}
+
+int HardwareSerial::available() {
+    int count = 0;
+    for (size_t i = 0; i < serialInput.size() && serialArrived(serialInput[i]); i++) {
+        if (++count == SERIAL_BUFFER_SIZE - 1) break;
+    }
+    spend(COST_SERIAL_CALL);
+    return count;
+}
+
+int HardwareSerial::peek() {
+    spend(COST_SERIAL_CALL);
+    if (serialInput.empty() || !serialArrived(serialInput.front())) return -1;
+    return serialInput.front().value;
+}
+
+int HardwareSerial::read() {
+    spend(COST_SERIAL_CALL);
+    if (serialInput.empty() || !serialArrived(serialInput.front())) return -1;
+    uint8_t c = serialInput.front().value;
+    serialInput.pop_front();
+    return c;
+}
+
+int HardwareSerial::availableForWrite() {
+    uint64_t now = hostBoard.clock.now();
+    spend(COST_SERIAL_CALL);
+    if (serialTxFreeAt <= now) return SERIAL_BUFFER_SIZE - 1;
+    unsigned long queued = (unsigned long)((serialTxFreeAt - now + serialByteTime - 1) / serialByteTime);
+    return (queued >= SERIAL_BUFFER_SIZE - 1) ? 0 : (int)(SERIAL_BUFFER_SIZE - 1 - queued);
+}
+
+void HardwareSerial::flush() {
+    if (serialTxFreeAt > hostBoard.clock.now()) {
+        spend((unsigned long)(serialTxFreeAt - hostBoard.clock.now()));
+    }
+}
+
+// Blocks while the TX buffer is full, like the AVR core
+size_t HardwareSerial::write(uint8_t c) {
+    uint64_t limit = hostBoard.clock.now() + (uint64_t)(SERIAL_BUFFER_SIZE - 1) * serialByteTime;
+    if (serialTxFreeAt > limit) {
+        spend((unsigned long)(serialTxFreeAt - limit));
+    }
+
+    uint64_t now = hostBoard.clock.now();
+    serialTxFreeAt = ((serialTxFreeAt > now) ? serialTxFreeAt : now) + serialByteTime;
+    hostBoard.serialBytes++;
+    if (hostBoard.echoSerial) fputc(c, stderr);
+    spend(COST_SERIAL_WRITE);
+    return 1;
+}
@@ -0,0 +1,201 @@
+/*
+ * Arduino.h - Host Stand-In for the Arduino Core
+ *
+ * Lets the example sketches build and run on a PC for
+ * extras/benchmark_report.sh. Time is an NJU3711_VirtualClock that only
+ * moves when the sketch does something:
+ * - Every Arduino call costs roughly what it takes on a 16MHz AVR
+ *   (digitalWrite() 4us, micros() 4us, ...), so busy loops and the
+ *   load meter see realistic timing.
+ * - micros() has the AVR's 4us resolution.
+ * - delay() jumps the clock.
+ * - Serial transmits at the baud rate through a 64 byte buffer and
+ *   blocks when it is full. Input comes from a script of timed lines.
+ *
+ * Writes to the pins are traced, so the harness can report bus
+ * utilisation and how steadily the digits are refreshed.
+ *
+ * This is not an emulator: only the cost of the Arduino calls is
+ * modelled, the sketch's own code runs in zero time.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define ARDUINO 10819
+#define NJU3711_HOST 1
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define LED_BUILTIN 13
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+
+#define PROGMEM
+#define F(string) (string)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+
+// PWM pins of an Uno
+#define digitalPinHasPWM(p) ((p) == 3 || (p) == 5 || (p) == 6 || (p) == 9 || (p) == 10 || (p) == 11)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+template <class A, class B> inline auto min(A a, B b) -> decltype(a + b) { return (a < b) ? a : b; }
+template <class A, class B> inline auto max(A a, B b) -> decltype(a + b) { return (a > b) ? a : b; }
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+// Digital and analog I/O
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+int analogRead(uint8_t pin);
+
+// Time
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void noInterrupts();
+void interrupts();
+
+// Math
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+class String {
+private:
+    std::string _s;
+
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+
+    unsigned int length() const { return _s.length(); }
+    const char* c_str() const { return _s.c_str(); }
+    char charAt(unsigned int index) const { return (index < _s.length()) ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    String substring(unsigned int from) const { return substring(from, _s.length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c) const;
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+    bool equals(const String& other) const { return _s == other._s; }
+    bool equalsIgnoreCase(const String& other) const;
+
+    bool operator==(const String& other) const { return _s == other._s; }
+    bool operator!=(const String& other) const { return _s != other._s; }
+    String& operator+=(const String& other) { _s += other._s; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+};
+
+class Print {
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double number, uint8_t digits);
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    virtual int availableForWrite() { return 0; }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print {
+protected:
+    unsigned long _timeout;     // Milliseconds, for readStringUntil()
+
+    int timedRead();
+
+public:
+    Stream() : _timeout(1000) {}
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    String readStringUntil(char terminator);
+    String readString();
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud);
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+    using Print::write;
+    int availableForWrite();
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Sketch entry points
+void setup();
+void loop();
+
+#endif // ARDUINO_H
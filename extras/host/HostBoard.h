@@ -0,0 +1,87 @@
+/*
+ * HostBoard.h - Pin Trace and Scripted I/O of the Host Arduino Stand-In
+ *
+ * The part of extras/host/Arduino.cpp the host harnesses talk to: the
+ * virtual clock, the buses and digit pins to trace, the keys and the
+ * Serial input script.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef HOSTBOARD_H
+#define HOSTBOARD_H
+
+#include <Arduino.h>
+#include "NJU3711_Simulation.h"
+
+#define HOST_MAX_BUSES  4
+#define HOST_MAX_DIGITS 16
+
+// One DATA/CLK/STB bus. A transfer runs from the first CLK rising edge
+// to the end of the STB pulse that latches it.
+//
+// The trace also models the NJU3711 itself: CLK rising shifts DATA in,
+// STB rising copies the shift register to the outputs and CLR falling
+// clears them. 'outputs' is what the driver's pins really show.
+struct HostBusTrace {
+    uint8_t dataPin;
+    uint8_t clockPin;
+    uint8_t strobePin;
+    uint8_t clearPin;           // 255 if CLR is strapped HIGH
+    uint8_t shift;
+    uint8_t outputs;
+    bool transferring;
+    uint64_t transferStart;
+    uint64_t busyMicros;        // Sum of all transfers
+    unsigned long latches;      // Bytes that reached the outputs
+};
+
+// One digit select pin, lit while LOW or driven with analogWrite() < 255
+// (PNP drivers, as in NJU3711_7Segment_Multi). The refresh interval is
+// the time from one turn-on of the digit to the next.
+struct HostDigitTrace {
+    uint8_t pin;
+    bool lit;
+    uint64_t lastOn;
+    unsigned long intervals;
+    double sum;
+    double sumSquares;
+    uint64_t worstInterval;
+};
+
+struct HostBoard {
+    NJU3711_VirtualClock clock;
+    HostBusTrace buses[HOST_MAX_BUSES];
+    uint8_t busCount;
+    HostDigitTrace digits[HOST_MAX_DIGITS];
+    uint8_t digitCount;
+    bool echoSerial;            // Copy Serial output to stderr
+    unsigned long serialBytes;  // Bytes the sketch sent
+    unsigned long digitOverlaps;    // Digits turned on while another was lit
+    unsigned long pinWrites;    // digitalWrite() and analogWrite() calls
+    unsigned long microsReads;  // micros() calls
+    // Keys on the digit lines (NJU3711_7Segment_Multi keypad): key n joins
+    // traced digit n to keyReturnPin, which reads LOW while a held key's
+    // digit is lit
+    uint8_t keyReturnPin;       // 255 = no keys
+    uint8_t keysDown;           // Bit n = key n held
+};
+
+extern HostBoard hostBoard;
+
+void hostAddBus(uint8_t dataPin, uint8_t clockPin, uint8_t strobePin, uint8_t clearPin = 255);
+void hostAddDigit(uint8_t pin);
+
+// Back to a board fresh from reset: time 'startMicros', every pin LOW,
+// nothing traced, no keys and no Serial input
+void hostReset(uint64_t startMicros = 0);
+
+// Serial input: "ms=text;ms=text", each text arriving at that virtual
+// millisecond at the baud rate. "\n" in the text stands for a newline.
+bool hostSetSerialScript(const char* script);
+
+// What the core's main() costs between two loop() calls
+void hostLoopOverhead();
+
+#endif // HOSTBOARD_H
@@ -0,0 +1,206 @@
+/*
+ * bench_main.cpp - Runs One Example Sketch as a Benchmark Workload
+ *
+ * Linked with a sketch and the host Arduino stand-in by
+ * extras/benchmark_report.sh. Calls setup() and then loop() for a fixed
+ * span of virtual time and prints one line of figures:
+ *
+ *   loops/s  load avg %  load max %  worst update us  overflows
+ *   bus %  bytes/s  refresh Hz  jitter us  worst gap us
+ *
+ * With --json the line is a JSON object instead, with the keys the
+ * NJU3711_Benchmark example prints on the board (schema nju3711-bench/1).
+ *
+ * The sketch lists the devices to measure in benchDevices[] (appended
+ * by the script).
+ *
+ * Usage: bench [--seconds N] [--bus data,clock,strobe]... [--digits p,p,...]
+ *              [--input "ms=text;..."] [--echo]
+ *              [--json name]
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <math.h>
+#include "HostBoard.h"
+#include "NJU3711.h"
+
+extern NJU3711* benchDevices[];
+extern uint8_t benchDeviceCount;
+
+static bool parsePins(const char* text, uint8_t* pins, uint8_t maxPins, uint8_t& count) {
+    count = 0;
+    while (*text && count < maxPins) {
+        char* end;
+        unsigned long pin = strtoul(text, &end, 10);
+        if (end == text || pin > 255) return false;
+        pins[count++] = (uint8_t)pin;
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return *text == '\0';
+}
+
+// A JSON number, or null for a figure that was not measured
+static void printJsonField(const char* key, double value, uint8_t decimals, bool measured) {
+    printf(",\"%s\":", key);
+    if (measured) {
+        printf("%.*f", decimals, value);
+    } else {
+        printf("null");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned long seconds = 10;
+    const char* jsonName = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        uint8_t pins[HOST_MAX_DIGITS];
+        uint8_t count;
+        bool hasValue = (i + 1 < argc);
+
+        if (!strcmp(argv[i], "--seconds") && hasValue) {
+            seconds = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--bus") && hasValue && parsePins(argv[++i], pins, 3, count) && count == 3) {
+            hostAddBus(pins[0], pins[1], pins[2]);
+        } else if (!strcmp(argv[i], "--digits") && hasValue && parsePins(argv[++i], pins, HOST_MAX_DIGITS, count)) {
+            for (uint8_t d = 0; d < count; d++) hostAddDigit(pins[d]);
+        } else if (!strcmp(argv[i], "--input") && hasValue && hostSetSerialScript(argv[++i])) {
+        } else if (!strcmp(argv[i], "--json") && hasValue) {
+            jsonName = argv[++i];
+        } else if (!strcmp(argv[i], "--echo")) {
+            hostBoard.echoSerial = true;
+        } else {
+            fprintf(stderr, "bench: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+    if (seconds == 0) seconds = 1;
+
+    setup();
+
+    // Measure from the end of setup(), so start-up delays do not count
+    uint64_t start = hostBoard.clock.now();
+    uint64_t end = start + (uint64_t)seconds * 1000000;
+    uint64_t nextSample = start + 1000000;
+    uint64_t loops = 0;
+    unsigned long latchStart[HOST_MAX_BUSES];
+    uint64_t busyStart[HOST_MAX_BUSES];
+    double loadSum = 0;
+    float loadMax = 0;
+    unsigned long samples = 0;
+    unsigned long worstCall = 0;
+    unsigned long overflowsStart = 0;
+
+    for (uint8_t b = 0; b < hostBoard.busCount; b++) {
+        latchStart[b] = hostBoard.buses[b].latches;
+        busyStart[b] = hostBoard.buses[b].busyMicros;
+    }
+#if NJU3711_ENABLE_STATISTICS
+    for (uint8_t i = 0; i < benchDeviceCount; i++) {
+        overflowsStart += benchDevices[i]->getQueueOverflows();
+    }
+#endif
+    for (uint8_t d = 0; d < hostBoard.digitCount; d++) {
+        HostDigitTrace& digit = hostBoard.digits[d];
+        digit.intervals = 0;
+        digit.sum = 0;
+        digit.sumSquares = 0;
+        digit.worstInterval = 0;
+    }
+
+    while (hostBoard.clock.now() < end) {
+        loop();
+        hostLoopOverhead();
+        loops++;
+
+        // Load of the last completed one-second window of each device
+        if (hostBoard.clock.now() >= nextSample) {
+            nextSample += 1000000;
+#if NJU3711_ENABLE_LOAD_METER
+            float load = 0;
+            for (uint8_t i = 0; i < benchDeviceCount; i++) {
+                NJU3711_LoadMeter& meter = benchDevices[i]->getLoadMeter();
+                load += meter.getLoadPercent();
+                if (meter.getWorstCallMicros() > worstCall) worstCall = meter.getWorstCallMicros();
+            }
+            loadSum += load;
+            if (load > loadMax) loadMax = load;
+            samples++;
+#endif
+        }
+    }
+
+    double elapsed = (hostBoard.clock.now() - start) / 1000000.0;
+
+    unsigned long overflows = 0;
+#if NJU3711_ENABLE_STATISTICS
+    for (uint8_t i = 0; i < benchDeviceCount; i++) {
+        overflows += benchDevices[i]->getQueueOverflows();
+    }
+    overflows -= overflowsStart;
+#endif
+
+    // Bus figures are for the busiest bus
+    double busPercent = 0;
+    double bytesPerSecond = 0;
+    for (uint8_t b = 0; b < hostBoard.busCount; b++) {
+        HostBusTrace& bus = hostBoard.buses[b];
+        double percent = 100.0 * (bus.busyMicros - busyStart[b]) / (elapsed * 1000000.0);
+        if (percent > busPercent) {
+            busPercent = percent;
+            bytesPerSecond = (bus.latches - latchStart[b]) / elapsed;
+        }
+    }
+
+    // Refresh stability over all digits
+    unsigned long intervals = 0;
+    double sum = 0;
+    double sumSquares = 0;
+    uint64_t worstGap = 0;
+    for (uint8_t d = 0; d < hostBoard.digitCount; d++) {
+        HostDigitTrace& digit = hostBoard.digits[d];
+        intervals += digit.intervals;
+        sum += digit.sum;
+        sumSquares += digit.sumSquares;
+        if (digit.worstInterval > worstGap) worstGap = digit.worstInterval;
+    }
+
+    double mean = (intervals > 0) ? sum / intervals : 0;
+    double variance = (intervals > 0) ? sumSquares / intervals - mean * mean : 0;
+    double jitter = (variance > 0) ? sqrt(variance) : 0.0;
+
+    if (jsonName != NULL) {
+        printf("{\"schema\":\"nju3711-bench/1\",\"source\":\"host\",\"sketch\":\"%s\",\"timer\":\"virtual\"", jsonName);
+        printJsonField("seconds", elapsed, 0, true);
+        printJsonField("loops_per_s", loops / elapsed, 0, true);
+        printJsonField("load_pct", (samples > 0) ? loadSum / samples : 0, 1, samples > 0);
+        printJsonField("load_max_pct", loadMax, 1, samples > 0);
+        printJsonField("worst_update_us", worstCall, 0, samples > 0);
+        printJsonField("queue_overflows", overflows, 0, NJU3711_ENABLE_STATISTICS);
+        printJsonField("bus_pct", busPercent, 1, hostBoard.busCount > 0);
+        printJsonField("bytes_per_s", bytesPerSecond, 0, hostBoard.busCount > 0);
+        printJsonField("refresh_hz", (intervals > 0) ? 1000000.0 / mean : 0, 1, intervals > 0);
+        printJsonField("jitter_us", jitter, 0, intervals > 0);
+        printJsonField("worst_gap_us", (double)worstGap, 0, intervals > 0);
+        printf("}\n");
+        return 0;
+    }
+
+    printf("%10.0f", loops / elapsed);
+    if (samples > 0) {
+        printf(" %7.1f %7.1f %7lu", loadSum / samples, loadMax, worstCall);
+    } else {
+        printf(" %7s %7s %7s", "-", "-", "-");
+    }
+    printf(" %9lu %6.1f %8.0f", overflows, busPercent, bytesPerSecond);
+    if (intervals > 0) {
+        printf(" %8.1f %8.0f %9lu\n", 1000000.0 / mean, jitter, (unsigned long)worstGap);
+    } else {
+        printf(" %8s %8s %9s\n", "-", "-", "-");
+    }
+    return 0;
+}
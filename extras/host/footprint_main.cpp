@@ -0,0 +1,25 @@
+/*
+ * footprint_main.cpp - Object Sizes per Feature Combination
+ *
+ * Built by extras/footprint_report.sh once per feature combination, with
+ * the same flags as the library objects. Prints the size of each device
+ * class on one line, in the order NJU3711, NJU3711_7Segment,
+ * NJU3711_7Segment_Multi, for the script to put in its table.
+ *
+ * Usage: footprint
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "NJU3711.h"
+#include "NJU3711_7Segment.h"
+#include "NJU3711_7Segment_Multi.h"
+
+int main() {
+    printf("%u %u %u\n", (unsigned)sizeof(NJU3711), (unsigned)sizeof(NJU3711_7Segment),
+           (unsigned)sizeof(NJU3711_7Segment_Multi));
+    return 0;
+}
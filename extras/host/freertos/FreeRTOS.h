@@ -0,0 +1,52 @@
+/*
+ * FreeRTOS.h - Host Stand-In for the FreeRTOS API Used by NJU3711_RTOS.h
+ *
+ * Just enough of FreeRTOS for extras/host/rtos_main.cpp to run an
+ * NJU3711_RTOSTask on the host's virtual clock. There is one task, run
+ * on the calling thread, and the tick rate is a variable so one build can
+ * try several. The check defines the functions declared here; it models
+ * tick aligned timeouts and task notifications.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE         0
+#define pdTRUE          1
+#define pdPASS          1
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFFUL)
+
+extern unsigned long hostTickRate;
+#define configTICK_RATE_HZ  hostTickRate
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+// task.h
+BaseType_t xTaskCreate(TaskFunction_t entry, const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void hostTaskYield();
+#define taskYIELD() hostTaskYield()
+
+// semphr.h
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+#endif // HOST_FREERTOS_H
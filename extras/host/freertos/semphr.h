@@ -0,0 +1,2 @@
+// Host stand-in - everything is declared in FreeRTOS.h
+#include "FreeRTOS.h"
@@ -0,0 +1,483 @@
+/*
+ * fuzz_main.cpp - Random Operation Sequences Against the Pin Trace
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh. Three devices share the board: an NJU3711 with a
+ * CLR pin, one with CLR strapped HIGH and an NJU3711_7Segment_Multi. Each
+ * run draws a random sequence of API calls, each followed by a random
+ * number of update() rounds with random gaps, the devices updated in a
+ * random order. After every call and every update() it checks:
+ *
+ *   - getCurrentData() equals what the traced driver outputs show, so
+ *     the value only changes on the latch edge (STB rising, CLR falling)
+ *   - never two digits lit at once
+ *   - a running test pattern latches its own sequence (1: 00/FF,
+ *     2: 55/AA, 3: walking bit, 4: counter) at its rate, even while the
+ *     other buses are busy
+ *   - once a device is idle, its outputs hold what the calls since the
+ *     last absolute write add up to (write, shift + latch, clear, bit ops)
+ *
+ * A failing sequence is shrunk by dropping ever smaller runs of calls
+ * while it still fails, then printed one call per line.
+ *
+ * Usage: fuzz [--seed N] [--runs N] [--calls N]
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <vector>
+#include "HostBoard.h"
+#include "NJU3711.h"
+#include "NJU3711_7Segment_Multi.h"
+
+#define FUZZ_DEVICES 3          // Bus devices; the last one is the display
+#define FUZZ_DISPLAY 2
+
+enum FuzzKind : uint8_t {
+    FUZZ_WRITE, FUZZ_SET_BIT, FUZZ_CLEAR_BIT, FUZZ_TOGGLE_BIT, FUZZ_SHIFT,
+    FUZZ_LATCH, FUZZ_CLEAR, FUZZ_CLEAR_QUEUE, FUZZ_PATTERN, FUZZ_STOP_PATTERN,
+    FUZZ_STEP_DELAY, FUZZ_SCRUB, FUZZ_NUMBER, FUZZ_MUX_DELAY, FUZZ_MULTIPLEX,
+    FUZZ_BRIGHTNESS, FUZZ_KINDS
+};
+
+static const char* const kindNames[FUZZ_KINDS] = {
+    "write", "setBit", "clearBit", "toggleBit", "shift", "latch", "clear",
+    "clearQueue", "startTestPattern", "stopTestPattern", "setStepDelay",
+    "setScrubInterval", "displayNumber", "setMultiplexDelay",
+    "enableMultiplex", "setBrightness"
+};
+
+struct FuzzCall {
+    uint8_t kind;
+    uint8_t device;
+    uint32_t value;
+    uint32_t extra;
+    uint8_t rounds;             // update() rounds after the call
+    uint16_t gap;               // Idle time before each round (microseconds)
+    uint32_t order;             // Seeds the update order of the rounds
+};
+
+// What the calls since the last resync say a device's outputs should be
+struct FuzzModel {
+    bool known;
+    uint8_t outputs;
+    bool shiftKnown;
+    uint8_t shift;
+    bool pattern;               // Test pattern running
+    uint8_t patternType;
+    unsigned long patternDelay;
+    uint8_t patternLast;        // Last pattern value latched
+    bool patternSeen;           // patternLast is valid
+    bool patternSkipped;        // clearQueue() may have dropped a step
+    bool scrubAtStart;          // A scrub was shifting when the pattern started
+    uint64_t patternLastLatch;
+};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    // xorshift32 - independent of the sketch-facing random()
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t randomBelow(uint32_t n) {
+    return nextRandom() % n;
+}
+
+static FuzzCall randomCall() {
+    FuzzCall call;
+    call.kind = (uint8_t)randomBelow(FUZZ_KINDS);
+    if (call.kind >= FUZZ_NUMBER) {
+        call.device = FUZZ_DISPLAY;
+    } else {
+        call.device = (uint8_t)randomBelow(FUZZ_DISPLAY);
+    }
+    call.value = nextRandom();
+    call.extra = nextRandom();
+    call.rounds = (uint8_t)randomBelow(randomBelow(8) == 0 ? 200 : 24);
+    call.gap = (uint16_t)randomBelow(randomBelow(6) == 0 ? 3000 : 60);
+    call.order = nextRandom();
+    return call;
+}
+
+static void printCall(const FuzzCall& call) {
+    printf("  dev%u.%s(%lu, %lu) then %u updates, gap %uus\n", call.device, kindNames[call.kind],
+           (unsigned long)call.value, (unsigned long)call.extra, call.rounds, call.gap);
+}
+
+// One run of a sequence on a fresh board
+
+class FuzzRun {
+private:
+    NJU3711 _withClear;
+    NJU3711 _strapped;
+    NJU3711_7Segment_Multi _display;
+    NJU3711* _devices[FUZZ_DEVICES];
+    FuzzModel _model[FUZZ_DEVICES];
+    unsigned long _latches[FUZZ_DEVICES];
+    unsigned long _maxGap;
+    const char* _failure;
+    uint8_t _failedDevice;
+
+    bool fail(const char* what, uint8_t device) {
+        if (_failure == NULL) {
+            _failure = what;
+            _failedDevice = device;
+        }
+        return false;
+    }
+
+    // Expected next pattern value after 'last'
+    static uint8_t patternNext(uint8_t type, uint8_t last) {
+        switch (type) {
+            case 1: return (uint8_t)~last;
+            case 2: return (last == 0x55) ? 0xAA : 0x55;
+            case 3: return (uint8_t)((last << 1) | (last >> 7));
+            default: return (uint8_t)(last + 1);
+        }
+    }
+
+    static uint8_t patternFirst(uint8_t type) {
+        switch (type) {
+            case 2: return 0x55;
+            case 3: return 0x01;
+            default: return 0x00;
+        }
+    }
+
+    bool checkPattern(uint8_t d) {
+        FuzzModel& model = _model[d];
+        HostBusTrace& bus = hostBoard.buses[d];
+
+        if (bus.latches != _latches[d]) {
+            _latches[d] = bus.latches;
+            if (model.pattern) {
+                if (model.scrubAtStart) {
+                    // The scrub finished first and re-latched the old value
+                    model.scrubAtStart = false;
+                } else if (model.patternSkipped) {
+                    model.patternSkipped = false;
+                    model.patternSeen = true;
+                    model.patternLast = bus.outputs;
+                } else {
+                    uint8_t expected = model.patternSeen ? patternNext(model.patternType, model.patternLast)
+                                                         : patternFirst(model.patternType);
+                    if (bus.outputs != expected) return fail("test pattern latched a value out of sequence", d);
+                    model.patternSeen = true;
+                    model.patternLast = bus.outputs;
+                }
+                model.patternLastLatch = hostBoard.clock.now();
+            }
+        }
+
+        // Every device is updated once per round, so a step is due after
+        // the delay plus one write of 20 steps, each at most a step delay
+        // and a round (the gap and three update() calls) apart
+        if (model.pattern) {
+            uint64_t bound = model.patternDelay + 24 * (40 + _maxGap + 400);
+            if (hostBoard.clock.now() - model.patternLastLatch > bound) {
+                return fail("test pattern stopped stepping", d);
+            }
+        }
+        return true;
+    }
+
+    bool check() {
+        if (_failure != NULL) return false;
+        if (hostBoard.digitOverlaps != 0) return fail("two digits lit at once", FUZZ_DISPLAY);
+
+        for (uint8_t d = 0; d < FUZZ_DEVICES; d++) {
+            NJU3711& device = *_devices[d];
+            HostBusTrace& bus = hostBoard.buses[d];
+
+            if (device.getCurrentData() != bus.outputs) {
+                return fail("getCurrentData() differs from the latched outputs", d);
+            }
+            if (d == FUZZ_DISPLAY) continue;
+            if (!checkPattern(d)) return false;
+
+            FuzzModel& model = _model[d];
+            if (device.isBusy() || device.isScrubbing()) continue;
+            if (!model.known) {
+                // Calls with an unknown outcome - take what the device settled on
+                model.known = true;
+                model.outputs = bus.outputs;
+                model.shiftKnown = false;
+            } else if (bus.outputs != model.outputs) {
+                return fail("idle outputs differ from the calls made", d);
+            }
+        }
+        return true;
+    }
+
+    void apply(const FuzzCall& call) {
+        NJU3711& device = *_devices[call.device];
+        FuzzModel& model = _model[call.device];
+        uint8_t value = (uint8_t)call.value;
+        uint8_t bit = (uint8_t)(call.value % 9);       // 8 is out of range
+
+        // Bus calls end a test pattern, except bit calls refused for their
+        // bit number. Pattern writes already queued still run.
+        bool stops = (call.kind <= FUZZ_CLEAR || call.kind == FUZZ_STOP_PATTERN);
+        if (call.kind >= FUZZ_SET_BIT && call.kind <= FUZZ_TOGGLE_BIT && bit > 7) stops = false;
+        if (stops && model.pattern) {
+            model.pattern = false;
+            model.known = model.shiftKnown = false;
+        }
+
+        switch (call.kind) {
+            case FUZZ_WRITE:
+                if (device.write(value)) {
+                    model.known = model.shiftKnown = true;
+                    model.outputs = model.shift = value;
+                }
+                break;
+            case FUZZ_SET_BIT:
+            case FUZZ_CLEAR_BIT:
+            case FUZZ_TOGGLE_BIT: {
+                bool ok = (call.kind == FUZZ_SET_BIT) ? device.setBit(bit)
+                        : (call.kind == FUZZ_CLEAR_BIT) ? device.clearBit(bit) : device.toggleBit(bit);
+                if (!ok) break;
+                uint8_t mask = 1 << bit;
+                uint8_t data = (call.kind == FUZZ_SET_BIT) ? (model.outputs | mask)
+                             : (call.kind == FUZZ_CLEAR_BIT) ? (model.outputs & ~mask) : (model.outputs ^ mask);
+                model.outputs = model.shift = data;
+                model.shiftKnown = model.known;
+                break;
+            }
+            case FUZZ_SHIFT:
+                if (device.shift(value)) {
+                    model.shiftKnown = true;
+                    model.shift = value;
+                }
+                break;
+            case FUZZ_LATCH:
+                if (device.latch()) {
+                    model.known = model.shiftKnown;
+                    model.outputs = model.shift;
+                }
+                break;
+            case FUZZ_CLEAR:
+                if (device.clear()) {
+                    model.known = true;
+                    model.outputs = 0;
+                    if (call.device == 1) {
+                        model.shiftKnown = true;        // Software clear shifts 0x00 in
+                        model.shift = 0;
+                    }
+                }
+                break;
+            case FUZZ_CLEAR_QUEUE:
+                device.clearQueue();
+                model.known = model.shiftKnown = false;
+                model.patternSkipped = model.pattern;
+                break;
+            case FUZZ_PATTERN: {
+                uint8_t type = (uint8_t)(call.value % 6);   // 0 and 5 must be refused
+                unsigned long delay = call.extra % 20000;
+                if (device.startTestPattern(type, delay)) {
+                    if (type < 1 || type > 4) fail("startTestPattern() accepted an unknown type", call.device);
+                    model.known = model.shiftKnown = false;
+                    model.pattern = true;
+                    model.patternType = type;
+                    model.patternDelay = delay;
+                    model.patternSeen = false;
+                    model.patternSkipped = false;
+                    model.scrubAtStart = device.isScrubbing();
+                    model.patternLastLatch = hostBoard.clock.now();
+                }
+                break;
+            }
+            case FUZZ_STOP_PATTERN:
+                device.stopTestPattern();
+                break;
+            case FUZZ_STEP_DELAY:
+                device.setStepDelay(call.value % 40);
+                break;
+            case FUZZ_SCRUB:
+                device.setScrubInterval((call.value % 3 == 0) ? 0 : call.extra % 30000);
+                break;
+            case FUZZ_NUMBER:
+                _display.displayNumber((uint16_t)(call.value % 1000), (uint8_t)(call.extra % 4));
+                break;
+            case FUZZ_MUX_DELAY:
+                _display.setMultiplexDelay(100 + call.value % 4000);
+                break;
+            case FUZZ_MULTIPLEX:
+                _display.enableMultiplex(call.value % 4 != 0);
+                break;
+            case FUZZ_BRIGHTNESS:
+                _display.setBrightness((uint8_t)call.value);
+                break;
+        }
+    }
+
+    // One round: every device updated once, in an order drawn from 'order'
+    bool round(uint32_t& order) {
+        uint8_t devices[FUZZ_DEVICES] = { 0, 1, 2 };
+        for (uint8_t n = FUZZ_DEVICES - 1; n > 0; n--) {
+            order = order * 1103515245UL + 12345UL;
+            uint8_t pick = (uint8_t)((order >> 16) % (n + 1));
+            uint8_t swap = devices[n];
+            devices[n] = devices[pick];
+            devices[pick] = swap;
+        }
+        for (uint8_t n = 0; n < FUZZ_DEVICES; n++) {
+            _devices[devices[n]]->update();
+            if (!check()) return false;
+        }
+        return true;
+    }
+
+public:
+    // Digits on PWM pins (as on an Uno), so brightness uses analogWrite()
+    FuzzRun(uint64_t startMicros)
+        : _withClear(2, 4, 7, 8),
+          _strapped(12, 13, 14),
+          _display(15, 16, 17, 9, 10, 11) {
+        hostReset(startMicros);
+        hostAddBus(2, 4, 7, 8);
+        hostAddBus(12, 13, 14);
+        hostAddBus(15, 16, 17);
+        hostAddDigit(9);
+        hostAddDigit(10);
+        hostAddDigit(11);
+        _devices[0] = &_withClear;
+        _devices[1] = &_strapped;
+        _devices[2] = &_display;
+        memset(_model, 0, sizeof(_model));
+        memset(_latches, 0, sizeof(_latches));
+        _maxGap = 0;
+        _failure = NULL;
+        _failedDevice = 0;
+
+        _withClear.begin();
+        _strapped.begin();
+        _display.begin();
+        _display.displayNumber(123);
+        for (uint8_t d = 0; d < FUZZ_DEVICES; d++) {
+            _model[d].known = _model[d].shiftKnown = true;  // begin() queues a clear
+        }
+    }
+
+    // Index of the call that failed (the length of the sequence if it
+    // failed while settling), or -1
+    int run(const std::vector<FuzzCall>& calls) {
+        for (size_t i = 0; i < calls.size(); i++) {
+            const FuzzCall& call = calls[i];
+            apply(call);
+            if (!check()) return (int)i;
+
+            uint32_t order = call.order;
+            if (call.gap > _maxGap) _maxGap = call.gap;
+            for (uint8_t n = 0; n < call.rounds; n++) {
+                hostBoard.clock.advance(call.gap);
+                if (!round(order)) return (int)i;
+            }
+        }
+
+        // Stop the patterns and let every queue drain, so the final
+        // outputs are checked against the model too
+        for (uint8_t d = 0; d < FUZZ_DISPLAY; d++) {
+            FuzzCall stop = { FUZZ_STOP_PATTERN, d, 0, 0, 0, 0, 0 };
+            apply(stop);
+        }
+        uint32_t order = (uint32_t)calls.size();
+        for (uint16_t n = 0; n < 400; n++) {
+            hostBoard.clock.advance(50);
+            if (!round(order)) return (int)calls.size();
+        }
+        return -1;
+    }
+
+    const char* getFailure() { return _failure; }
+    uint8_t getFailedDevice() { return _failedDevice; }
+};
+
+// Start just before the micros() rollover where unsigned long is 32 bits
+// wide as on the board; on a 64-bit host the library would not wrap
+static uint64_t startTime(uint32_t seed) {
+    if (sizeof(unsigned long) != 4) return 1000;
+    return 0xFFFFFFFFULL - (seed % 2000000);
+}
+
+static int runOnce(const std::vector<FuzzCall>& calls, uint32_t seed, const char** failure) {
+    FuzzRun fuzz(startTime(seed));
+    int failed = fuzz.run(calls);
+    if (failure != NULL) *failure = fuzz.getFailure();
+    return failed;
+}
+
+// Drop runs of calls, halving the run length, while the sequence still
+// fails the same way
+static std::vector<FuzzCall> minimise(std::vector<FuzzCall> calls, uint32_t seed, const char* failure) {
+    for (size_t chunk = calls.size() / 2; chunk >= 1; chunk /= 2) {
+        size_t start = 0;
+        while (start < calls.size()) {
+            std::vector<FuzzCall> shorter(calls);
+            size_t end = (start + chunk < shorter.size()) ? start + chunk : shorter.size();
+            shorter.erase(shorter.begin() + start, shorter.begin() + end);
+
+            const char* shorterFailure = NULL;
+            if (runOnce(shorter, seed, &shorterFailure) >= 0 && shorterFailure == failure) {
+                calls = shorter;
+            } else {
+                start += chunk;
+            }
+        }
+    }
+
+    // Only the calls up to the failure matter
+    int failed = runOnce(calls, seed, NULL);
+    if (failed >= 0 && (size_t)failed + 1 < calls.size()) calls.resize(failed + 1);
+    return calls;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = 1;
+    unsigned long runs = 200;
+    unsigned long length = 300;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--runs") && hasValue) {
+            runs = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--calls") && hasValue) {
+            length = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "fuzz: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    for (unsigned long r = 0; r < runs; r++) {
+        uint32_t runSeed = seed + r;
+        rngState = runSeed * 2654435761UL + 1;
+        if (rngState == 0) rngState = 1;
+
+        std::vector<FuzzCall> calls;
+        for (unsigned long i = 0; i < length; i++) calls.push_back(randomCall());
+
+        const char* failure = NULL;
+        if (runOnce(calls, runSeed, &failure) < 0) continue;
+
+        std::vector<FuzzCall> shortest = minimise(calls, runSeed, failure);
+        FuzzRun replay(startTime(runSeed));
+        replay.run(shortest);
+        printf("fuzz: seed %lu failed: %s (dev%u)\n", (unsigned long)runSeed, failure, replay.getFailedDevice());
+        printf("  %u of %lu calls still fail:\n", (unsigned)shortest.size(), length);
+        for (size_t i = 0; i < shortest.size(); i++) printCall(shortest[i]);
+        return 1;
+    }
+
+    printf("fuzz: %lu runs of %lu calls from seed %lu passed\n", runs, length, (unsigned long)seed);
+    return 0;
+}
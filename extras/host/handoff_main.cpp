@@ -0,0 +1,246 @@
+/*
+ * handoff_main.cpp - Frame Handoff Under a Refresh Thread
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh. An NJU3711_7Segment_Multi with frame handoff is
+ * scanned by an NJU3711_RefreshThread (std::thread) while the main thread
+ * publishes numbered frames as fast as it can. Both sides yield at random
+ * points, so they interleave finely even on a single core.
+ *
+ * Each frame carries its number in the first two digits (DP included) and
+ * a check byte in the third. The refresh side decodes every complete scan
+ * from the traced bus outputs and digit pins:
+ * - the three digits of a scan come from one frame (no torn frames)
+ * - frame numbers never go backwards
+ * - no two digits are lit at once
+ * and once the writer stops, the last frame published reaches the digits.
+ * The main thread then stops the scan with disableMultiplex(), which must
+ * leave the digits dark, and restarts it with enableMultiplex() after
+ * clearDisplay(), which must bring blank scans.
+ *
+ * Only the refresh thread calls into the Arduino stand-in; the main
+ * thread touches nothing but the frame setters, publishFrame(),
+ * clearDisplay() and enableMultiplex()/disableMultiplex().
+ *
+ * Usage: handoff [--seed N] [--frames N]
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "HostBoard.h"
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_RefreshThread.h"
+
+#define HANDOFF_DIGITS 3
+
+static uint8_t checkByte(uint16_t number) {
+    return (uint8_t)((number * 37U + 11U) ^ (number >> 5) ^ 0xA5);
+}
+
+// xorshift32 - one state per thread, independent of the sketch-facing random()
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint32_t seedState(uint32_t seed) {
+    uint32_t state = seed * 2654435761UL + 1;
+    return (state == 0) ? 1 : state;
+}
+
+// Byte n of a frame is the pattern digit n latches (segments | DP bit 0)
+static NJU3711_Frame encodeFrame(uint16_t number) {
+    uint8_t bytes[HANDOFF_DIGITS] = { (uint8_t)number, (uint8_t)(number >> 8), checkByte(number) };
+    NJU3711_Frame frame;
+    frame.dpMask = 0;
+    frame.enabledMask = 0x07;
+    for (uint8_t i = 0; i < HANDOFF_DIGITS; i++) {
+        frame.segments[i] = bytes[i] & 0xFE;
+        if (bytes[i] & 0x01) frame.dpMask |= (1 << i);
+    }
+    return frame;
+}
+
+// The display plus the checks, run together by the refresh thread
+class HandoffScan {
+private:
+    bool _lit[HANDOFF_DIGITS];
+    uint8_t _scanBytes[HANDOFF_DIGITS];
+    uint8_t _scanDigits;        // Digits of the current scan seen so far (0xFF before the first)
+    uint32_t _rng;
+
+    void digitOn(uint8_t digit) {
+        uint8_t latched = hostBoard.buses[0].outputs;
+        if (display.getDisplayMode() == ACTIVE_LOW) latched = ~latched;
+
+        if (digit == 0) _scanDigits = 0;
+        if (_scanDigits == 0xFF) return;    // The first scan after begin() starts at digit 1
+        if (digit != _scanDigits) {
+            failure = "digits were scanned out of order";
+            return;
+        }
+        _scanBytes[digit] = latched;
+        if (++_scanDigits < HANDOFF_DIGITS) return;
+
+        if (_scanBytes[0] == 0 && _scanBytes[1] == 0 && _scanBytes[2] == 0 && cleared.load()) {
+            blankScans++;
+            return;
+        }
+        uint16_t number = _scanBytes[0] | ((uint16_t)_scanBytes[1] << 8);
+        if (_scanBytes[2] != checkByte(number)) {
+            failure = "a scan mixed digits of two frames";
+            return;
+        }
+        if (scans > 0 && number < shown.load()) {
+            failure = "an older frame came back";
+            return;
+        }
+        if (scans == 0 || number != shown.load()) frames++;
+        scans++;
+        shown.store(number);
+    }
+
+public:
+    NJU3711_7Segment_Multi display;
+    std::atomic<uint16_t> shown;    // Last frame scanned completely
+    unsigned long scans;
+    unsigned long frames;           // Distinct frames scanned
+    std::atomic<bool> cleared;      // clearDisplay() was called, blank scans are expected
+    std::atomic<unsigned long> blankScans;
+    std::atomic<unsigned long> darkUpdates;     // Updates in a row with every digit off
+    const char* failure;
+
+    explicit HandoffScan(uint32_t seed)
+        : display(2, 4, 7, 9, 10, 12), shown(0), scans(0), frames(0),
+          cleared(false), blankScans(0), darkUpdates(0), failure(NULL) {
+        memset(_lit, 0, sizeof(_lit));
+        _scanDigits = 0xFF;
+        _rng = seedState(~seed);
+    }
+
+    void update() {
+        if (failure != NULL) return;
+        display.update();
+        if (hostBoard.digitOverlaps > 0) failure = "two digits were lit at once";
+
+        bool dark = true;
+        for (uint8_t d = 0; d < HANDOFF_DIGITS; d++) {
+            bool lit = hostBoard.digits[d].lit;
+            if (lit && !_lit[d]) digitOn(d);
+            _lit[d] = lit;
+            if (lit) dark = false;
+        }
+        darkUpdates.store(dark ? darkUpdates.load() + 1 : 0);
+
+        // Hand the CPU to the writer at random points, so the two sides
+        // interleave finely even on a single core
+        if (nextRandom(_rng) % 32 == 0) std::this_thread::yield();
+    }
+};
+
+int main(int argc, char** argv) {
+    uint32_t seed = 1;
+    unsigned long count = 60000;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--frames") && hasValue) {
+            count = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "handoff: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+    if (count > 0xFFFF) count = 0xFFFF;     // Frame numbers are 16-bit
+    uint32_t rng = seedState(seed);
+
+    hostReset();
+    hostAddBus(2, 4, 7);
+    hostAddDigit(9);
+    hostAddDigit(10);
+    hostAddDigit(12);
+
+    // Short slots, so frames change hands many times during a scan
+    HandoffScan scan(seed);
+    scan.display.begin();
+    scan.display.setMultiplexDelay(200);
+    scan.display.setBlankingTime(0);
+    scan.display.setFrame(encodeFrame(0));
+    scan.display.enableFrameHandoff();
+
+    NJU3711_RefreshThread<HandoffScan> refresh(scan);
+    if (!refresh.start()) {
+        printf("handoff: no refresh thread on this build\n");
+        return 1;
+    }
+
+    for (unsigned long n = 1; n <= count; n++) {
+        scan.display.setFrame(encodeFrame((uint16_t)n));
+        scan.display.publishFrame();
+        // Random pauses, so publishes land at every point of the scan
+        for (volatile uint32_t spin = nextRandom(rng) % 2000; spin > 0; spin--) {
+        }
+        if (nextRandom(rng) % 4 == 0) std::this_thread::yield();
+    }
+
+    // The refresh side must catch up with the last frame
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (scan.shown.load() != count && scan.failure == NULL && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    // Stopping the scan from here must leave the pins to the refresh side,
+    // which switches the digits off for good
+    bool stopped = false;
+    if (scan.failure == NULL && scan.shown.load() == count) {
+        scan.display.disableMultiplex();
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (scan.darkUpdates.load() < 10000 && scan.failure == NULL &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        stopped = (scan.darkUpdates.load() >= 10000);
+
+        // A cleared display comes back blank once scanning resumes
+        scan.cleared.store(true);
+        scan.display.clearDisplay();
+        scan.display.enableMultiplex();
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (scan.blankScans.load() < 3 && scan.failure == NULL &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+    refresh.stop();
+
+    if (scan.failure != NULL) {
+        printf("handoff: %s (after %lu scans, seed %lu)\n", scan.failure, scan.scans, (unsigned long)seed);
+        return 1;
+    }
+    if (scan.shown.load() != count) {
+        printf("handoff: the last frame published (%lu) never reached the digits, frame %u did\n",
+               count, (unsigned)scan.shown.load());
+        return 1;
+    }
+    if (!stopped) {
+        printf("handoff: the digits stayed lit after disableMultiplex()\n");
+        return 1;
+    }
+    if (scan.blankScans.load() < 3) {
+        printf("handoff: no blank scan after clearDisplay() and enableMultiplex()\n");
+        return 1;
+    }
+    printf("handoff: %lu frames published, %lu scans showed %lu of them whole and in order\n",
+           count, scan.scans, scan.frames);
+    return 0;
+}
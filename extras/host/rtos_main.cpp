@@ -0,0 +1,424 @@
+/*
+ * rtos_main.cpp - NJU3711_RTOSTask Sleeping on Virtual Time
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh, with the FreeRTOS stand-in in extras/host/freertos.
+ * The adapter's task runs on the main thread; this file is its scheduler.
+ * Timeouts end on a tick, as on FreeRTOS, and writes made through the
+ * adapter arrive at random times as from other tasks.
+ *
+ * At several tick rates, for an NJU3711 (which goes idle) and a scanning
+ * NJU3711_7Segment_Multi, every sleep is checked against
+ * getTimeToNextEvent():
+ * - a timed sleep never ends after the deadline, nor two ticks before it
+ * - the task only sleeps without a timeout when nothing is scheduled, and
+ *   then everything written so far is on the outputs
+ * - a write that brings work forward wakes the task
+ * - no digit stays dark for twice its usual refresh interval
+ * Each run ends with end() from inside the task; begin() must then refuse
+ * until the task has exited. After that, a begin() and end() from another
+ * task must leave no task behind.
+ *
+ * Usage: rtos [--seed N] [--runs N]
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "HostBoard.h"
+#include "NJU3711.h"
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_RTOS.h"
+
+#define RTOS_RUN_MICROS     3000000ULL  // Virtual time per run
+#define RTOS_MICROS_SLACK   4           // micros() resolution
+
+unsigned long hostTickRate = 1000;
+
+static const unsigned long tickRates[] = { 100, 1000, 4000, 10000 };
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    // xorshift32 - independent of the sketch-facing random()
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t randomBelow(uint32_t n) {
+    return nextRandom() % n;
+}
+
+// One run: a device behind an adapter, and the writes other tasks make
+class RtosRun {
+public:
+    const char* failure;
+    unsigned long sleeps;
+    unsigned long idleSleeps;
+    unsigned long yields;
+    unsigned long events;
+
+    RtosRun() : failure(NULL), sleeps(0), idleSleeps(0), yields(0), events(0) {}
+    virtual ~RtosRun() {}
+
+    virtual unsigned long timeToNextEvent() = 0;
+    virtual void event() = 0;               // A write from another task
+    virtual bool settled() = 0;             // Everything written is on the outputs
+    virtual bool restart() = 0;             // The adapter's begin() alone
+    virtual void end() = 0;
+    virtual bool running() = 0;
+};
+
+// Scheduler state of the single task
+static RtosRun* current;
+static TaskFunction_t taskEntry;
+static void* taskArg;
+static bool taskAlive;          // Created and not yet deleted
+static bool inTask;             // The task's code is on the stack
+static uint32_t notifications;
+static bool mutexHeld;
+static uint64_t nextEventTime;
+static uint64_t endTime;
+static bool ending;
+
+static uint64_t tickMicros() {
+    return 1000000ULL / hostTickRate;
+}
+
+static void fail(const char* what) {
+    if (current->failure == NULL) current->failure = what;
+    if (!ending) {
+        ending = true;
+        current->end();
+    }
+}
+
+// Run the writes due by now, and stop the task at the end of the run
+static void runDueEvents() {
+    while (!ending && hostBoard.clock.now() >= nextEventTime) {
+        current->events++;
+        current->event();
+        // Mostly spread out, sometimes a burst
+        nextEventTime = hostBoard.clock.now() + ((randomBelow(4) == 0) ? randomBelow(500) : randomBelow(80000));
+    }
+    if (!ending && hostBoard.clock.now() >= endTime) {
+        // Stopped from inside, the task is still there until it returns
+        ending = true;
+        current->end();
+        if (current->restart()) {
+            fail("begin() started a task before the stopped one had exited");
+            current->end();     // Or the revived loop would run forever
+        }
+    }
+}
+
+// Run the task's code until it deletes itself
+static void runTaskCode() {
+    inTask = true;
+    taskEntry(taskArg);
+    inTask = false;
+}
+
+// --- FreeRTOS stand-in ----------------------------------------------------
+
+BaseType_t xTaskCreate(TaskFunction_t entry, const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    if (taskAlive) fail("a second task was created while the first was alive");
+    taskAlive = true;
+    taskEntry = entry;
+    taskArg = arg;
+    if (handle != NULL) *handle = (TaskHandle_t)&taskEntry;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+    taskAlive = false;
+}
+
+// From another task, a delay lets the adapter's task run
+void vTaskDelay(TickType_t ticks) {
+    if (!inTask && taskAlive) {
+        runTaskCode();
+    } else {
+        hostBoard.clock.advance((unsigned long)(ticks * tickMicros()));
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return inTask ? (TaskHandle_t)&taskEntry : (TaskHandle_t)&current;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    if (notifications == 0) {
+        // The timeout counts from the tick of the call. Asking for the
+        // deadline costs virtual time, so that comes second.
+        uint64_t called = hostBoard.clock.now();
+        unsigned long due = current->timeToNextEvent();
+        uint64_t now = hostBoard.clock.now();
+        uint64_t wakeAt = 0;
+
+        if (ticksToWait == portMAX_DELAY) {
+            current->idleSleeps++;
+            if (due != NJU3711_NO_EVENT) fail("slept without a timeout while work was scheduled");
+            if (!current->settled()) fail("slept without a timeout before the writes reached the outputs");
+        } else {
+            // The timeout ends on the ticksToWait-th tick from now
+            current->sleeps++;
+            wakeAt = (called / tickMicros() + ticksToWait) * tickMicros();
+            if (due == NJU3711_NO_EVENT) {
+                fail("slept with a timeout while nothing was scheduled");
+            } else if (wakeAt > now + due + RTOS_MICROS_SLACK) {
+                fail("slept past the deadline");
+            } else if (wakeAt + 2 * tickMicros() + RTOS_MICROS_SLACK < now + due) {
+                fail("woke more than two ticks before the deadline");
+            }
+        }
+
+        // Sleep until the timeout or a notification from a write
+        while (notifications == 0 && !ending) {
+            uint64_t until = (ticksToWait == portMAX_DELAY || nextEventTime < wakeAt) ? nextEventTime : wakeAt;
+            if (until > endTime) until = endTime;
+            if (until > hostBoard.clock.now()) hostBoard.clock.advance((unsigned long)(until - hostBoard.clock.now()));
+            runDueEvents();
+            if (ticksToWait != portMAX_DELAY && hostBoard.clock.now() >= wakeAt) break;
+
+            // A write that brings work forward must wake the task
+            if (notifications == 0 && !ending) {
+                unsigned long work = current->timeToNextEvent();
+                if (work != NJU3711_NO_EVENT &&
+                    (ticksToWait == portMAX_DELAY || hostBoard.clock.now() + work + RTOS_MICROS_SLACK < wakeAt)) {
+                    fail("a write did not wake the task");
+                }
+            }
+        }
+    }
+
+    uint32_t value = notifications;
+    if (clearOnExit) {
+        notifications = 0;
+    } else if (notifications > 0) {
+        notifications--;
+    }
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+    notifications++;
+    return pdPASS;
+}
+
+void hostTaskYield() {
+    current->yields++;
+    runDueEvents();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return (SemaphoreHandle_t)&mutexHeld;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticksToWait) {
+    (void)mutex;
+    (void)ticksToWait;
+    // One task: a held mutex here would never be given back
+    if (mutexHeld) fail("the mutex was taken twice");
+    mutexHeld = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    (void)mutex;
+    mutexHeld = false;
+    return pdTRUE;
+}
+
+// --- runs -----------------------------------------------------------------
+
+// NJU3711: writes, shift/latch pairs and clears at random step delays.
+// Without a scrub it goes idle between them, so the task sleeps without a
+// timeout.
+class ExpanderRun : public RtosRun {
+private:
+    NJU3711 _device;
+    NJU3711_RTOSTask<NJU3711> _task;
+    uint8_t _expected;          // What the outputs show once all writes are done
+
+public:
+    ExpanderRun() : _device(2, 4, 7, 8), _task(_device), _expected(0) {}
+
+    bool begin() {
+        _device.begin();
+        return _task.begin();
+    }
+
+    unsigned long timeToNextEvent() { return _device.getTimeToNextEvent(); }
+
+    void event() {
+        uint8_t value = (uint8_t)nextRandom();
+        switch (randomBelow(6)) {
+            case 0:
+                if (_task.clear()) _expected = 0;
+                break;
+            case 1:
+                if (_task.shift(value) && _task.latch()) _expected = value;
+                break;
+            case 2: {
+                unsigned long stepDelay = randomBelow(3) == 0 ? 0 : randomBelow(4000);
+                _task.call([stepDelay](NJU3711& device) { device.setStepDelay(stepDelay); });
+                break;
+            }
+            case 3: {
+                // A scrub keeps a deadline pending, long enough to sleep on
+                unsigned long interval = randomBelow(2) == 0 ? 0 : 5000 + randomBelow(60000);
+                _task.call([interval](NJU3711& device) { device.setScrubInterval(interval); });
+                break;
+            }
+            default:
+                if (_task.write(value)) _expected = value;
+                break;
+        }
+    }
+
+    bool settled() { return hostBoard.buses[0].outputs == _expected; }
+    bool restart() { return _task.begin(); }
+    void end() { _task.end(); }
+    bool running() { return _task.isRunning(); }
+};
+
+// NJU3711_7Segment_Multi: the scan always has a deadline, content changes
+// arrive through call()
+class DisplayRun : public RtosRun {
+private:
+    NJU3711_7Segment_Multi _display;
+    NJU3711_RTOSTask<NJU3711_7Segment_Multi> _task;
+
+public:
+    DisplayRun() : _display(2, 4, 7, 9, 10, 12), _task(_display) {}
+
+    bool begin() {
+        _display.begin();
+        _display.setMultiplexDelay(1000 + randomBelow(5000));
+        return _task.begin();
+    }
+
+    unsigned long timeToNextEvent() { return _display.getTimeToNextEvent(); }
+
+    void event() {
+        uint16_t number = randomBelow(1000);
+        _task.call([number](NJU3711_7Segment_Multi& display) { display.displayNumber(number); });
+    }
+
+    bool settled() { return true; }
+    bool restart() { return _task.begin(); }
+    void end() { _task.end(); }
+    bool running() { return _task.isRunning(); }
+};
+
+// Run the adapter's task until the end of the run
+static bool runTask(RtosRun& run, const char* name, uint32_t seed) {
+    current = &run;
+    nextEventTime = hostBoard.clock.now() + randomBelow(20000);
+    endTime = hostBoard.clock.now() + RTOS_RUN_MICROS;
+    ending = false;
+    notifications = 0;
+    mutexHeld = false;
+
+    runTaskCode();
+    if (taskAlive) fail("the task did not delete itself");
+
+    // Restart and stop from another task: end() returns once the task is gone
+    if (run.failure == NULL) {
+        if (!run.restart()) {
+            fail("begin() refused after the task had exited");
+        } else {
+            run.end();
+            if (taskAlive || run.running()) fail("end() returned before the task had exited");
+        }
+    }
+
+    if (run.failure != NULL) {
+        printf("rtos: %s at %lu Hz: %s (seed %lu, %.6f s in)\n", name, hostTickRate, run.failure,
+               (unsigned long)seed, (double)(hostBoard.clock.now() - (endTime - RTOS_RUN_MICROS)) / 1e6);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = 1;
+    unsigned long runs = 20;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--runs") && hasValue) {
+            runs = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "rtos: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    for (uint8_t r = 0; r < sizeof(tickRates) / sizeof(tickRates[0]); r++) {
+        hostTickRate = tickRates[r];
+        unsigned long sleeps = 0, idleSleeps = 0, yields = 0, events = 0;
+
+        for (unsigned long n = 0; n < runs; n++) {
+            uint32_t runSeed = seed + n;
+            rngState = runSeed * 2654435761UL + 1;
+            if (rngState == 0) rngState = 1;
+
+            {
+                hostReset(1000);
+                hostAddBus(2, 4, 7, 8);
+                ExpanderRun run;
+                if (!run.begin() || !runTask(run, "NJU3711", runSeed)) return 1;
+                sleeps += run.sleeps;
+                idleSleeps += run.idleSleeps;
+                yields += run.yields;
+                events += run.events;
+            }
+            {
+                hostReset(1000);
+                hostAddBus(2, 4, 7);
+                hostAddDigit(9);
+                hostAddDigit(10);
+                hostAddDigit(12);
+                DisplayRun run;
+                if (!run.begin() || !runTask(run, "NJU3711_7Segment_Multi", runSeed)) return 1;
+
+                // A late wake-up shows as a gap well above the usual refresh interval
+                for (uint8_t d = 0; d < hostBoard.digitCount; d++) {
+                    const HostDigitTrace& digit = hostBoard.digits[d];
+                    if (digit.intervals > 0 && digit.worstInterval > 2 * digit.sum / digit.intervals) {
+                        printf("rtos: NJU3711_7Segment_Multi at %lu Hz left a digit dark for %lu us, usually %.0f us"
+                               " (seed %lu)\n", hostTickRate, (unsigned long)digit.worstInterval,
+                               digit.sum / digit.intervals, (unsigned long)runSeed);
+                        return 1;
+                    }
+                }
+                if (hostBoard.digitOverlaps > 0) {
+                    printf("rtos: NJU3711_7Segment_Multi at %lu Hz lit two digits at once (seed %lu)\n",
+                           hostTickRate, (unsigned long)runSeed);
+                    return 1;
+                }
+                sleeps += run.sleeps;
+                idleSleeps += run.idleSleeps;
+                yields += run.yields;
+                events += run.events;
+            }
+        }
+        printf("rtos: %5lu Hz tick: %lu timed sleeps, %lu idle sleeps, %lu yields, %lu writes - passed\n",
+               hostTickRate, sleeps, idleSleeps, yields, events);
+    }
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*
+ * soak_main.cpp - Long Runs on Virtual Time
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh. Runs four setups for hours of virtual time
+ * with NJU3711_FastForward, starting just before the micros() rollover,
+ * and checks after every update():
+ *
+ *   pattern    NJU3711 running test pattern 1 every 10ms: the outputs
+ *              alternate 0xFF/0x00 on time, without a missed step
+ *   animation  NJU3711_7Segment rotating every 100ms: the outputs step
+ *              through the frames on time and the animation keeps running
+ *   clock      NJU3711_TimeDisplay on a NJU3711_7Segment_Multi: the time
+ *              shown matches the time elapsed, the scan rate is the same
+ *              in every hour, no two digits are lit at once and no digit
+ *              stays dark for two frames
+ *   keypad     NJU3711_7Segment_Multi blank under NJU3711_REFRESH_SUSPEND
+ *              with keys pressed in turn: every press and release is
+ *              reported within three digit slots, and the key polls
+ *              light no segment
+ *
+ * In every setup the longest run of update() calls that reported work
+ * due at once must stay short (a state machine that spins without
+ * progress would make it grow).
+ *
+ * Usage: soak [--hours N]
+ *   N defaults to 2, the least that compares the scan rate of two hours.
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "HostBoard.h"
+#include "NJU3711.h"
+#include "NJU3711_7Segment.h"
+#include "NJU3711_7Segment_Multi.h"
+#include "NJU3711_TimeDisplay.h"
+#include "NJU3711_Simulation.h"
+
+#define SOAK_HOUR           3600000000ULL
+#define SOAK_PATTERN_DELAY  10000UL
+#define SOAK_FRAME_DELAY    100000UL
+#define SOAK_SLACK          200UL       // Latch delay allowed after a step is due (microseconds)
+#define SOAK_BUSY_STREAK    24          // Updates in a row with work due at once (a transfer is 19)
+#define SOAK_SCAN_SPREAD    1000        // Frames per hour may differ by 1/1000
+#define SOAK_KEY_PIN        13
+#define SOAK_KEY_PERIOD     1700000UL   // One press per period, keys in turn
+#define SOAK_KEY_HOLD       50000UL
+#define SOAK_KEY_DEBOUNCE   20
+
+// What changes on the outputs of bus 0, and when
+struct SoakOutputs {
+    uint8_t last;
+    uint64_t lastChange;
+    unsigned long changes;
+};
+
+static SoakOutputs outputs;
+static const char* soakFailure;
+static uint64_t soakFailureTime;
+
+static bool fail(const char* what) {
+    soakFailure = what;
+    soakFailureTime = hostBoard.clock.now();
+    return false;
+}
+
+// Start just before the micros() rollover where unsigned long is 32 bits
+// wide as on the board; on a 64-bit host the library would not wrap
+static void startBoard() {
+    hostReset(sizeof(unsigned long) == 4 ? 0xFFFFFFFFULL - 3000000ULL : 1000);
+    memset(&outputs, 0, sizeof(outputs));
+}
+
+// Returns true when the outputs of bus 0 have changed since the last call
+static bool outputsChanged(uint64_t& interval) {
+    uint8_t now = hostBoard.buses[0].outputs;
+    if (now == outputs.last) return false;
+    interval = hostBoard.clock.now() - outputs.lastChange;
+    outputs.last = now;
+    outputs.lastChange = hostBoard.clock.now();
+    outputs.changes++;
+    return true;
+}
+
+// --- pattern --------------------------------------------------------------
+
+static bool checkPattern() {
+    uint64_t interval;
+    if (!outputsChanged(interval)) {
+        if (outputs.changes > 0 && hostBoard.clock.now() - outputs.lastChange > SOAK_PATTERN_DELAY + SOAK_SLACK) {
+            return fail("a pattern step is late or missing");
+        }
+        return true;
+    }
+    if (outputs.last != 0xFF && outputs.last != 0x00) return fail("the outputs left the pattern");
+    if (outputs.changes > 1 && interval + SOAK_SLACK < SOAK_PATTERN_DELAY) {
+        return fail("a pattern step came early");
+    }
+    return true;
+}
+
+// --- animation ------------------------------------------------------------
+
+static NJU3711_7Segment* animated;
+static uint8_t frames[6];
+
+static bool checkAnimation() {
+    if (!animated->isAnimating()) return fail("the animation stopped");
+
+    uint64_t interval;
+    if (!outputsChanged(interval)) {
+        if (outputs.changes > 0 && hostBoard.clock.now() - outputs.lastChange > SOAK_FRAME_DELAY + SOAK_SLACK) {
+            return fail("an animation frame is late or missing");
+        }
+        return true;
+    }
+    if (outputs.changes > 1 && interval + SOAK_SLACK < SOAK_FRAME_DELAY) {
+        return fail("an animation frame came early");
+    }
+    // Every frame follows the one six frames before it
+    uint8_t slot = outputs.changes % 6;
+    if (outputs.changes > 6 && frames[slot] != outputs.last) return fail("an animation frame is out of order");
+    frames[slot] = outputs.last;
+    return true;
+}
+
+// --- clock ----------------------------------------------------------------
+
+// The display shows the clock; update() drives both
+struct SoakClock {
+    NJU3711_7Segment_Multi display;
+    NJU3711_TimeDisplay time;
+
+    SoakClock() : display(2, 4, 7, 9, 10, 12) {}
+
+    void update() {
+        display.update();
+        time.update();
+        uint8_t dirty = time.takeDirty();
+        for (uint8_t i = 0; i < 3; i++) {
+            if (dirty & (1 << i)) display.setDigitRaw(i, time.getSegments(i));
+        }
+    }
+
+    unsigned long getTimeToNextEvent() {
+        return display.getTimeToNextEvent();
+    }
+};
+
+static SoakClock* clockRig;
+static uint64_t clockStart;
+static uint64_t hourStart;
+static uint16_t lastFrameCount;
+static unsigned long hourFrames;
+static unsigned long minFrames;
+static unsigned long maxFrames;
+static long worstDrift;
+
+static bool checkClock() {
+    uint64_t now = hostBoard.clock.now();
+
+    uint16_t frameCount = clockRig->display.getFrameCount();
+    hourFrames += (uint16_t)(frameCount - lastFrameCount);
+    lastFrameCount = frameCount;
+    if (now - hourStart >= SOAK_HOUR) {
+        if (hourFrames < minFrames) minFrames = hourFrames;
+        if (hourFrames > maxFrames) maxFrames = hourFrames;
+        hourFrames = 0;
+        hourStart += SOAK_HOUR;
+    }
+
+    // Away from a second boundary, the time shown is the time elapsed
+    uint64_t elapsed = now - clockStart;
+    unsigned long intoSecond = (unsigned long)(elapsed % 1000000ULL);
+    if (intoSecond > 100000UL && intoSecond < 900000UL) {
+        long shown = clockRig->time.getHours() * 3600L + clockRig->time.getMinutes() * 60L +
+                     clockRig->time.getSeconds();
+        long expected = (long)((elapsed / 1000000ULL) % 86400ULL);
+        long drift = shown - expected;
+        if (drift > 43200L) drift -= 86400L;
+        if (drift < -43200L) drift += 86400L;
+        if (labs(drift) > labs(worstDrift)) worstDrift = drift;
+        if (drift != 0) return fail("the clock drifted");
+    }
+
+    if (hostBoard.digitOverlaps > 0) return fail("two digits were lit at once");
+    return true;
+}
+
+// --- keypad ---------------------------------------------------------------
+
+static NJU3711_7Segment_Multi* keyed;
+static uint64_t keyStart;
+static uint8_t keyHeld;         // Key held by the script, 0xFF if none
+static uint8_t keyLast;         // Key pressed last
+static uint64_t keyChange;      // When the script last pressed or released
+static bool keyReported;        // The last change has been reported
+static unsigned long keyPresses;
+static uint64_t worstKeyLatency;
+
+static bool checkKeypad() {
+    uint64_t now = hostBoard.clock.now();
+    uint64_t intoPeriod = (now - keyStart) % SOAK_KEY_PERIOD;
+    uint8_t key = (uint8_t)(((now - keyStart) / SOAK_KEY_PERIOD) % 3);
+    uint8_t held = (intoPeriod < SOAK_KEY_HOLD) ? key : 0xFF;
+
+    if (!keyReported) {
+        bool reported = (keyHeld != 0xFF) ? keyed->wasKeyPressed(keyHeld) : keyed->wasKeyReleased(keyLast);
+        if (reported) {
+            keyReported = true;
+            if (now - keyChange > worstKeyLatency) worstKeyLatency = now - keyChange;
+            if (keyHeld != 0xFF) keyPresses++;
+        } else if (now - keyChange > 3UL * keyed->getMultiplexDelay() + SOAK_SLACK) {
+            return fail(keyHeld != 0xFF ? "a key press was missed" : "a key release was missed");
+        }
+    }
+    if (held != keyHeld) {
+        if (!keyReported && keyChange != 0) return fail("a key change was missed");
+        keyHeld = held;
+        if (held != 0xFF) keyLast = held;
+        hostBoard.keysDown = (held != 0xFF) ? (1 << held) : 0;
+        keyChange = now;
+        keyReported = false;
+    }
+
+    uint8_t blank = (keyed->getDisplayMode() == ACTIVE_LOW) ? 0xFF : 0x00;
+    for (uint8_t d = 0; d < hostBoard.digitCount; d++) {
+        if (hostBoard.digits[d].lit && hostBoard.buses[0].outputs != blank) {
+            return fail("a key poll lit segments");
+        }
+    }
+    if (hostBoard.digitOverlaps > 0) return fail("two digits were lit at once");
+    return true;
+}
+
+// --- runs -----------------------------------------------------------------
+
+template <class Device>
+static bool soak(const char* name, NJU3711_FastForward<Device>& ff, uint64_t duration, NJU3711_SimCheck check) {
+    uint64_t start = hostBoard.clock.now();
+    soakFailure = NULL;
+    if (!ff.run(duration, check)) {
+        printf("soak: %s failed after %.6f s of virtual time: %s\n", name,
+               (double)(soakFailureTime - start) / 1e6, soakFailure);
+        return false;
+    }
+    if (ff.getWorstBusyStreak() > SOAK_BUSY_STREAK) {
+        printf("soak: %s had %lu updates in a row with work due at once\n", name,
+               (unsigned long)ff.getWorstBusyStreak());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    unsigned long hours = 2;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--hours") && i + 1 < argc) {
+            hours = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "soak: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+    if (hours < 2) hours = 2;  // The scan rate is compared between whole hours
+    uint64_t duration = hours * SOAK_HOUR;
+
+    // pattern
+    {
+        startBoard();
+        hostAddBus(2, 4, 7, 8);
+        NJU3711 device(2, 4, 7, 8);
+        device.begin();
+        NJU3711_FastForward<NJU3711> ff(device, hostBoard.clock);
+        ff.run(1000);
+        device.startTestPattern(1, SOAK_PATTERN_DELAY);
+        if (!soak("pattern", ff, duration, checkPattern)) return 1;
+        printf("soak: pattern   %lu steps in %lu h, busy streak %lu\n", outputs.changes, hours,
+               (unsigned long)ff.getWorstBusyStreak());
+    }
+
+    // animation
+    {
+        startBoard();
+        hostAddBus(2, 4, 7);
+        NJU3711_7Segment display(2, 4, 7);
+        display.begin();
+        NJU3711_FastForward<NJU3711_7Segment> ff(display, hostBoard.clock);
+        ff.run(1000);
+        display.startAnimation(ANIM_ROTATE_CW, SOAK_FRAME_DELAY);
+        animated = &display;
+        if (!soak("animation", ff, duration, checkAnimation)) return 1;
+        printf("soak: animation %lu frames in %lu h, busy streak %lu\n", outputs.changes, hours,
+               (unsigned long)ff.getWorstBusyStreak());
+    }
+
+    // clock
+    {
+        startBoard();
+        hostAddBus(2, 4, 7);
+        hostAddDigit(9);
+        hostAddDigit(10);
+        hostAddDigit(12);
+        SoakClock rig;
+        clockRig = &rig;
+        rig.display.begin();
+        rig.time.setTime(0, 0, 0);
+        clockStart = hostBoard.clock.now();
+        hourStart = clockStart;
+        lastFrameCount = rig.display.getFrameCount();
+        hourFrames = 0;
+        minFrames = 0xFFFFFFFFUL;
+        maxFrames = 0;
+        worstDrift = 0;
+        NJU3711_FastForward<SoakClock> ff(rig, hostBoard.clock);
+        if (!soak("clock", ff, duration, checkClock)) return 1;
+
+        uint64_t worstGap = 0;
+        for (uint8_t d = 0; d < hostBoard.digitCount; d++) {
+            if (hostBoard.digits[d].worstInterval > worstGap) worstGap = hostBoard.digits[d].worstInterval;
+        }
+        if (maxFrames - minFrames > maxFrames / SOAK_SCAN_SPREAD) {
+            printf("soak: clock scanned %lu to %lu frames per hour\n", minFrames, maxFrames);
+            return 1;
+        }
+        if (worstGap > 2UL * 3 * rig.display.getMultiplexDelay()) {
+            printf("soak: clock left a digit dark for %lu us\n", (unsigned long)worstGap);
+            return 1;
+        }
+        printf("soak: clock     drift %ld s, %lu-%lu frames per hour, worst digit gap %lu us, busy streak %lu\n",
+               worstDrift, minFrames, maxFrames, (unsigned long)worstGap, (unsigned long)ff.getWorstBusyStreak());
+    }
+
+    // keypad
+    {
+        startBoard();
+        hostAddBus(2, 4, 7);
+        hostAddDigit(9);
+        hostAddDigit(10);
+        hostAddDigit(12);
+        hostBoard.keyReturnPin = SOAK_KEY_PIN;
+        NJU3711_7Segment_Multi display(2, 4, 7, 9, 10, 12);
+        display.begin();
+        display.setRefreshPolicy(NJU3711_REFRESH_SUSPEND);
+        display.beginKeypad(SOAK_KEY_PIN, SOAK_KEY_DEBOUNCE);
+        display.clearDisplay();
+        // Let the scan stop first; begin() and the blank frame are two
+        // transfers back to back, which is not a spin
+        NJU3711_FastForward<NJU3711_7Segment_Multi> settle(display, hostBoard.clock);
+        settle.run(100000);
+        NJU3711_FastForward<NJU3711_7Segment_Multi> ff(display, hostBoard.clock);
+        keyed = &display;
+        keyStart = hostBoard.clock.now();
+        keyHeld = 0xFF;
+        keyLast = 0;
+        keyChange = 0;
+        keyReported = true;
+        keyPresses = 0;
+        worstKeyLatency = 0;
+        if (!soak("keypad", ff, duration, checkKeypad)) return 1;
+        printf("soak: keypad    %lu presses while blank, worst report %lu us, busy streak %lu\n", keyPresses,
+               (unsigned long)worstKeyLatency, (unsigned long)ff.getWorstBusyStreak());
+    }
+
+    printf("soak: %lu virtual hours per setup passed\n", hours);
+    return 0;
+}
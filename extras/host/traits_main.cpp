@@ -0,0 +1,295 @@
+/*
+ * traits_main.cpp - Static Dispatch of NJU3711_Display
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh. The static_asserts below are the compile-time
+ * half: the digit counts, the signatures every display exposes, no
+ * vtable, and that a type without NJU3711_DisplayTraits (including a
+ * class derived from a supported one) is rejected. If any fails, the
+ * check does not build.
+ *
+ * At run time one generic template drives every supported display, plus
+ * a user class with its own traits, and the result is read back from the
+ * traced pins, the frame or the sink. update() through the wrapper must
+ * reach the concrete class: a 7-segment animation must step and a
+ * multiplexed display must scan.
+ *
+ * Usage: traits
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <type_traits>
+#include <utility>
+#include "HostBoard.h"
+#include "NJU3711_Display.h"
+#include "NJU3711_Sink.h"
+
+typedef NJU3711_SegmentRenderer<NJU3711_RecorderSink<> > RecorderDisplay;
+
+// --- compile time ---------------------------------------------------------
+
+// True once Traits is a complete type, i.e. has a specialisation
+template <class T, class = void>
+struct TraitsDefined : std::false_type {};
+
+template <class T>
+struct TraitsDefined<T, decltype(void(sizeof(T)))> : std::true_type {};
+
+// A class derived from a supported display does not inherit its traits
+class DerivedDigit : public NJU3711_7Segment {
+public:
+    DerivedDigit() : NJU3711_7Segment(2, 4, 7) {}
+};
+
+static_assert(TraitsDefined<NJU3711_DisplayTraits<NJU3711> >::value, "NJU3711 has traits");
+static_assert(TraitsDefined<NJU3711_DisplayTraits<NJU3711_7Segment> >::value, "NJU3711_7Segment has traits");
+static_assert(TraitsDefined<NJU3711_DisplayTraits<NJU3711_7Segment_Multi> >::value, "NJU3711_7Segment_Multi has traits");
+static_assert(TraitsDefined<NJU3711_DisplayTraits<RecorderDisplay> >::value, "NJU3711_SegmentRenderer has traits");
+static_assert(!TraitsDefined<NJU3711_DisplayTraits<int> >::value, "unsupported types have no traits");
+static_assert(!TraitsDefined<NJU3711_DisplayTraits<DerivedDigit> >::value, "derived classes need their own traits");
+
+static_assert(NJU3711_Display<NJU3711>::DIGITS == 1, "NJU3711 is one raw digit");
+static_assert(NJU3711_Display<NJU3711_7Segment>::DIGITS == 1, "NJU3711_7Segment is one digit");
+static_assert(NJU3711_Display<NJU3711_7Segment_Multi>::DIGITS == 3, "NJU3711_7Segment_Multi has three digits");
+static_assert(NJU3711_Display<RecorderDisplay>::DIGITS == 1, "NJU3711_SegmentRenderer is one digit");
+
+// The same signatures on every display, all resolved without virtual calls
+template <class Display>
+struct CheckView {
+    typedef NJU3711_Display<Display> View;
+
+    static_assert(!std::is_polymorphic<View>::value, "no vtable in the wrapper");
+    static_assert(!std::is_polymorphic<Display>::value, "no vtable in the display");
+    static_assert(sizeof(View) == sizeof(Display*), "the wrapper is one reference");
+    static_assert(std::is_same<decltype(std::declval<View&>().device()), Display&>::value,
+                  "device() is the concrete type");
+    static_assert(std::is_same<decltype(std::declval<View&>().update()), void>::value, "update()");
+    static_assert(std::is_same<decltype(std::declval<View&>().getTimeToNextEvent()), unsigned long>::value,
+                  "getTimeToNextEvent()");
+    static_assert(std::is_same<decltype(std::declval<View&>().isBusy()), bool>::value, "isBusy()");
+    static_assert(std::is_same<decltype(std::declval<View&>().showNumber(0)), bool>::value, "showNumber()");
+    static_assert(std::is_same<decltype(std::declval<View&>().showRaw(0, 0)), bool>::value, "showRaw()");
+    static_assert(std::is_same<decltype(std::declval<View&>().showError()), bool>::value, "showError()");
+    static_assert(std::is_same<decltype(std::declval<View&>().setDecimalPoint(0, true)), bool>::value,
+                  "setDecimalPoint()");
+    static_assert(std::is_same<decltype(std::declval<View&>().blank()), bool>::value, "blank()");
+    static_assert(std::is_same<decltype(NJU3711_makeDisplay(std::declval<Display&>())), View>::value,
+                  "NJU3711_makeDisplay() deduces the display type");
+};
+
+template struct CheckView<NJU3711>;
+template struct CheckView<NJU3711_7Segment>;
+template struct CheckView<NJU3711_7Segment_Multi>;
+template struct CheckView<RecorderDisplay>;
+
+// A user display with its own traits: records what reached it
+struct CustomDisplay {
+    int number;
+    uint8_t raw[4];
+    uint8_t dpMask;
+    unsigned long updates;
+
+    CustomDisplay() : number(-1), dpMask(0), updates(0) { memset(raw, 0, sizeof(raw)); }
+    void update() { updates++; }
+    unsigned long getTimeToNextEvent() { return NJU3711_NO_EVENT; }
+    bool isBusy() { return false; }
+};
+
+template <>
+struct NJU3711_DisplayTraits<CustomDisplay> {
+    static const uint8_t DIGITS = 4;
+
+    static bool showNumber(CustomDisplay& display, int value) { display.number = value; return true; }
+    static bool showRaw(CustomDisplay& display, uint8_t position, uint8_t pattern) {
+        if (position >= DIGITS) return false;
+        display.raw[position] = pattern;
+        return true;
+    }
+    static bool showError(CustomDisplay& display) { display.number = -1; return true; }
+    static bool setDecimalPoint(CustomDisplay& display, uint8_t position, bool state) {
+        if (position >= DIGITS) return false;
+        if (state) display.dpMask |= (1 << position); else display.dpMask &= ~(1 << position);
+        return true;
+    }
+    static bool blank(CustomDisplay& display) { memset(display.raw, 0, sizeof(display.raw)); return true; }
+};
+
+template struct CheckView<CustomDisplay>;
+static_assert(NJU3711_Display<CustomDisplay>::DIGITS == 4, "user traits set the digit count");
+
+// --- run time -------------------------------------------------------------
+
+static unsigned long failures;
+
+static void expect(bool condition, const char* display, const char* what) {
+    if (!condition) {
+        printf("traits: %s: %s\n", display, what);
+        failures++;
+    }
+}
+
+// Generic code as the wrapper is meant to be used: one template for all
+template <class Display>
+static void settle(NJU3711_Display<Display>& view) {
+    for (unsigned long n = 0; n < 10000 && view.isBusy(); n++) {
+        view.update();
+    }
+}
+
+template <class Display>
+static bool showEveryDigit(NJU3711_Display<Display>& view, uint8_t pattern) {
+    bool ok = true;
+    for (uint8_t position = 0; position < NJU3711_Display<Display>::DIGITS; position++) {
+        ok = view.showRaw(position, pattern) && ok;
+    }
+    settle(view);
+    return ok && !view.showRaw(NJU3711_Display<Display>::DIGITS, pattern);
+}
+
+static uint8_t latched() {
+    return hostBoard.buses[0].outputs;
+}
+
+static void checkExpander() {
+    const char* name = "NJU3711";
+    hostReset();
+    hostAddBus(2, 4, 7, 8);
+    NJU3711 device(2, 4, 7, 8);
+    device.begin();
+    NJU3711_Display<NJU3711> view(device);
+    settle(view);
+
+    expect(view.showNumber(0xA5), name, "showNumber(0xA5) refused");
+    settle(view);
+    expect(latched() == 0xA5, name, "showNumber() did not latch the byte");
+    expect(!view.showNumber(256) && !view.showNumber(-1), name, "showNumber() took a value outside a byte");
+    expect(showEveryDigit(view, 0x3C) && latched() == 0x3C, name, "showRaw() did not reach the outputs");
+    expect(!view.showError() && !view.setDecimalPoint(0, true), name, "error/DP claimed on a bare expander");
+    expect(view.blank(), name, "blank() refused");
+    settle(view);
+    expect(latched() == 0x00, name, "blank() did not clear the outputs");
+}
+
+static void checkDigit() {
+    const char* name = "NJU3711_7Segment";
+    hostReset();
+    hostAddBus(2, 4, 7);
+    NJU3711_7Segment display(2, 4, 7);
+    display.begin();
+    NJU3711_Display<NJU3711_7Segment> view(display);
+    settle(view);
+
+    expect(view.showNumber(7), name, "showNumber(7) refused");
+    settle(view);
+    expect(latched() == NJU3711_Font::applyMode(NJU3711_Font::digit(7), ACTIVE_LOW), name, "showNumber() shows the wrong digit");
+    view.showNumber(12);
+    settle(view);
+    expect(latched() == NJU3711_Font::applyMode(NJU3711_Font::PATTERN_ERROR, ACTIVE_LOW), name,
+           "showNumber() out of range does not show the error");
+    expect(view.setDecimalPoint(0, true) && !view.setDecimalPoint(1, true), name, "setDecimalPoint() positions");
+    settle(view);
+    expect(display.getDecimalPointState(), name, "setDecimalPoint() did not reach the digit");
+    expect(showEveryDigit(view, 0x92) && latched() == NJU3711_Font::applyMode(0x92, ACTIVE_LOW), name,
+           "showRaw() did not reach the outputs");
+    view.blank();
+    settle(view);
+    expect(latched() == NJU3711_Font::applyMode(NJU3711_Font::PATTERN_BLANK, ACTIVE_LOW), name, "blank()");
+
+#if NJU3711_ENABLE_ANIMATIONS
+    // NJU3711::update() alone would never step the animation
+    display.startAnimation(ANIM_ROTATE_CW, 10000);
+    unsigned long latches = hostBoard.buses[0].latches;
+    uint64_t end = hostBoard.clock.now() + 100000;
+    while (hostBoard.clock.now() < end) view.update();
+    expect(hostBoard.buses[0].latches - latches >= 8, name, "update() through the wrapper did not animate");
+#endif
+}
+
+static void checkMulti() {
+    const char* name = "NJU3711_7Segment_Multi";
+    hostReset();
+    hostAddBus(2, 4, 7);
+    hostAddDigit(9);
+    hostAddDigit(10);
+    hostAddDigit(12);
+    NJU3711_7Segment_Multi display(2, 4, 7, 9, 10, 12);
+    display.begin();
+    NJU3711_Display<NJU3711_7Segment_Multi> view(display);
+
+    expect(view.showNumber(123), name, "showNumber(123) refused");
+    NJU3711_Frame frame = display.getFrame();
+    expect(frame.segments[0] == NJU3711_Font::digit(3) && frame.segments[1] == NJU3711_Font::digit(2) &&
+           frame.segments[2] == NJU3711_Font::digit(1), name, "showNumber() digits are not rightmost first");
+
+    // NJU3711::update() alone would never scan the digits
+    uint64_t end = hostBoard.clock.now() + 100000;
+    while (hostBoard.clock.now() < end) view.update();
+    for (uint8_t d = 0; d < 3; d++) {
+        expect(hostBoard.digits[d].intervals > 5, name, "update() through the wrapper did not scan");
+    }
+    expect(hostBoard.digitOverlaps == 0, name, "two digits lit at once");
+
+    view.showNumber(-5);
+    frame = display.getFrame();
+    expect(frame.segments[2] == NJU3711_Font::PATTERN_MINUS && frame.segments[0] == NJU3711_Font::digit(5) &&
+           !(frame.enabledMask & 0x02), name, "showNumber(-5) is not \"- 5\"");
+    view.showNumber(1000);
+    frame = display.getFrame();
+    expect(frame.segments[0] == NJU3711_Font::PATTERN_ERROR || frame.segments[1] == NJU3711_Font::PATTERN_ERROR ||
+           frame.segments[2] == NJU3711_Font::PATTERN_ERROR, name, "showNumber() out of range does not show the error");
+
+    expect(view.setDecimalPoint(1, true), name, "setDecimalPoint(1) refused");
+    expect(display.getFrame().dpMask & 0x02, name, "setDecimalPoint() did not reach position 1");
+    expect(showEveryDigit(view, 0x6C), name, "showRaw() positions");
+    frame = display.getFrame();
+    expect(frame.segments[0] == 0x6C && frame.segments[1] == 0x6C && frame.segments[2] == 0x6C, name,
+           "showRaw() did not reach every digit");
+    view.blank();
+    expect(display.getFrame().enabledMask == 0, name, "blank() left digits enabled");
+}
+
+static void checkRenderer() {
+    const char* name = "NJU3711_SegmentRenderer";
+    hostReset();
+    NJU3711_RecorderSink<> sink;
+    RecorderDisplay display(sink);
+    NJU3711_Display<RecorderDisplay> view = NJU3711_makeDisplay(display);
+
+    expect(view.showNumber(4) && sink.last() == NJU3711_Font::applyMode(NJU3711_Font::digit(4), ACTIVE_LOW), name,
+           "showNumber() did not reach the sink");
+    expect(view.showError() && sink.last() == NJU3711_Font::applyMode(NJU3711_Font::PATTERN_ERROR, ACTIVE_LOW), name,
+           "showError() did not reach the sink");
+    expect(showEveryDigit(view, 0x18) && sink.last() == NJU3711_Font::applyMode(0x18, ACTIVE_LOW), name,
+           "showRaw() did not reach the sink");
+    expect(view.setDecimalPoint(0, true) && !view.setDecimalPoint(1, true), name, "setDecimalPoint() positions");
+    expect(view.blank() && sink.last() == NJU3711_Font::applyMode(NJU3711_Font::PATTERN_BLANK, ACTIVE_LOW), name,
+           "blank() did not reach the sink");
+}
+
+static void checkCustom() {
+    const char* name = "user traits";
+    CustomDisplay display;
+    NJU3711_Display<CustomDisplay> view(display);
+
+    expect(view.showNumber(4321) && display.number == 4321, name, "showNumber() did not reach the class");
+    expect(showEveryDigit(view, 0x55) && display.raw[3] == 0x55, name, "showRaw() did not reach every digit");
+    expect(view.setDecimalPoint(3, true) && display.dpMask == 0x08, name, "setDecimalPoint() did not reach the class");
+    view.update();
+    expect(display.updates == 1, name, "update() did not reach the class");
+}
+
+int main() {
+    checkExpander();
+    checkDigit();
+    checkMulti();
+    checkRenderer();
+    checkCustom();
+
+    if (failures > 0) return 1;
+    printf("traits: static checks built, dispatch checked on 4 display types and user traits\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * wcet_main.cpp - Worst-Case update() Cost Under Random Scenarios
+ *
+ * Linked with the library and the host Arduino stand-in by
+ * extras/host_checks.sh. For NJU3711, NJU3711_7Segment and
+ * NJU3711_7Segment_Multi it runs random scenarios: random calls from the
+ * whole API of the class (writes, test patterns, scrubbing, animations,
+ * brightness, segment budget, refresh policies, keypad, quiet window,
+ * ...), each followed by random update() calls with random gaps, starting
+ * just before the micros() rollover.
+ *
+ * Every update() is measured in pin writes, micros() reads and virtual
+ * time. The pin write and micros() counts must stay within the table in
+ * docs/Advanced_Usage.md ("Worst-Case update() Time"); the worst time is
+ * printed for comparison between runs.
+ *
+ * Usage: wcet [--seed N] [--runs N] [--calls N]
+ *
+ * Author: justdienow
+ * Version: 1.0
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "HostBoard.h"
+#include "NJU3711.h"
+#include "NJU3711_7Segment.h"
+#include "NJU3711_7Segment_Multi.h"
+
+// Documented bounds per update() call: pin writes, micros() reads
+struct WcetBound {
+    const char* name;
+    unsigned long pinWrites;
+    unsigned long microsReads;
+};
+
+#if NJU3711_ENABLE_LOAD_METER
+static const WcetBound bounds[3] = {
+    { "NJU3711", 2, 6 },
+    { "NJU3711_7Segment", 3, 10 },
+    { "NJU3711_7Segment_Multi", 6, 14 }
+};
+#else
+static const WcetBound bounds[3] = {
+    { "NJU3711", 2, 4 },
+    { "NJU3711_7Segment", 3, 5 },
+    { "NJU3711_7Segment_Multi", 6, 6 }
+};
+#endif
+
+// Worst update() seen for one class, and where
+struct WcetWorst {
+    unsigned long pinWrites;
+    unsigned long microsReads;
+    uint64_t micros;
+    uint32_t seed;
+    unsigned long call;
+};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    // xorshift32 - independent of the sketch-facing random()
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t randomBelow(uint32_t n) {
+    return nextRandom() % n;
+}
+
+static void quietWork() {}
+
+// Calls every class takes
+static void randomBusCall(NJU3711& device) {
+    uint8_t value = (uint8_t)nextRandom();
+    switch (randomBelow(10)) {
+        case 0: device.write(value); break;
+        case 1: device.setBit(value % 9); break;
+        case 2: device.toggleBit(value % 9); break;
+        case 3: device.shift(value); break;
+        case 4: device.latch(); break;
+        case 5: device.clear(); break;
+        case 6: device.clearQueue(); break;
+        case 7: device.startTestPattern(value % 6, randomBelow(20000)); break;
+        case 8: device.setStepDelay(randomBelow(40)); break;
+        default: device.setScrubInterval(randomBelow(3) == 0 ? 0 : randomBelow(30000)); break;
+    }
+}
+
+static void randomCall(NJU3711& device) {
+    randomBusCall(device);
+}
+
+static void randomCall(NJU3711_7Segment& display) {
+    uint8_t value = (uint8_t)nextRandom();
+    switch (randomBelow(12)) {
+        case 0: display.displayDigit(value % 12, value & 0x80); break;
+        case 1: display.displayRaw(value); break;
+        case 2: display.displayMinus(); break;
+        case 3: display.displayOff(); break;
+#if NJU3711_ENABLE_ANIMATIONS
+        case 4: display.startAnimation((AnimationType)(value % 6), randomBelow(20000)); break;
+        case 5: display.stopAnimation(); break;
+        case 6: display.countdown(value % 10, 0, randomBelow(20000)); break;
+        case 7: display.test(); break;
+#endif
+        case 8: display.displayOn(); break;
+        default: randomBusCall(display); break;
+    }
+}
+
+static void randomCall(NJU3711_7Segment_Multi& display) {
+    uint8_t value = (uint8_t)nextRandom();
+    switch (randomBelow(16)) {
+        case 0: display.displayNumber(randomBelow(1000), value % 4); break;
+        case 1: display.setDigitRaw(value % 3, (uint8_t)nextRandom(), value & 0x80); break;
+        case 2: display.clearDisplay(); break;
+        case 3: display.setMultiplexDelay(100 + randomBelow(4000)); break;
+        case 4: display.setBlankingTime(randomBelow(300)); break;
+        case 5: display.enableMultiplex(value % 4 != 0); break;
+#if NJU3711_ENABLE_DIMMING
+        case 6: display.setBrightness(value); break;
+        case 7: display.setDimmingMode((value & 1) ? NJU3711_DIM_SOFTWARE : NJU3711_DIM_AUTO); break;
+#endif
+#if NJU3711_ENABLE_SEGMENT_BUDGET
+        case 8: display.setSegmentBudget(value % 9); break;
+#endif
+#if NJU3711_ENABLE_ADAPTIVE_REFRESH
+        case 9: display.setRefreshPolicy((NJU3711_RefreshPolicy)(value % 3)); break;
+#endif
+#if NJU3711_ENABLE_KEYPAD
+        case 10:
+            if (value & 1) {
+                display.beginKeypad(18, value % 30);
+            } else {
+                display.endKeypad();
+            }
+            break;
+#endif
+#if NJU3711_ENABLE_QUIET_WINDOW
+        case 11: display.setQuietCallback((value & 1) ? quietWork : NULL, randomBelow(500)); break;
+#endif
+        case 12: display.displayAll(); break;
+        default: randomBusCall(display); break;
+    }
+}
+
+// One scenario on a fresh board: returns false if a bound was exceeded
+template <class Device>
+static bool runScenario(Device& device, const WcetBound& bound, WcetWorst& worst,
+                        uint32_t seed, unsigned long calls) {
+    device.begin();
+
+    for (unsigned long call = 0; call < calls; call++) {
+        randomCall(device);
+        unsigned long updates = randomBelow(randomBelow(8) == 0 ? 300 : 30);
+        unsigned long gap = randomBelow(randomBelow(6) == 0 ? 3000 : 60);
+
+        for (unsigned long n = 0; n < updates; n++) {
+            hostBoard.clock.advance(gap);
+            unsigned long writes = hostBoard.pinWrites;
+            unsigned long reads = hostBoard.microsReads;
+            uint64_t start = hostBoard.clock.now();
+
+            device.update();
+
+            writes = hostBoard.pinWrites - writes;
+            reads = hostBoard.microsReads - reads;
+            uint64_t spent = hostBoard.clock.now() - start;
+            if (writes > worst.pinWrites || reads > worst.microsReads || spent > worst.micros) {
+                if (writes > worst.pinWrites) worst.pinWrites = writes;
+                if (reads > worst.microsReads) worst.microsReads = reads;
+                if (spent > worst.micros) worst.micros = spent;
+                worst.seed = seed;
+                worst.call = call;
+            }
+            if (writes > bound.pinWrites || reads > bound.microsReads) {
+                printf("wcet: %s update() made %lu pin writes and %lu micros() reads (bound %lu, %lu)"
+                       " - seed %lu, after call %lu\n", bound.name, writes, reads, bound.pinWrites,
+                       bound.microsReads, (unsigned long)seed, call);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Start just before the micros() rollover where unsigned long is 32 bits
+// wide as on the board; on a 64-bit host the library would not wrap
+static uint64_t startTime(uint32_t seed) {
+    if (sizeof(unsigned long) != 4) return 1000;
+    return 0xFFFFFFFFULL - (seed % 2000000);
+}
+
+static void seedRun(uint32_t seed) {
+    rngState = seed * 2654435761UL + 1;
+    if (rngState == 0) rngState = 1;
+    hostReset(startTime(seed));
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = 1;
+    unsigned long runs = 200;
+    unsigned long calls = 200;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--runs") && hasValue) {
+            runs = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--calls") && hasValue) {
+            calls = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "wcet: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    WcetWorst worst[3];
+    memset(worst, 0, sizeof(worst));
+
+    for (unsigned long r = 0; r < runs; r++) {
+        uint32_t runSeed = seed + r;
+        bool ok;
+
+        seedRun(runSeed);
+        {
+            NJU3711 device(2, 4, 7, 8);
+            ok = runScenario(device, bounds[0], worst[0], runSeed, calls);
+        }
+        if (ok) {
+            seedRun(runSeed);
+            NJU3711_7Segment display(2, 4, 7);
+            ok = runScenario(display, bounds[1], worst[1], runSeed, calls);
+        }
+        if (ok) {
+            // Two digits on PWM pins, one without
+            seedRun(runSeed);
+            NJU3711_7Segment_Multi display(2, 4, 7, 8, 9, 10, 12);
+            ok = runScenario(display, bounds[2], worst[2], runSeed, calls);
+        }
+        if (!ok) return 1;
+    }
+
+    printf("wcet: %lu runs of %lu calls from seed %lu within bounds (load meter %s)\n",
+           runs, calls, (unsigned long)seed, NJU3711_ENABLE_LOAD_METER ? "on" : "off");
+    for (uint8_t i = 0; i < 3; i++) {
+        printf("  %-24s pin writes %lu/%lu  micros() %2lu/%-2lu  worst %3lu us (seed %lu, call %lu)\n",
+               bounds[i].name, worst[i].pinWrites, bounds[i].pinWrites, worst[i].microsReads,
+               bounds[i].microsReads, (unsigned long)worst[i].micros, (unsigned long)worst[i].seed,
+               worst[i].call);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# host_checks.sh - Builds and runs the host checks in extras/host
+#
+# Each check is a program extras/host/<name>_main.cpp, built with the
+# library and the host Arduino stand-in. It runs on virtual time, prints
+# one summary line and exits non-zero when an invariant fails, after
+# printing what failed.
+#
+#   fuzz    random call sequences on three devices against the traced
+#           pins; a failing sequence is shrunk before it is printed
+#   wcet    random scenarios per class against the documented worst-case
+#           pin writes and micros() reads of one update()
+#   soak    hours of virtual time on a test pattern, an animation, a clock
+#           and keys on a blank display, with invariants checked after
+#           every update()
+#   handoff frames published from the main thread while a refresh thread
+#           scans them; every scan must show one whole frame
+#   rtos    NJU3711_RTOSTask on a FreeRTOS stand-in (extras/host/freertos)
+#           at several tick rates; every sleep against getTimeToNextEvent()
+#   traits  NJU3711_Display over every supported display: static_asserts on
+#           the traits, then each call checked on the pins, frame or sink
+#
+# Usage: extras/host_checks.sh [check [arguments...]]
+#   Without a check, every check runs with its default arguments. Set CXX
+#   or HOST_CXXFLAGS to change the host compiler (the default -m32 gives
+#   the board's 32-bit long, so micros() differences wrap as on the board).
+#
+# Author: justdienow
+# Version: 1.0
+
+CXX=${CXX:-g++}
+HOST_CXXFLAGS=${HOST_CXXFLAGS:--m32}
+LIBDIR=$(cd "$(dirname "$0")/.." && pwd)
+HOSTDIR="$LIBDIR/extras/host"
+BUILDDIR=${TMPDIR:-/tmp}/nju3711_checks
+CHECKS="fuzz wcet soak handoff rtos traits"
+
+mkdir -p "$BUILDDIR" || exit 1
+
+# Build and run one check, passing on its arguments
+run_check() {
+    name=$1
+    shift
+    # shellcheck disable=SC2086
+    if ! "$CXX" $HOST_CXXFLAGS -O2 -std=gnu++11 -Wall -Wextra -pthread -I"$HOSTDIR" -I"$LIBDIR" \
+            -o "$BUILDDIR/$name" "$HOSTDIR/${name}_main.cpp" "$HOSTDIR/Arduino.cpp" "$LIBDIR"/*.cpp -lm \
+            > "$BUILDDIR/$name.log" 2>&1; then
+        echo "$name: build failed (see $BUILDDIR/$name.log)"
+        return 1
+    fi
+    "$BUILDDIR/$name" "$@"
+}
+
+if [ $# -gt 0 ]; then
+    run_check "$@"
+    exit $?
+fi
+
+failed=0
+for name in $CHECKS; do
+    run_check "$name" || failed=$((failed + 1))
+done
+[ "$failed" -eq 0 ]